@@ -0,0 +1,93 @@
+#include <cstdio>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include "fft.h"
+#include "simd.h"
+
+// Times each FFT backend (and each SIMD level of the radix-4 engine) on real input of every
+// power-of-two size from 1024 to 65536, with error against a double-precision DFT of the same
+// input. Exits non-zero if a backend drifts past tolerance.
+
+static volatile float sink;
+
+template<typename F> static double timeNs(F fn) {
+    using clk = std::chrono::steady_clock;
+    long reps = 0; auto st = clk::now(); double ns = 0;
+    while(ns < 5e7) {
+        for(int i = 0; i < 8; i++) fn();
+        reps += 8;
+        ns = std::chrono::duration<double, std::nano>(clk::now()-st).count();
+    }
+    return ns/reps;
+}
+
+// reference spectrum by a double-precision radix-2 FFT
+static void referenceDft(const std::vector<float>& x, std::vector<double>& re, std::vector<double>& im) {
+    const int n = x.size();
+    re.assign(x.begin(), x.end()); im.assign(n, 0.);
+    for(int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for(; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if(i < j) { std::swap(re[i], re[j]); std::swap(im[i], im[j]); }
+    }
+    for(int len = 2; len <= n; len <<= 1) {
+        for(int i = 0; i < n; i += len) {
+            for(int k = 0; k < len/2; k++) {
+                const double wr = std::cos(-2*M_PI*k/len), wi = std::sin(-2*M_PI*k/len);
+                const double ur = re[i+k], ui = im[i+k];
+                const double vr = re[i+k+len/2]*wr - im[i+k+len/2]*wi, vi = re[i+k+len/2]*wi + im[i+k+len/2]*wr;
+                re[i+k] = ur + vr; im[i+k] = ui + vi;
+                re[i+k+len/2] = ur - vr; im[i+k+len/2] = ui - vi;
+            }
+        }
+    }
+}
+
+int main() {
+    const SimdLevel best = detectSimdLevel();
+    const double tol = 1e-5;
+    bool ok = true;
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> u(-1, 1);
+
+    printf("%6s %-22s %12s %10s %8s %10s\n", "n", "backend", "us/fft", "ns/point", "speedup", "rel err");
+    for(int n = 1024; n <= 65536; n *= 2) {
+        std::vector<float> x(n), scratch(fftScratchFloats(n));
+        std::vector<kiss_fft_cpx> out(n/2+1);
+        for(auto& v : x) v = u(rng);
+        std::vector<double> re, im;
+        referenceDft(x, re, im);
+        double peak = 0;
+        for(int k = 0; k <= n/2; k++) peak = std::max(peak, std::hypot(re[k], im[k]));
+
+        auto run = [&](FftBackend backend, SimdLevel level, const char* name, double& base) {
+            setSimdLevel(level);
+            const FftPlan* plan = getFftPlan(backend, n);
+            const double ns = timeNs([&] { fftReal(plan, x.data(), out.data(), scratch.data()); sink = out[n/4].r; });
+            double err = 0;
+            for(int k = 0; k <= n/2; k++) err = std::max(err, std::hypot(out[k].r - re[k], out[k].i - im[k]));
+            err /= peak;
+            if(base == 0) base = ns;
+            printf("%6d %-22s %12.2f %10.3f %7.2fx %10.2e\n", n, name, ns/1e3, ns/n, base/ns, err);
+            if(err > tol) ok = false;
+        };
+
+        double base = 0;
+        run(FftBackend::Kiss, best, "KissFFT", base);
+        for(int l = 0; l <= (int)best; l++) {
+            char name[64];
+            snprintf(name, sizeof(name), "Radix-4 %s", simdLevelNames[l]);
+            run(FftBackend::Radix4, (SimdLevel)l, name, base);
+        }
+        setSimdLevel(best);
+        printf("\n");
+    }
+
+    if(!ok) fprintf(stderr, "fft results exceed relative tolerance %.0e\n", tol);
+    return ok ? 0 : 1;
+}
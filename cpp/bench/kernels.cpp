@@ -0,0 +1,336 @@
+#include <cstdio>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include "chord.h"
+#include "simd.h"
+#include "hps.h"
+#include "multistream.h"
+#include "minmax.h"
+
+// Times every computeChord kernel at each SIMD level the CPU supports against the scalar
+// table, and checks the results agree. Exits non-zero when a level drifts past tolerance.
+// The HPS is also timed on its own and as its share of a whole job, and the label smoother
+// per hop with the latency it adds at the default 1024-sample hop. Then the scoring of a frame
+// is timed against vocabulary size. Then the callback's channel deinterleave per level, and
+// the per-stream cost of multi-stream analysis as streams are added. Last, the waveform plot's
+// min/max pyramid: its cost per pushed buffer, and reading a history for a 1000-pixel plot
+// against the raw points it replaces, checked against a brute-force envelope. Last, chroma and
+// scoring through the kernels compiled per configuration (specialized.h) against the generic
+// filterbank and GEMV, checked to give the same chroma and label.
+
+static volatile float sink;
+
+// ns per call of fn, repeated until ~20 ms have passed
+template<typename F> static double timeNs(F fn) {
+    using clk = std::chrono::steady_clock;
+    long reps = 0; auto st = clk::now(); double ns = 0;
+    while(ns < 2e7) {
+        for(int i = 0; i < 64; i++) fn();
+        reps += 64;
+        ns = std::chrono::duration<double, std::nano>(clk::now()-st).count();
+    }
+    return ns/reps;
+}
+
+// chroma as computeChord derived it before the filterbank: band edges recomputed every job
+static void chromaBandWalk(const float* spec, float* chroma, int n, float sampleRate, int octaves) {
+    const float qrat = 1.02930223664349F;
+    const int highPassBin = freq2Bin(50, sampleRate, n);
+    float mid = midi2Freq(60);
+    for(int p = 0; p < 12; p++) {
+        float lbf = mid/qrat, ubf = mid*qrat;
+        chroma[p] = 1;
+        for(int r = 0; r < octaves; r++) {
+            const int lbi = freq2Bin(lbf, sampleRate, n), ubi = std::min(freq2Bin(ubf, sampleRate, n), n/2);
+            float sm = 0; for(int j = std::max(lbi, highPassBin); j <= ubi; j++) sm += spec[j];
+            chroma[p] *= sm/(ubi-lbi+1);
+            lbf *= 2.F; ubf *= 2.F;
+        }
+        mid *= qrat*qrat;
+    }
+}
+
+static double relErr(float x, float ref) {
+    return std::fabs(x-ref)/std::max(std::fabs(ref), 1e-30f);
+}
+
+// log2 values cross zero, so compare them relative to at least one
+static double logErr(float x, float ref) {
+    return std::fabs(x-ref)/std::max(std::fabs(ref), 1.f);
+}
+
+int main() {
+    const SimdLevel best = detectSimdLevel();
+    const double tol = 1e-5;
+    bool ok = true;
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> u(-1, 1);
+
+    printf("best supported: %s\n\n", simdLevelNames[(int)best]);
+    printf("%-14s %6s %-8s %12s %8s %10s\n", "kernel", "n", "level", "ns/call", "speedup", "max rel err");
+
+    for(int n : {1024, 4096, 16384, 65536}) {
+        const int bins = n/2+1;
+        std::vector<kiss_fft_cpx> x(bins);
+        for(auto& c : x) { c.r = u(rng); c.i = u(rng); }
+        std::vector<float> spec(bins), ref(bins);
+        std::vector<float> a(24*12), v(12), y(24), yRef(24);
+        for(auto& e : a) e = u(rng)*u(rng) > 0 ? 1.f/3 : 0.f;
+        for(auto& e : v) e = std::fabs(u(rng));
+
+        const SimdKernels& s = simdKernels(SimdLevel::Scalar);
+        s.powerSpectrum(ref.data(), x.data(), bins);
+        const float sumRef = s.sumRange(ref.data(), 3, bins), maxRef = s.maxRange(ref.data(), 3, bins);
+        s.matVec(yRef.data(), a.data(), 24, 12, v.data());
+        std::vector<float> logs(bins), logRef(bins), hm(bins), hmRef(bins);
+        s.log2Range(logRef.data(), ref.data(), bins, hpsFloor);
+        double libmErr = 0; // the scalar polynomial against libm
+        for(int i = 0; i < bins; i++) libmErr = std::max(libmErr, logErr(logRef[i], std::log2(std::max(ref[i], hpsFloor))));
+        if(libmErr > tol) ok = false;
+        const int hmCount = (bins-1)/5 + 1;
+        hmRef = logRef; s.harmonicMean(hmRef.data(), hmCount, 5);
+        double base[6] = {0};
+
+        for(int l = 0; l <= (int)best; l++) {
+            const SimdKernels& k = simdKernels((SimdLevel)l);
+            double err[6] = {0}, ns[6];
+            ns[0] = timeNs([&] { k.powerSpectrum(spec.data(), x.data(), bins); sink = spec[bins/2]; });
+            for(int i = 0; i < bins; i++) err[0] = std::max(err[0], relErr(spec[i], ref[i]));
+            ns[1] = timeNs([&] { sink = k.sumRange(ref.data(), 3, bins); });
+            err[1] = relErr(k.sumRange(ref.data(), 3, bins), sumRef);
+            ns[2] = timeNs([&] { sink = k.maxRange(ref.data(), 3, bins); });
+            err[2] = relErr(k.maxRange(ref.data(), 3, bins), maxRef);
+            ns[3] = timeNs([&] { k.matVec(y.data(), a.data(), 24, 12, v.data()); sink = y[5]; });
+            for(int i = 0; i < 24; i++) err[3] = std::max(err[3], relErr(y[i], yRef[i]));
+            ns[4] = timeNs([&] { k.log2Range(logs.data(), ref.data(), bins, hpsFloor); sink = logs[bins/2]; });
+            for(int i = 0; i < bins; i++) err[4] = std::max(err[4], logErr(logs[i], logRef[i]));
+            ns[5] = timeNs([&] { hm = logRef; k.harmonicMean(hm.data(), hmCount, 5); sink = hm[3]; });
+            for(int i = 0; i < hmCount; i++) err[5] = std::max(err[5], logErr(hm[i], hmRef[i]));
+
+            const char* names[6] = {"powerSpectrum", "sumRange", "maxRange", "matVec 24x12", "log2Range", "harmonicMean 5"};
+            for(int j = 0; j < 6; j++) {
+                if(l == 0) base[j] = ns[j];
+                printf("%-14s %6d %-8s %12.1f %7.2fx %10.2e\n", names[j], n, simdLevelNames[l], ns[j], base[j]/ns[j], err[j]);
+                if(err[j] > tol) ok = false;
+            }
+        }
+        printf("%-14s %6d %-8s %12s %8s %10.2e\n", "log2 vs libm", n, "Scalar", "", "", libmErr);
+
+        // chroma from a spectrum: the old per-job band walk against the cached filterbank
+        for(int octaves : {4, 8}) {
+            ChromaFilterbank fb;
+            buildChromaFilterbank(fb, n, 44100, octaves, ChromaShape::Box);
+            float chroma[12], chromaRef[12];
+            chromaBandWalk(ref.data(), chromaRef, n, 44100, octaves);
+            const double walk = timeNs([&] { chromaBandWalk(ref.data(), chroma, n, 44100, octaves); sink = chroma[3]; });
+            printf("%-11s O=%d %6d %-8s %12.1f %7.2fx\n", "band walk", octaves, n, "Scalar", walk, 1.);
+            for(int l = 0; l <= (int)best; l++) {
+                setSimdLevel((SimdLevel)l);
+                double ns = timeNs([&] { applyChromaFilterbank(fb, ref.data(), chroma); sink = chroma[3]; });
+                double err = 0;
+                for(int p = 0; p < 12; p++) err = std::max(err, relErr(chroma[p], chromaRef[p]));
+                printf("%-11s O=%d %6d %-8s %12.1f %7.2fx %10.2e\n", "filterbank", octaves, n, simdLevelNames[l], ns, walk/ns, err);
+                if(err > tol*octaves) ok = false; // products of band means compound the rounding
+            }
+            setSimdLevel(best);
+        }
+
+        // the whole job, where the kernels share time with the FFT and the sort
+        std::vector<float> samples(n);
+        for(int i = 0; i < n; i++) samples[i] = 0.3f*std::sin(2*M_PI*261.63*i/44100.) + 0.05f*u(rng);
+        for(int harmonics : {3, 5}) {
+            std::vector<float> hps(bins);
+            double hpsBase = 0;
+            for(int l = 0; l <= (int)best; l++) {
+                setSimdLevel((SimdLevel)l);
+                double ns = timeNs([&] { sink = computeHps(hps.data(), ref.data(), n, 44100, harmonics, 1); });
+                if(l == 0) hpsBase = ns;
+                printf("%-11s H=%d %6d %-8s %12.1f %7.2fx\n", "computeHps", harmonics, n, simdLevelNames[l], ns, hpsBase/ns);
+            }
+            setSimdLevel(best);
+        }
+        for(int octaves : {4, 8}) {
+            ChordConfig cfg = initChordConfig(n, 44100, octaves, 0.016f);
+            ChordComputeData* data = initChordComputeData(n, chordStateCount(cfg));
+            double jobBase = 0, jobBest = 0;
+            for(int l = 0; l <= (int)best; l++) {
+                setSimdLevel((SimdLevel)l);
+                double ns = jobBest = timeNs([&] { computeChord(*data, samples.data(), cfg); });
+                if(l == 0) jobBase = ns;
+                printf("%-11s O=%d %6d %-8s %12.1f %7.2fx\n", "computeChord", octaves, n, simdLevelNames[l], ns, jobBase/ns);
+            }
+            setSimdLevel(best);
+            cfg.hpsHarmonics = 0;
+            const double noHps = timeNs([&] { computeChord(*data, samples.data(), cfg); });
+            printf("%-11s O=%d %6d %-8s %12.1f %7s (HPS share %.0f%%)\n", "  w/o HPS", octaves, n, simdLevelNames[(int)best], noHps, "", 100*(1 - noHps/jobBest));
+            freeChordComputeData(data);
+            freeChordConfig(cfg);
+        }
+        printf("\n");
+    }
+
+    // fixed-lag Viterbi over the chord states, fed random frames of log scores
+    const int chordStates = 25;
+    std::vector<float> emissions(64*chordStates), trans(chordStates*chordStates);
+    for(auto& e : emissions) e = std::log2(std::fabs(u(rng)) + 1e-6f);
+    fillStayTransitions(trans.data(), chordStates, 0.9f);
+    printf("%-14s %6s %12s %12s\n", "smoother", "lag", "ns/hop", "latency ms");
+    for(int lag : {0, 4, 8, 16, 32}) {
+        FixedLagViterbi* v = initViterbi(chordStates, lag, trans.data());
+        int frame = 0;
+        const double ns = timeNs([&] { sink = stepViterbi(*v, &emissions[(frame++ % 64)*chordStates]); });
+        printf("%-14s %6d %12.1f %12.1f\n", "viterbi", lag, ns, 1e3*lag*1024/44100.);
+        freeViterbi(v);
+    }
+
+    // spectrum to label at n = 8192 for growing vocabularies of random 3-6 note qualities
+    printf("\n%-14s %6s %12s %12s\n", "vocabulary", "chords", "ns/frame", "smoothed");
+    {
+        const int n = 8192;
+        std::vector<float> samples(n);
+        for(int i = 0; i < n; i++) samples[i] = 0.3f*std::sin(2*M_PI*261.63*i/44100.) + 0.2f*std::sin(2*M_PI*392.*i/44100.) + 0.05f*u(rng);
+        ChordVocabulary vocab;
+        defaultChordVocabulary(vocab);
+        std::uniform_int_distribution<int> note(1, 11), size(2, 5);
+        for(int qualities : {2, 8, 32, 64}) {
+            while((int)vocab.qualities.size() < qualities) {
+                int iv[6] = {0}; const int k = size(rng);
+                for(int j = 1; j <= k; j++) iv[j] = note(rng);
+                std::string error;
+                addChordQuality(vocab, "q" + std::to_string(vocab.qualities.size()), iv, k+1, error);
+            }
+            ChordConfig cfg = initChordConfig(n, 44100, 4, 0.016f);
+            setChordVocabulary(cfg, vocab);
+            ChordComputeData* data = initChordComputeData(n, chordStateCount(cfg));
+            computeChord(*data, samples.data(), cfg);
+            const double raw = timeNs([&] { computeChordFromSpectrum(*data, cfg); });
+            setChordSmoothing(cfg, 8, nullptr);
+            const double smoothed = timeNs([&] { computeChordFromSpectrum(*data, cfg); });
+            printf("%-14s %6d %12.1f %12.1f\n", "", vocab.chords, raw, smoothed);
+            freeChordComputeData(data);
+            freeChordConfig(cfg);
+        }
+    }
+
+    // cost the analysis thread pays per traced frame: top-k selection plus the ring push
+    printf("\n%-14s %6s %12s %12s\n", "event log", "chords", "ns/frame", "dropped");
+    {
+        ChordVocabulary vocab;
+        defaultChordVocabulary(vocab);
+        std::vector<float> scores(vocab.chords);
+        std::vector<int> order(vocab.chords);
+        for(auto& v : scores) v = u(rng);
+        EventLog* log = openEventLog("/dev/null", EventLevel::Frames, EventFormat::JsonLines, vocab);
+        if(log) {
+            long pushes = 0;
+            const double ns = timeNs([&] {
+                ChordEvent ev;
+                ev.label = ev.raw = pushes++ % vocab.chords;
+                selectTopChords(ev, scores.data(), vocab.chords, order.data());
+                logChordEvent(*log, ev);
+            });
+            printf("%-14s %6d %12.1f %11.2f%%\n", "", vocab.chords, ns, 100.*log->dropped.load()/pushes);
+            log->dropped = 0; // expected at this rate, keep close quiet
+            closeEventLog(log);
+        }
+    }
+
+    // one 1024-frame callback buffer split into planes; must match the scalar copy exactly
+    printf("\n%-14s %6s %-8s %12s %8s\n", "deinterleave", "chans", "level", "ns/buffer", "speedup");
+    for(int channels : {2, 4, 8, 16}) {
+        const long frames = 1024;
+        std::vector<float> in(channels*frames), planes(channels*frames), ref(channels*frames);
+        for(auto& v : in) v = u(rng);
+        std::vector<float*> outs(channels), refs(channels);
+        for(int c = 0; c < channels; c++) { outs[c] = &planes[c*frames]; refs[c] = &ref[c*frames]; }
+        simdKernels(SimdLevel::Scalar).deinterleave(refs.data(), in.data(), channels, frames);
+        double base = 0;
+        for(int l = 0; l <= (int)best; l++) {
+            const SimdKernels& k = simdKernels((SimdLevel)l);
+            const double ns = timeNs([&] { k.deinterleave(outs.data(), in.data(), channels, frames); sink = planes[0]; });
+            if(l == 0) base = ns;
+            if(planes != ref) { ok = false; fprintf(stderr, "deinterleave %s differs at %d channels\n", simdLevelNames[l], channels); }
+            printf("%-14s %6d %-8s %12.1f %7.2fx\n", "", channels, simdLevelNames[l], ns, base/ns);
+        }
+    }
+
+    // per stream and hop should stay flat while streams <= workers, then grow with streams/workers
+    printf("\n%-14s %6s %12s %12s\n", "streams", "count", "ns/hop", "ns/stream");
+    {
+        const int n = 8192, hop = 1024;
+        ChordConfig proto = initChordConfig(n, 44100, 4, 0.016f);
+        std::vector<float> x(hop*8);
+        for(auto& v : x) v = u(rng);
+        for(int streams : {1, 2, 4, 8}) {
+            MultiStreamAnalyzer m = initMultiStreamAnalyzer(streams, 0, hop, proto);
+            std::vector<StreamBlock> blocks(streams);
+            for(auto& b : blocks) { b.parts[0] = x.data(); b.counts[0] = x.size(); }
+            const double ns = timeNs([&] { analyzeStreams(m, blocks.data()); })/8;
+            printf("%-14s %6d %12.1f %12.1f\n", "", streams, ns, ns/streams);
+            freeMultiStreamAnalyzer(m);
+        }
+        freeChordConfig(proto);
+    }
+
+    printf("\n%-14s %8s %12s %12s %10s\n", "min/max", "history", "ns/push", "ns/read", "points");
+    for(long history : {1L << 18, 1L << 21, 1L << 23}) {
+        const long buffer = 1024, pixels = 1000;
+        MinMaxPyramid p;
+        initMinMaxPyramid(p, history);
+        std::vector<float> x(history + 3*buffer/2 + 3), out(4*pixels + 8); // ends mid-bucket
+        for(auto& v : x) v = u(rng);
+        const double push = timeNs([&] { pushMinMaxPyramid(p, x.data(), buffer); });
+        const double read = timeNs([&] { sink = out[readMinMaxPyramid(p, history, 2*pixels, out.data()).values-1]; });
+        // push x again, whole, and compare every bucket inside the history with its samples
+        const long size = x.size();
+        for(long i = 0; i < size; i += buffer) pushMinMaxPyramid(p, &x[i], std::min(buffer, size - i));
+        const MinMaxSpan span = readMinMaxPyramid(p, history, 2*pixels, out.data());
+        for(long v = 0; v < span.values; v += 2) {
+            const long s0 = size - span.offset + v/2*span.bucket, s1 = std::min(size, s0 + span.bucket);
+            if(s0 < size - history) continue; // straddles the start
+            if(out[v] != *std::min_element(&x[s0], &x[s1]) || out[v+1] != *std::max_element(&x[s0], &x[s1])) {
+                ok = false; fprintf(stderr, "min/max bucket %ld of %ld differs\n", v/2, history); break;
+            }
+        }
+        printf("%-14s %8ld %12.1f %12.1f %4ld/%-6ld\n", "", history, push, read, span.values, history);
+    }
+
+    // spectrum to scores without the HPS, which both paths share
+    printf("\n%-14s %6s %2s %6s %12s %12s %8s\n", "specialized", "n", "O", "rate", "generic ns", "fixed ns", "speedup");
+    for(int rate : {44100, 48000}) {
+        for(int n : {2048, 4096, 8192, 16384}) {
+            std::vector<float> samples(n);
+            for(int i = 0; i < n; i++) samples[i] = 0.3f*std::sin(2*M_PI*261.63*i/rate) + 0.2f*std::sin(2*M_PI*329.63*i/rate) + 0.2f*std::sin(2*M_PI*392.*i/rate) + 0.05f*u(rng);
+            for(int octaves = 1; octaves <= 6; octaves++) {
+                ChordConfig cfg = initChordConfig(n, rate, octaves, 0.016f);
+                cfg.hpsHarmonics = 0;
+                ChordComputeData* data = initChordComputeData(n, chordStateCount(cfg));
+                computeChord(*data, samples.data(), cfg);
+                const SpecializedChroma* fixedChroma = cfg.fixedChroma;
+                const SpecializedScores* fixedScores = cfg.fixedScores;
+                if(!fixedChroma || !fixedScores) { ok = false; fprintf(stderr, "no specialized kernel for n=%d O=%d %d Hz\n", n, octaves, rate); }
+                float chroma[12];
+                std::copy(data->chroma, data->chroma + 12, chroma);
+                const int label = data->label;
+                cfg.fixedChroma = nullptr; cfg.fixedScores = nullptr;
+                const double generic = timeNs([&] { computeChordFromSpectrum(*data, cfg); });
+                for(int p = 0; p < 12; p++) {
+                    if(relErr(chroma[p], data->chroma[p]) > tol) { ok = false; fprintf(stderr, "specialized chroma %d differs at n=%d O=%d %d Hz\n", p, n, octaves, rate); break; }
+                }
+                if(label != data->label) { ok = false; fprintf(stderr, "specialized label differs at n=%d O=%d %d Hz\n", n, octaves, rate); }
+                cfg.fixedChroma = fixedChroma; cfg.fixedScores = fixedScores;
+                const double fixed = timeNs([&] { computeChordFromSpectrum(*data, cfg); });
+                printf("%-14s %6d %2d %6d %12.1f %12.1f %7.2fx\n", "", n, octaves, rate, generic, fixed, generic/fixed);
+                freeChordComputeData(data);
+                freeChordConfig(cfg);
+            }
+        }
+    }
+
+    if(!ok) fprintf(stderr, "kernel results exceed relative tolerance %.0e\n", tol);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,310 @@
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+
+#include "chord.h"
+#include "simd.h"
+#include "hps.h"
+#include "alloccount.h"
+
+// Regression suite for the analysis pipeline: every stage of computeChord, and the whole job
+// with the FFT and multirate front ends, over a grid of window sizes, octave counts and
+// sample rates, on synthetic C major chords.
+// Reports ns/op (best of 1 ms slices), heap allocations per op after warm-up, throughput, and
+// for the whole job the label and how many real-time streams one core could keep up with at
+// a 1024-sample hop. With --baseline, each case is compared against a stored run and the exit
+// code is non-zero when one got slower than the tolerance (on three measurements in a row) and
+// by more than the floor, allocates more, or changed label. Each case is timed next to a fixed
+// reference job that doesn't touch chordy's code, and the baseline is scaled by how much slower
+// that reference runs now, so a busy or down-clocked machine doesn't read as a regression.
+// Baselines are per SIMD level.
+
+static volatile float sink;
+
+struct BenchOptions {
+    std::string filter;
+    double minTimeMs = 30;
+    std::string jsonPath, baselinePath;
+    double tolerance = 0.4;
+    double floorNs = 500;
+};
+
+struct BenchResult {
+    std::string name;
+    double ns = 0, allocs = 0;
+    double referenceNs = 0; // the reference job, timed right before the case
+    double realtime = 0; // streams per core at a 1024-sample hop, whole job only
+    std::string label;
+};
+
+static void usage() {
+    fprintf(stderr,
+        "usage: chordy-bench-pipeline [options]\n"
+        "  --filter S        only run cases whose name contains S\n"
+        "  --min-time MS     time spent per case (default: 30)\n"
+        "  --json PATH       write the results as JSON (use as a later --baseline)\n"
+        "  --baseline PATH   compare against a stored run, exit 1 on regressions\n"
+        "  --tolerance F     allowed slowdown before a case is flagged (default: 0.4)\n"
+        "  --floor NS        slowdowns smaller than this many ns/op are never flagged (default: 500)\n"
+        "  --simd LEVEL      cap the kernels at scalar|sse2|avx2|avx512\n");
+}
+
+static bool parseArgs(int argc, char** argv, BenchOptions& o) {
+    for(int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        auto next = [&]() -> const char* { return i+1 < argc ? argv[++i] : nullptr; };
+        const char* v = nullptr;
+        if(a == "--filter" && (v = next())) o.filter = v;
+        else if(a == "--min-time" && (v = next())) o.minTimeMs = atof(v);
+        else if(a == "--json" && (v = next())) o.jsonPath = v;
+        else if(a == "--baseline" && (v = next())) o.baselinePath = v;
+        else if(a == "--tolerance" && (v = next())) o.tolerance = atof(v);
+        else if(a == "--floor" && (v = next())) o.floorNs = atof(v);
+        else if(a == "--simd" && (v = next())) {
+            if(!strcmp(v, "scalar")) setSimdLevel(SimdLevel::Scalar);
+            else if(!strcmp(v, "sse2")) setSimdLevel(SimdLevel::Sse2);
+            else if(!strcmp(v, "avx2")) setSimdLevel(SimdLevel::Avx2);
+            else if(!strcmp(v, "avx512")) setSimdLevel(SimdLevel::Avx512);
+            else { fprintf(stderr, "unknown simd level %s\n", v); return false; }
+        }
+        else { usage(); return false; }
+    }
+    return o.minTimeMs > 0 && o.tolerance >= 0 && o.floorNs >= 0;
+}
+
+// Lines of a JSON file this tool wrote, one result per line; anything else is skipped.
+static bool readBaseline(const std::string& path, std::vector<BenchResult>& out) {
+    FILE* f = fopen(path.c_str(), "r");
+    if(f == nullptr) return false;
+    char line[1024];
+    while(fgets(line, sizeof(line), f)) {
+        char name[256];
+        BenchResult r;
+        if(sscanf(line, " {\"name\": \"%255[^\"]\", \"ns_per_op\": %lf, \"allocs_per_op\": %lf", name, &r.ns, &r.allocs) != 3) continue;
+        r.name = name;
+        if(const char* ref = strstr(line, "\"reference_ns\": ")) r.referenceNs = atof(ref + strlen("\"reference_ns\": "));
+        if(const char* l = strstr(line, "\"label\": \"")) {
+            l += strlen("\"label\": \"");
+            r.label.assign(l, strcspn(l, "\""));
+        }
+        out.push_back(r);
+    }
+    fclose(f);
+    return true;
+}
+
+static void writeJson(const std::string& path, const std::vector<BenchResult>& results) {
+    FILE* f = fopen(path.c_str(), "w");
+    if(f == nullptr) { perror(path.c_str()); return; }
+    fprintf(f, "{\n  \"simd\": \"%s\",\n  \"results\": [\n", simdLevelNames[(int)activeSimdLevel()]);
+    for(size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        fprintf(f, "    {\"name\": \"%s\", \"ns_per_op\": %.1f, \"allocs_per_op\": %.2f, \"ops_per_s\": %.0f, \"reference_ns\": %.1f", r.name.c_str(), r.ns, r.allocs, 1e9/r.ns, r.referenceNs);
+        if(!r.label.empty()) fprintf(f, ", \"realtime_streams\": %.1f, \"label\": \"%s\"", r.realtime, r.label.c_str());
+        fprintf(f, "}%s\n", i+1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+}
+
+// C major triad with three decaying harmonics per note, over a little noise
+static std::vector<float> chordSignal(int n, float sampleRate, std::mt19937& rng) {
+    std::uniform_real_distribution<float> u(-1, 1);
+    const float notes[3] = {261.63f, 329.63f, 392.f};
+    std::vector<float> x(n);
+    for(int i = 0; i < n; i++) {
+        float s = 0.02f*u(rng);
+        for(float f : notes) {
+            for(int h = 1; h <= 3; h++) s += 0.2f/h*std::sin(2*M_PI*f*h*i/sampleRate);
+        }
+        x[i] = s;
+    }
+    return x;
+}
+
+// The reference job: multiply-adds streamed over a 64 KiB buffer, vectorized and bound by
+// throughput like the pipeline's kernels, and in this file so no change to chordy can move it.
+static float referenceJob(std::vector<float>& buf) {
+    float acc[8] = {};
+    for(size_t i = 0; i + 8 <= buf.size(); i += 8) {
+        for(int l = 0; l < 8; l++) {
+            buf[i+l] = buf[i+l]*0.999f + 0.001f;
+            acc[l] += buf[i+l]*buf[i+l];
+        }
+    }
+    return acc[0] + acc[7];
+}
+
+// ns per call of fn over one stretch of about ms
+template<typename F>
+static double timeSliceNs(F&& fn, double ms) {
+    using clk = std::chrono::steady_clock;
+    long reps = 0; double ns = 0; auto st = clk::now();
+    while(ns < ms*1e6) {
+        for(int i = 0; i < 8; i++) fn();
+        reps += 8;
+        ns = std::chrono::duration<double, std::nano>(clk::now()-st).count();
+    }
+    return ns/reps;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opt;
+    if(!parseArgs(argc, argv, opt)) return 2;
+
+    std::vector<BenchResult> baseline;
+    if(!opt.baselinePath.empty() && !readBaseline(opt.baselinePath, baseline)) {
+        perror(opt.baselinePath.c_str());
+        return 2;
+    }
+
+    std::vector<BenchResult> results;
+    int regressions = 0;
+    std::vector<float> referenceBuf(16384, 0.5f);
+    auto reference = [&] { sink = referenceJob(referenceBuf); };
+    printf("kernels: %s\n", simdLevelNames[(int)activeSimdLevel()]);
+    printf("%-36s %12s %8s %12s %9s %-8s %s\n", "case", "ns/op", "allocs", "ops/s", "streams", "label", opt.baselinePath.empty() ? "" : "vs baseline");
+
+    // warm up (plans, lazy buffers), count allocations over a few calls, then keep the best of
+    // three timed runs so a stray context switch doesn't read as a regression. A whole-job case
+    // passes its result slot and sample rate for the label and real-time columns; a streaming
+    // one also passes how to redo a fixed job, so the label doesn't depend on where timing stopped.
+    auto run = [&](const std::string& name, auto fn, const ChordComputeData* job = nullptr, float sampleRate = 0,
+                   const std::function<void()>& labelJob = nullptr) {
+        if(!opt.filter.empty() && name.find(opt.filter) == std::string::npos) return;
+        for(int i = 0; i < 4; i++) fn();
+        const unsigned long a0 = threadAllocationCount();
+        for(int i = 0; i < 16; i++) fn();
+        const unsigned long allocs = threadAllocationCount() - a0;
+        BenchResult r;
+        r.name = name;
+        r.allocs = allocs/16.;
+        // the case in 1 ms slices, each followed by a slice of the reference so both see the
+        // same machine, keeping the best of each (the slices a busy machine left alone)
+        auto measure = [&] {
+            r.ns = r.referenceNs = 1e300;
+            const int slices = std::max(3, (int)opt.minTimeMs);
+            for(int i = 0; i < slices; i++) {
+                r.ns = std::min(r.ns, timeSliceNs(fn, 1));
+                r.referenceNs = std::min(r.referenceNs, timeSliceNs(reference, 1./3));
+            }
+        };
+        measure();
+        if(labelJob) labelJob();
+        if(job) r.label = job->name;
+
+        std::string verdict;
+        auto base = std::find_if(baseline.begin(), baseline.end(), [&](const BenchResult& b) { return b.name == name; });
+        if(base != baseline.end()) {
+            // the baseline's time on this machine as it runs now: scaled by the reference job
+            // (baselines written before it was recorded are taken as they are)
+            auto expected = [&](const BenchResult& at) {
+                return base->referenceNs > 0 ? base->ns*at.referenceNs/base->referenceNs : base->ns;
+            };
+            auto slower = [&](const BenchResult& at) {
+                const double e = expected(at);
+                return at.ns > e*(1 + opt.tolerance) && at.ns - e > opt.floorNs;
+            };
+            // a slowdown has to survive two more measurements before it counts
+            for(int retry = 0; retry < 2 && slower(r); retry++) {
+                const BenchResult first = r;
+                measure();
+                if(r.ns/expected(r) > first.ns/expected(first)) { r.ns = first.ns; r.referenceNs = first.referenceNs; }
+            }
+            char buf[96];
+            const double change = r.ns/expected(r) - 1;
+            snprintf(buf, sizeof(buf), "%+6.1f%%", 100*change);
+            verdict = buf;
+            bool bad = false;
+            if(slower(r)) { verdict += " SLOWER"; bad = true; }
+            if(r.allocs > base->allocs) { verdict += " ALLOCS"; bad = true; }
+            if(!base->label.empty() && r.label != base->label) { verdict += " LABEL (was " + base->label + ")"; bad = true; }
+            regressions += bad;
+        } else if(!baseline.empty()) verdict = "new";
+        if(job) r.realtime = 1024/sampleRate*1e9/r.ns;
+
+        printf("%-36s %12.1f %8.2f %12.0f", name.c_str(), r.ns, r.allocs, 1e9/r.ns);
+        if(job) printf(" %9.1f %-8s", r.realtime, r.label.c_str());
+        else printf(" %9s %-8s", "", "");
+        printf(" %s\n", verdict.c_str());
+        fflush(stdout);
+        results.push_back(r);
+    };
+
+    const int sizes[] = {1024, 4096, 8192, 16384};
+    const int octaveCounts[] = {3, 4, 5};
+    const float sampleRates[] = {22050, 44100, 48000};
+    std::mt19937 rng(16);
+
+    // stages that only depend on the window size
+    for(int n : sizes) {
+        const std::string tag = "/n=" + std::to_string(n);
+        std::vector<float> x = chordSignal(n, 44100, rng), scratch(fftScratchFloats(n)), spec(n/2+1), hps(n/2+1);
+        std::vector<kiss_fft_cpx> out(n/2+1);
+        const FftPlan* plan = getFftPlan(FftBackend::Radix4, n);
+        run("fft" + tag, [&] { fftReal(plan, x.data(), out.data(), scratch.data()); sink = out[1].r; });
+        run("power" + tag, [&] { activeSimdKernels().powerSpectrum(spec.data(), out.data(), n/2+1); sink = spec[1]; });
+        run("hps" + tag, [&] { sink = computeHps(hps.data(), spec.data(), n, 44100, 3, 1); });
+    }
+
+    for(float sampleRate : sampleRates) {
+        for(int n : sizes) {
+            // one window plus 64 hops of the same chord, for the streaming front end to walk
+            const std::vector<float> stream = chordSignal(n + 64*1024, sampleRate, rng);
+            const std::vector<float> x(stream.begin(), stream.begin() + n);
+            for(int octaves : octaveCounts) {
+                char tag[64];
+                snprintf(tag, sizeof(tag), "/n=%d/oct=%d/sr=%.0f", n, octaves, sampleRate);
+                ChordConfig cfg = initChordConfig(n, sampleRate, octaves, 0.016f);
+                ChordComputeData* data = initChordComputeData(n, chordStateCount(cfg));
+                computeChord(*data, x.data(), cfg); // spectrum for the partial stages
+
+                run(std::string("chroma") + tag, [&] { applyChromaFilterbank(cfg.filterbank, data->spec, data->chroma); sink = data->chroma[0]; });
+                run(std::string("label") + tag, [&] { computeChordFromSpectrum(*data, cfg); sink = data->score; });
+                run(std::string("chord") + tag, [&] { computeChord(*data, x.data(), cfg); sink = data->score; }, data, sampleRate);
+                // the multirate front end streams: each job pushes the next hop through the
+                // decimators; the walk wraps on a resync, so the state always matches the window.
+                // The label is that of the first hop after a fresh resync.
+                setChordFrontEnd(cfg, FrontEnd::Multirate, WindowType::Rectangular, x.data());
+                long hop = 0;
+                auto multirateJob = [&] {
+                    const long h = hop++ % 64;
+                    pushChordSamples(cfg, &stream[n + h*1024], 1024);
+                    computeChord(*data, &stream[(h+1)*1024], cfg);
+                    sink = data->score;
+                };
+                run(std::string("multirate") + tag, multirateJob, data, sampleRate, [&] {
+                    setChordFrontEnd(cfg, FrontEnd::Multirate, WindowType::Rectangular, x.data());
+                    hop = 0;
+                    multirateJob();
+                });
+                freeChordComputeData(data);
+                freeChordConfig(cfg);
+            }
+        }
+    }
+
+    {
+        const int states = 25;
+        std::vector<float> emissions(64*states);
+        std::uniform_real_distribution<float> u(-20, 0);
+        for(auto& e : emissions) e = u(rng);
+        FixedLagViterbi* v = initViterbi(states, 8, nullptr);
+        long frame = 0;
+        run("viterbi/lag=8", [&] { sink = stepViterbi(*v, &emissions[(frame++ % 64)*states]); });
+        freeViterbi(v);
+    }
+
+    if(!opt.jsonPath.empty()) writeJson(opt.jsonPath, results);
+    if(!baseline.empty()) {
+        if(regressions) fprintf(stderr, "%d of %zu cases regressed against %s\n", regressions, results.size(), opt.baselinePath.c_str());
+        else fprintf(stderr, "no regressions against %s\n", opt.baselinePath.c_str());
+    }
+    return regressions ? 1 : 0;
+}
@@ -0,0 +1,87 @@
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <chrono>
+
+#include "chordy_feed.h"
+
+// Example consumer of the shared-memory results feed: follows /NAME and prints one line per
+// frame with its top chords and how long after publication (and capture) it was read. Waits
+// for a publisher to appear and follows it across restarts.
+static volatile sig_atomic_t stop = 0;
+
+static void onSignal(int) { stop = 1; }
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+        "usage: %s [options] NAME\n"
+        "\n"
+        "Prints \"<frame>\\t<seconds>\\t<chord>\\t<top chords>\\t<feed latency us>[\\t<capture latency us>]\"\n"
+        "per frame published by `chordy --feed NAME` or `chordy-cli --feed NAME`.\n"
+        "\n"
+        "  --spin       busy-poll instead of sleeping 100 us between empty polls\n"
+        "  --quiet      only print the summary\n"
+        "  --once       exit when the publisher closes the feed instead of waiting for the next\n",
+        argv0);
+}
+
+int main(int argc, char* argv[]) {
+    std::string name;
+    bool spin = false, quiet = false, once = false;
+    for(int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        if(a == "--spin") spin = true;
+        else if(a == "--quiet") quiet = true;
+        else if(a == "--once") once = true;
+        else if(a[0] != '-' && name.empty()) name = a;
+        else { usage(argv[0]); return 1; }
+    }
+    if(name.empty()) { usage(argv[0]); return 1; }
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    unsigned long long frames = 0, missed = 0;
+    double latencySumUs = 0, latencyMaxUs = 0;
+    while(!stop) {
+        chordy_feed_reader* r = chordy_feed_open(name.c_str());
+        if(r == nullptr) {
+            if(errno != ENOENT) { perror(name.c_str()); return 1; }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        const chordy_feed_header* h = chordy_feed_layout(r);
+        fprintf(stderr, "following /%s: pid %u, %u chords, %u slots\n", name.c_str(), h->publisher_pid, h->chord_count, h->capacity);
+
+        chordy_feed_frame f;
+        uint64_t lost = 0;
+        int got;
+        while(!stop && (got = chordy_feed_next(r, &f, &lost)) >= 0) {
+            if(got == 0) {
+                if(!spin) std::this_thread::sleep_for(std::chrono::microseconds(100));
+                continue;
+            }
+            const long long now = chordy_feed_clock_ns();
+            const double us = (now - f.publish_ns)/1e3;
+            frames++;
+            latencySumUs += us;
+            if(us > latencyMaxUs) latencyMaxUs = us;
+            if(quiet) continue;
+            printf("%llu\t%.6f\t%s\t", (unsigned long long)f.frame, f.time, chordy_feed_chord_name(r, f.chord));
+            for(int i = 0; i < f.top_count; i++) printf("%s%s", i ? "," : "", chordy_feed_chord_name(r, f.top[i]));
+            printf("\t%.1f", us);
+            if(f.adc_ns) printf("\t%.1f", (now - f.adc_ns)/1e3);
+            printf("\n");
+        }
+        fflush(stdout);
+        missed += lost;
+        chordy_feed_close(r);
+        if(once) break;
+    }
+    fprintf(stderr, "%llu frames read, %llu missed, feed latency mean %.1f us, max %.1f us\n",
+        frames, missed, frames ? latencySumUs/frames : 0., latencyMaxUs);
+    return 0;
+}
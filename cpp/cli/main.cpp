@@ -0,0 +1,451 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+#include "chord.h"
+#include "audiofile.h"
+#include "parallel.h"
+#include "multistream.h"
+#include "simd.h"
+#include "waiter.h"
+#include "feed.h"
+#include "gate.h"
+
+// Mirrors the analysis parameters of the GUI's Settings; sampleRate comes from the input.
+struct CliSettings {
+    unsigned long samplesPerBuffer = 1024; // hop
+    int computeBufferCount = 8;            // window = samplesPerBuffer*computeBufferCount
+    int octaves = 4;
+    float threshold = 0.016f;
+    bool changesOnly = false;
+    int harmonics = 3; // HPS harmonics
+    bool f0 = false;   // append the HPS fundamental to each line
+    int smoothLag = -1; // Viterbi lag in hops, -1 = raw per-frame labels
+    float stay = 0.9f;
+    std::string transitionsPath;
+    std::vector<float> transitions; // states x states, states = vocab.chords + 1
+    std::string logPath;
+    std::string latencyPath;
+    std::string feedName;
+    EventLevel logLevel = EventLevel::Detections;
+    EventFormat logFormat = EventFormat::JsonLines;
+    ChordVocabulary vocab;
+    int jobs = 1; // worker threads, 0 = one per core
+    bool perChannel = false; // label every channel on its own instead of the downmix
+    bool gate = false; // reuse the previous result while the signal doesn't change, see gate.h
+    ChordGateSettings gateSettings;
+    FrontEnd frontEnd = FrontEnd::Fft;
+    WindowType window = WindowType::Rectangular;
+    ChromaShape chroma = ChromaShape::Box;
+    FftBackend fft = FftBackend::Radix4;
+    std::string outPath;
+    RawAudioOptions raw;
+    std::vector<std::string> inputs;
+};
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+        "usage: %s [options] <file.wav|file.raw|-> ...\n"
+        "\n"
+        "Offline chord labeling. Writes \"<seconds>\\t<chord>\" per hop (prefixed by the\n"
+        "path when several inputs are given); seconds is the end of the analysis window.\n"
+        "With --per-channel, lines are \"<channel>\\t<seconds>\\t<chord>\", channels in order per hop.\n"
+        "\n"
+        "analysis:\n"
+        "  -b, --buffer N           samples per hop (default: 1024)\n"
+        "  -c, --compute-buffers N  hops per analysis window (default: 8)\n"
+        "  -O, --octaves N          octaves for chroma calculation (default: 4)\n"
+        "  -t, --threshold X        N/A threshold for chord/avg ratio (default: 0.016)\n"
+        "  --front-end FE           spectrum front end: fft|sliding|multirate (default: fft)\n"
+        "  --window W               analysis window: rect|hann (default: rect)\n"
+        "  --fft ENGINE             FFT backend: kiss|radix4 (default: radix4)\n"
+        "  --chroma SHAPE           chroma band weighting: box|triangle (default: box)\n"
+        "  --harmonics N            harmonics in the harmonic product spectrum (default: 3, 0 skips the HPS)\n"
+        "  --smooth LAG             Viterbi-smooth the labels, deciding each LAG hops late (default: off)\n"
+        "  --stay P                 smoothing probability of keeping the chord per hop (default: 0.9)\n"
+        "  --transitions FILE       smoothing transition weights, whitespace-separated rows over the\n"
+        "                           states: roots C..B of each vocabulary quality, then N/A (25x25\n"
+        "                           for the default vocabulary); overrides --stay\n"
+        "  --vocab FILE             chord qualities, one \"<name> <semitones over the root>...\" per line\n"
+        "                           (default: Maj 0 4 7, Min 0 3 7)\n"
+        "  --changes                only write a line when the label changes\n"
+        "  -j, --jobs N             analyze frames on N worker threads, 0 = all cores (default: 1)\n"
+        "  --per-channel            label each channel separately instead of the mono downmix;\n"
+        "                           channels share the --jobs workers\n"
+        "  --gate                   only analyze a hop when the signal changed (onset, silence, config),\n"
+        "                           otherwise repeat the previous result; not with --jobs\n"
+        "  --gate-silence DB        hop RMS in dBFS counted as silence (default: -60)\n"
+        "  --gate-onset X           spectral change in [0, 1] that starts an analysis (default: 0.2)\n"
+        "  --gate-max-skip N        reused hops in a row before analyzing anyway (default: 16)\n"
+        "  --gate-settle N          hops analyzed after an onset (default: a window's worth)\n"
+        "  --gate-noise DB          level change still taken as the same noise after an N/A (default: 2)\n"
+        "  --simd LEVEL             cap the kernels at scalar|sse2|avx2|avx512 (default: best supported)\n"
+        "output:\n"
+        "  -o, --output PATH        write labels to PATH instead of stdout\n"
+        "  --f0                     append the HPS fundamental in Hz (0 when silent) to each line\n"
+        "  --latency PATH           write per-stage job latency histograms to PATH as JSON\n"
+        "  --log PATH               write a per-frame event trace to PATH (- for stdout, needs -o)\n"
+        "  --log-level L            trace changes|detections|frames (default: detections)\n"
+        "  --log-format F           trace as jsonl|csv (default: jsonl); frames count across inputs\n"
+        "  --feed NAME              publish every frame to the shared-memory feed /NAME (see chordy_feed.h)\n"
+        "raw input:\n"
+        "  --raw                    treat inputs as headerless PCM\n"
+        "  --rate HZ                raw sample rate (default: 44100)\n"
+        "  --channels N             raw interleaved channel count (default: 1)\n"
+        "  --format FMT             raw sample format: u8|s8|s16|s24|s32|f32|f64 (default: f32)\n",
+        argv0);
+}
+
+static bool parseArgs(int argc, char* argv[], CliSettings& s) {
+    defaultChordVocabulary(s.vocab);
+    for(int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&](const char* name) -> const char* {
+            if(i+1 >= argc) { fprintf(stderr, "missing value for %s\n", name); return nullptr; }
+            return argv[++i];
+        };
+        const char* v = nullptr;
+        if(a == "-h" || a == "--help") { usage(argv[0]); exit(0); }
+        else if(a == "-b" || a == "--buffer") { if(!(v = next("--buffer"))) return false; s.samplesPerBuffer = strtoul(v, nullptr, 10); }
+        else if(a == "-c" || a == "--compute-buffers") { if(!(v = next("--compute-buffers"))) return false; s.computeBufferCount = atoi(v); }
+        else if(a == "-O" || a == "--octaves") { if(!(v = next("--octaves"))) return false; s.octaves = atoi(v); }
+        else if(a == "-t" || a == "--threshold") { if(!(v = next("--threshold"))) return false; s.threshold = atof(v); }
+        else if(a == "--front-end") {
+            if(!(v = next("--front-end"))) return false;
+            if(!strcmp(v, "fft")) s.frontEnd = FrontEnd::Fft;
+            else if(!strcmp(v, "sliding")) s.frontEnd = FrontEnd::Sliding;
+            else if(!strcmp(v, "multirate")) s.frontEnd = FrontEnd::Multirate;
+            else { fprintf(stderr, "unknown front end %s\n", v); return false; }
+        }
+        else if(a == "--window") {
+            if(!(v = next("--window"))) return false;
+            if(!strcmp(v, "rect")) s.window = WindowType::Rectangular;
+            else if(!strcmp(v, "hann")) s.window = WindowType::Hann;
+            else { fprintf(stderr, "unknown window %s\n", v); return false; }
+        }
+        else if(a == "--fft") {
+            if(!(v = next("--fft"))) return false;
+            if(!strcmp(v, "kiss")) s.fft = FftBackend::Kiss;
+            else if(!strcmp(v, "radix4")) s.fft = FftBackend::Radix4;
+            else { fprintf(stderr, "unknown fft backend %s\n", v); return false; }
+        }
+        else if(a == "--chroma") {
+            if(!(v = next("--chroma"))) return false;
+            if(!strcmp(v, "box")) s.chroma = ChromaShape::Box;
+            else if(!strcmp(v, "triangle")) s.chroma = ChromaShape::Triangle;
+            else { fprintf(stderr, "unknown chroma shape %s\n", v); return false; }
+        }
+        else if(a == "--changes") s.changesOnly = true;
+        else if(a == "--harmonics") { if(!(v = next("--harmonics"))) return false; s.harmonics = atoi(v); }
+        else if(a == "--f0") s.f0 = true;
+        else if(a == "--smooth") { if(!(v = next("--smooth"))) return false; s.smoothLag = atoi(v); }
+        else if(a == "--stay") { if(!(v = next("--stay"))) return false; s.stay = atof(v); }
+        else if(a == "--transitions") { if(!(v = next("--transitions"))) return false; s.transitionsPath = v; }
+        else if(a == "--latency") { if(!(v = next("--latency"))) return false; s.latencyPath = v; }
+        else if(a == "--feed") { if(!(v = next("--feed"))) return false; s.feedName = v; }
+        else if(a == "--log") { if(!(v = next("--log"))) return false; s.logPath = v; }
+        else if(a == "--log-level") {
+            if(!(v = next("--log-level"))) return false;
+            if(!parseEventLevel(v, s.logLevel)) { fprintf(stderr, "unknown log level %s\n", v); return false; }
+        }
+        else if(a == "--log-format") {
+            if(!(v = next("--log-format"))) return false;
+            if(!parseEventFormat(v, s.logFormat)) { fprintf(stderr, "unknown log format %s\n", v); return false; }
+        }
+        else if(a == "--vocab") {
+            if(!(v = next("--vocab"))) return false;
+            std::string error;
+            if(!loadChordVocabulary(s.vocab, v, error)) { fprintf(stderr, "%s\n", error.c_str()); return false; }
+        }
+        else if(a == "-j" || a == "--jobs") { if(!(v = next("--jobs"))) return false; s.jobs = atoi(v); }
+        else if(a == "--per-channel") s.perChannel = true;
+        else if(a == "--gate") s.gate = true;
+        else if(a == "--gate-silence") { if(!(v = next("--gate-silence"))) return false; s.gateSettings.silenceDb = atof(v); s.gate = true; }
+        else if(a == "--gate-onset") { if(!(v = next("--gate-onset"))) return false; s.gateSettings.onset = atof(v); s.gate = true; }
+        else if(a == "--gate-settle") { if(!(v = next("--gate-settle"))) return false; s.gateSettings.settleHops = atoi(v); s.gate = true; }
+        else if(a == "--gate-noise") { if(!(v = next("--gate-noise"))) return false; s.gateSettings.noiseDb = atof(v); s.gate = true; }
+        else if(a == "--gate-max-skip") { if(!(v = next("--gate-max-skip"))) return false; s.gateSettings.maxSkip = atoi(v); s.gate = true; }
+        else if(a == "--simd") {
+            if(!(v = next("--simd"))) return false;
+            if(!strcmp(v, "scalar")) setSimdLevel(SimdLevel::Scalar);
+            else if(!strcmp(v, "sse2")) setSimdLevel(SimdLevel::Sse2);
+            else if(!strcmp(v, "avx2")) setSimdLevel(SimdLevel::Avx2);
+            else if(!strcmp(v, "avx512")) setSimdLevel(SimdLevel::Avx512);
+            else { fprintf(stderr, "unknown simd level %s\n", v); return false; }
+        }
+        else if(a == "-o" || a == "--output") { if(!(v = next("--output"))) return false; s.outPath = v; }
+        else if(a == "--raw") s.raw.raw = true;
+        else if(a == "--rate") { if(!(v = next("--rate"))) return false; s.raw.sampleRate = atof(v); }
+        else if(a == "--channels") { if(!(v = next("--channels"))) return false; s.raw.channels = atoi(v); }
+        else if(a == "--format") {
+            if(!(v = next("--format"))) return false;
+            if(!parseSampleFormat(v, s.raw.format)) { fprintf(stderr, "unknown sample format %s\n", v); return false; }
+        }
+        else if(a.size() > 1 && a[0] == '-') { fprintf(stderr, "unknown option %s\n", a.c_str()); return false; }
+        else s.inputs.push_back(a);
+    }
+    if(s.inputs.empty()) { usage(argv[0]); return false; }
+    if(s.samplesPerBuffer < 1 || s.computeBufferCount < 1 || s.octaves < 1 || s.harmonics < 0 || s.jobs < 0 || s.raw.channels < 1 || s.raw.sampleRate <= 0) {
+        fprintf(stderr, "invalid analysis settings\n");
+        return false;
+    }
+    if(s.logPath == "-" && s.outPath.empty()) {
+        fprintf(stderr, "--log - shares stdout with the labels, add -o\n");
+        return false;
+    }
+    if(s.perChannel && !s.logPath.empty()) {
+        fprintf(stderr, "--log traces a single stream, it can't be combined with --per-channel\n");
+        return false;
+    }
+    if(s.perChannel && !s.feedName.empty()) {
+        fprintf(stderr, "--feed publishes a single stream, it can't be combined with --per-channel\n");
+        return false;
+    }
+    if(s.gate && s.jobs != 1 && !s.perChannel) {
+        fprintf(stderr, "--gate decides each hop from the last analyzed one, it can't be combined with --jobs\n");
+        return false;
+    }
+    if(s.gateSettings.maxSkip < 0) {
+        fprintf(stderr, "--gate-max-skip must be >= 0\n");
+        return false;
+    }
+    if(s.stay < 0 || s.stay > 1) {
+        fprintf(stderr, "--stay must be within [0, 1]\n");
+        return false;
+    }
+    const int states = s.vocab.chords + 1;
+    s.transitions.resize(states*states);
+    if(!s.transitionsPath.empty()) {
+        FILE* tf = fopen(s.transitionsPath.c_str(), "r");
+        if(tf == nullptr) { perror(s.transitionsPath.c_str()); return false; }
+        int read = 0;
+        while(read < states*states && fscanf(tf, "%f", &s.transitions[read]) == 1) read++;
+        fclose(tf);
+        if(read < states*states) {
+            fprintf(stderr, "%s: expected %d transition weights, got %d\n", s.transitionsPath.c_str(), states*states, read);
+            return false;
+        }
+    } else fillStayTransitions(s.transitions.data(), states, s.stay);
+    if((s.samplesPerBuffer*s.computeBufferCount) % 2) {
+        fprintf(stderr, "window length must be even\n");
+        return false;
+    }
+    return true;
+}
+
+// Per-channel results of one batch, filled from the stream workers.
+struct ChannelFrames {
+    std::vector<std::vector<ChordFrame>> frames; // [channel][hop of the batch]
+    std::vector<long> base;                      // stream frame of the batch's first hop
+};
+
+static void storeChannelFrame(int stream, const ChordComputeData& data, long frame, void* user) {
+    ChannelFrames* cf = (ChannelFrames*)user;
+    storeChordFrame(cf->frames[stream][frame - cf->base[stream]], data, 0);
+}
+
+// Streams one input through the same hop/window pipeline as the GUI's compute thread:
+// every hop of samplesPerBuffer samples, the latest samplesPerBuffer*computeBufferCount
+// samples (zero-padded at the start, like the live display buffer) are labeled.
+// With --jobs, each decoded batch is split across a work-stealing pool instead; with
+// --per-channel, each channel is its own stream and the pool runs one task per channel.
+static bool analyzeFile(const std::string& path, const CliSettings& s, FILE* out, EventLog* log, ChordFeed* feed, LatencyProbe* latency, ChordGateStats& gateStats, bool prefix, long& frames) {
+    AudioFile f;
+    if(!openAudioFile(f, path, s.raw)) return false;
+
+    const long hop = s.samplesPerBuffer;
+    const int n = s.samplesPerBuffer*s.computeBufferCount;
+    const bool perChannel = s.perChannel;
+    const bool parallel = s.jobs != 1 && !perChannel;
+    const int outputs = perChannel ? f.channels : 1;
+    ChordConfig cfg = initChordConfig(n, f.sampleRate, s.octaves, s.threshold);
+    cfg.hpsHarmonics = s.harmonics;
+    setChordChroma(cfg, s.octaves, s.chroma);
+    setChordFftBackend(cfg, s.fft);
+    setChordFrontEnd(cfg, s.frontEnd, s.window, nullptr);
+    setChordVocabulary(cfg, s.vocab);
+    cfg.latency = latency; // parallel workers share it
+    ChordComputeData* data = initChordComputeData(n, chordStateCount(cfg));
+    ParallelAnalyzer pa;
+    if(parallel) pa = initParallelAnalyzer(s.jobs, hop, cfg);
+    MultiStreamAnalyzer ms;
+    ChannelFrames channelFrames;
+    if(perChannel) {
+        ms = initMultiStreamAnalyzer(f.channels, s.jobs, hop, cfg);
+        ms.onFrame = storeChannelFrame;
+        ms.user = &channelFrames;
+        if(s.gate) setStreamGating(ms, true, s.gateSettings);
+    }
+    ChordGate* gate = s.gate && !perChannel ? initChordGate(cfg, s.gateSettings) : nullptr;
+    const long batch = parallel ? 256*workerPoolSize(pa.pool) : 64; // hops decoded per read
+    std::vector<ChordFrame> results(perChannel ? 0 : batch);
+    channelFrames.frames.assign(perChannel ? outputs : 0, std::vector<ChordFrame>(batch));
+    channelFrames.base.assign(outputs, 0);
+    // smoothing runs here over the frame scores in order, so every path feeds it the same way
+    std::vector<FixedLagViterbi*> smoothers(outputs, nullptr);
+    if(s.smoothLag >= 0) for(auto& sm : smoothers) sm = initViterbi(chordStateCount(cfg), s.smoothLag, s.transitions.data());
+    const int ring = s.smoothLag + 1;
+    std::vector<std::vector<ChordFrame>> lagRings(outputs, std::vector<ChordFrame>(s.smoothLag >= 0 ? ring : 0)); // frames still inside the lag
+    std::vector<int> order(cfg.vocab.chords);
+
+    // history holds the last n-hop samples followed by a batch of new hops, so each window is a
+    // contiguous slice and the overlap is only moved once per batch
+    std::vector<float> history(perChannel ? 0 : n-hop + batch*hop, 0.f);
+    std::vector<float> interleaved(batch*hop*f.channels);
+    // per-channel: the decoded batch split into one plane per channel
+    std::vector<float> planes(perChannel ? batch*hop*f.channels : 0);
+    std::vector<float*> planePtrs(outputs);
+    std::vector<StreamBlock> blocks(outputs);
+    for(int c = 0; c < outputs && perChannel; c++) planePtrs[c] = &planes[c*batch*hop];
+
+    std::vector<std::string> last(outputs);
+    long frame = 0;
+    auto emit = [&](int o, long fi, int state, const ChordFrame& fr) {
+        const double t = (fi+1)*hop/(double)f.sampleRate;
+        if(log || feed) {
+            ChordEvent ev;
+            ev.time = t; ev.jobUs = fr.jobUs;
+            ev.score = fr.score; ev.f0 = fr.f0;
+            ev.label = state; ev.raw = fr.chord;
+            selectTopChords(ev, fr.scores.data(), cfg.vocab.chords, order.data());
+            if(feed) publishChordFeed(*feed, ev, fr.chroma, 0);
+            if(log) logChordEvent(*log, ev);
+        }
+        const std::string label = chordName(s.vocab, state);
+        if(s.changesOnly && label == last[o]) return;
+        last[o] = label;
+        if(prefix) fprintf(out, "%s\t", path.c_str());
+        if(perChannel) fprintf(out, "%d\t", o);
+        fprintf(out, "%.6f\t%s", t, label.c_str());
+        if(s.f0) fprintf(out, "\t%.2f", fr.f0);
+        fprintf(out, "\n");
+    };
+    bool eof = false;
+    while(!eof) {
+        long got = readAudioFile(f, interleaved.data(), batch*hop);
+        if(got < batch*hop) eof = true;
+        if(got == 0) break;
+        long hops = (got + hop-1)/hop;
+
+        if(perChannel) {
+            activeSimdKernels().deinterleave(planePtrs.data(), interleaved.data(), f.channels, got);
+            for(int c = 0; c < outputs; c++) {
+                std::fill(planePtrs[c]+got, planePtrs[c]+hops*hop, 0.f); // zero-pad the final partial hop
+                blocks[c].parts[0] = planePtrs[c];
+                blocks[c].counts[0] = hops*hop;
+                channelFrames.base[c] = frame;
+            }
+            analyzeStreams(ms, blocks.data());
+        } else {
+            float* dst = &history[n-hop];
+            for(long i = 0; i < got; i++) {
+                float sm = 0; for(int c = 0; c < f.channels; c++) sm += interleaved[i*f.channels+c];
+                dst[i] = sm/f.channels;
+            }
+            std::fill(dst+got, dst+hops*hop, 0.f); // zero-pad the final partial hop
+
+            if(parallel) {
+                analyzeParallel(pa, history.data(), hops, results.data());
+            } else {
+                for(long h = 0; h < hops; h++) {
+                    pushChordSamples(cfg, &history[n-hop + h*hop], hop);
+                    const long long st = steadyNowNs();
+                    if(gate) gatedComputeChord(*gate, *data, &history[h*hop], hop, cfg);
+                    else computeChord(*data, &history[h*hop], cfg);
+                    storeChordFrame(results[h], *data, (steadyNowNs() - st)/1e3);
+                }
+            }
+            memmove(history.data(), &history[hops*hop], sizeof(float)*(n-hop));
+        }
+
+        for(long h = 0; h < hops; h++) {
+            const long fi = frame++;
+            for(int o = 0; o < outputs; o++) {
+                const ChordFrame& fr = perChannel ? channelFrames.frames[o][h] : results[h];
+                if(!smoothers[o]) { emit(o, fi, fr.label, fr); continue; }
+                lagRings[o][fi % ring] = fr;
+                const int state = stepViterbi(*smoothers[o], fr.scores.data());
+                if(state >= 0) emit(o, fi - s.smoothLag, state, lagRings[o][(fi - s.smoothLag) % ring]);
+            }
+        }
+    }
+
+    if(s.smoothLag >= 0) {
+        std::vector<std::vector<int>> rest(outputs, std::vector<int>(s.smoothLag));
+        int count = 0;
+        for(int o = 0; o < outputs; o++) count = flushViterbi(*smoothers[o], rest[o].data());
+        for(int i = 0; i < count; i++) {
+            for(int o = 0; o < outputs; o++) emit(o, frame - count + i, rest[o][i], lagRings[o][(frame - count + i) % ring]);
+        }
+        for(auto* sm : smoothers) freeViterbi(sm);
+    }
+
+    frames += frame*outputs;
+    if(gate) addChordGateStats(gateStats, gate->stats);
+    if(perChannel && s.gate) addChordGateStats(gateStats, streamGateStats(ms));
+    freeChordGate(gate);
+    if(parallel) freeParallelAnalyzer(pa);
+    if(perChannel) freeMultiStreamAnalyzer(ms);
+    freeChordComputeData(data);
+    freeChordConfig(cfg);
+    closeAudioFile(f);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    CliSettings settings;
+    if(!parseArgs(argc, argv, settings)) return 1;
+
+    FILE* out = stdout;
+    if(!settings.outPath.empty()) {
+        out = fopen(settings.outPath.c_str(), "w");
+        if(out == nullptr) { perror(settings.outPath.c_str()); return 1; }
+    }
+
+    // lossless: offline runs wait for the drainer rather than lose records
+    EventLog* log = nullptr;
+    if(!settings.logPath.empty()) {
+        log = openEventLog(settings.logPath, settings.logLevel, settings.logFormat, settings.vocab, true);
+        if(log == nullptr) { perror(settings.logPath.c_str()); return 1; }
+    }
+
+    // a file has no capture clock, so frames go out with adc_ns = 0 as fast as they are labeled
+    ChordFeed* feed = nullptr;
+    if(!settings.feedName.empty()) {
+        feed = openChordFeed(settings.feedName, settings.vocab);
+        if(feed == nullptr) { perror(settings.feedName.c_str()); return 1; }
+    }
+
+    LatencyProbe* latency = settings.latencyPath.empty() ? nullptr : new LatencyProbe();
+
+    auto st = std::chrono::high_resolution_clock::now();
+    long frames = 0; int failed = 0;
+    ChordGateStats gateStats;
+    for(auto& path : settings.inputs) {
+        if(!analyzeFile(path, settings, out, log, feed, latency, gateStats, settings.inputs.size() > 1, frames)) failed++;
+    }
+    double dt = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now()-st).count();
+    fprintf(stderr, "Analyzed %ld frames in %.2f ms (%.4f ms/job, %s)\n", frames, dt, frames ? dt/frames : 0., simdLevelNames[(int)activeSimdLevel()]);
+    if(settings.gate) {
+        fprintf(stderr, "Gate analyzed %ld of %ld frames (%.1f%% skipped), saving %.1f%% of the analysis time (%.4f ms/analysis, %.4f ms/frame gating)\n",
+            gateStats.analyzed, gateStats.frames, 100*chordGateSkipRatio(gateStats), 100*chordGateSavedRatio(gateStats),
+            gateStats.analyzed ? gateStats.analysisNs/1e6/gateStats.analyzed : 0., gateStats.frames ? gateStats.gateNs/1e6/gateStats.frames : 0.);
+    }
+    if(settings.smoothLag >= 0) fprintf(stderr, "Smoothing delays labels by %d hops (%lu samples)\n", settings.smoothLag, settings.smoothLag*settings.samplesPerBuffer);
+
+    if(latency) {
+        writeLatencyTable(stderr, *latency);
+        FILE* f = fopen(settings.latencyPath.c_str(), "w");
+        if(f == nullptr) { perror(settings.latencyPath.c_str()); failed++; }
+        else { writeLatencyJson(f, *latency); fclose(f); }
+        delete latency;
+    }
+    closeEventLog(log);
+    closeChordFeed(feed);
+    if(out != stdout) fclose(out);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// Test hook for allocation-free hot paths. Linking src/alloccount.cpp replaces the global
+// operator new/delete with versions that count allocations per thread, so a thread can
+// snapshot the counter after warm-up and prove its steady state never touches the heap.
+unsigned long threadAllocationCount();
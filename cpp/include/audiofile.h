@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdio>
+#include <string>
+
+// Sample encodings understood by the reader (WAV payloads and headerless raw PCM).
+enum class SampleFormat { U8, S8, S16, S24, S32, F32, F64 };
+
+struct AudioFile {
+    FILE* fp = nullptr;
+    bool ownsFp = false;
+    int channels = 1;
+    float sampleRate = 44100.0f;
+    SampleFormat format = SampleFormat::F32;
+    int bytesPerSample = 4;
+    long long bytesLeft = -1; // remaining payload bytes, -1 if unknown (raw/stdin)
+    unsigned char* scratch = nullptr;
+    long scratchFrames = 0;
+};
+
+// Raw PCM has no header, so its layout is provided by the caller. Ignored for WAV input.
+struct RawAudioOptions {
+    bool raw = false;
+    int channels = 1;
+    float sampleRate = 44100.0f;
+    SampleFormat format = SampleFormat::F32;
+};
+
+// Opens a RIFF/WAVE file (PCM 8/16/24/32, IEEE float 32/64, WAVE_FORMAT_EXTENSIBLE) or raw PCM.
+// Path "-" reads from stdin. Returns false and prints to stderr on failure.
+bool openAudioFile(AudioFile& f, const std::string& path, const RawAudioOptions& opts);
+// Reads up to `frames` interleaved frames as floats in [-1, 1). Returns frames read, 0 at EOF.
+long readAudioFile(AudioFile& f, float* out, long frames);
+void closeAudioFile(AudioFile& f);
+bool parseSampleFormat(const std::string& s, SampleFormat& fmt);
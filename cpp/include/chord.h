@@ -1,28 +1,122 @@
+#pragma once
 #include <string>
 #include <kiss_fftr.h>
+#include "fft.h"
+#include "stft.h"
+#include "multirate.h"
+#include "filterbank.h"
+#include "specialized.h"
+#include "viterbi.h"
+#include "vocabulary.h"
+#include "eventlog.h"
+#include "latency.h"
 
-const std::string notes[12] = {"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
+
+// Where the power spectrum comes from: one FFT of the window per hop, a sliding DFT that is
+// updated with every new sample (see stft.h), or per-octave FFTs over a decimator cascade
+// with constant-Q resolution (see multirate.h).
+enum class FrontEnd { Fft, Sliding, Multirate };
+
+const char* const frontEndNames[3] = {"FFT", "Sliding DFT", "Multirate"};
 
 struct ChordConfig {
     int n;
     int octaves;
     float threshold;
     float sampleRate;
-    kiss_fftr_cfg cfg;
-    // kiss_fft_scalar *in;
-    kiss_fft_cpx *out;
+    int hpsHarmonics = 3; // harmonics in the HPS, 0 skips it
+    FftBackend fftBackend = FftBackend::Radix4;
+    const FftPlan* fft; // from the plan cache, not owned
+    float* fftScratch;  // fftScratchFloats(n)
+    kiss_fft_scalar *in; // windowed samples
+    kiss_fft_cpx *out;   // n/2+1 bins
+
+    FrontEnd frontEnd = FrontEnd::Fft;
+    WindowType window = WindowType::Rectangular;
+    float* windowCoeffs;
+    SlidingDft* sliding = nullptr;
+    MultirateFrontEnd* multirate = nullptr;
+
+    ChromaFilterbank filterbank; // built for n, sampleRate and octaves, see setChordChroma
+    ChordVocabulary vocab;       // major/minor triads unless setChordVocabulary
+    // compiled kernels for this filterbank and vocabulary size when there are any (see
+    // specialized.h), kept in step by setChordChroma and setChordVocabulary; null runs the
+    // generic path
+    const SpecializedChroma* fixedChroma = nullptr;
+    const SpecializedScores* fixedScores = nullptr;
+    std::vector<int> order;      // per-chord scratch for the logged top-k
+    FixedLagViterbi* smoother = nullptr; // label smoothing for this stream, see setChordSmoothing
+    EventLog* log = nullptr;     // computeChord records every frame here when set, not owned
+    double streamTime = -1;      // seconds at the end of the next window, for the log; -1 untracked
+    LatencyProbe* latency = nullptr; // per-stage job timings go here when set, shared by clones
 };
 
 struct ChordComputeData {
     std::string name = "C";
     float* spec;
-    float* hps;
+    float* hps;  // mean log2 power over harmonics, see hps.h
+    float f0 = 0; // HPS fundamental estimate in Hz, 0 when silent
+    float score = 0; // best normalized template score, compared with the threshold
+    int chord = 0;   // unsmoothed decision, vocab.chords for N/A
+    int label = 0;   // state behind name, after smoothing
+    // log2 emission per chord state: the normalized template score of each vocabulary chord,
+    // then the threshold for the N/A state, so the per-frame argmax is the unsmoothed label
+    int states = 0;
+    float* scores;
     double dt;
+    long long adcNs = 0, publishNs = 0; // steady clock stamps for the latency probe, set by the caller
     float* chroma;
 };
 
-ChordComputeData* initChordComputeData(int n);
+// Fixed set of result slots recycled between the compute and GUI threads. Every slot and its
+// spec/hps/chroma arrays come from one up-front allocation, so steady-state analysis never
+// touches the heap.
+struct ChordComputePool {
+    int capacity = 0;
+    ChordComputeData* slots = nullptr;
+    float* arena = nullptr;
+};
+
+// Chord states of a config: every vocabulary chord, then N/A.
+inline int chordStateCount(const ChordConfig& cfg) { return cfg.vocab.chords + 1; }
+
+ChordComputeData* initChordComputeData(int n, int states);
 void freeChordComputeData(ChordComputeData* x);
+ChordComputePool initChordComputePool(int n, int states, int capacity);
+void freeChordComputePool(ChordComputePool& pool);
 ChordConfig initChordConfig(int n, float sampleRate, int octaves, float threshold);
+// Switches the FFT engine; the plan comes from the per-size cache, so switching back is free.
+void setChordFftBackend(ChordConfig& cfg, FftBackend backend);
+// Changes octaves and/or the filter shape, rebuilding the filterbank and the sliding bin range.
+// Live octave changes must go through here rather than writing cfg.octaves.
+void setChordChroma(ChordConfig& cfg, int octaves, ChromaShape shape);
+// Replaces the chord vocabulary. Results then need chordStateCount(cfg) scores, and any smoother
+// is rebuilt with stay transitions for the new states.
+void setChordVocabulary(ChordConfig& cfg, const ChordVocabulary& vocab);
+// Smooths the labels with a fixed-lag Viterbi decoder over the chord states, delaying them by
+// `lag` hops; lag < 0 turns smoothing off. `trans` is states x states (see initViterbi), null
+// for fillStayTransitions(0.9). Allocates, so call it on setting changes only.
+void setChordSmoothing(ChordConfig& cfg, int lag, const float* trans);
+// Independent config (own FFT plan and scratch) with the same settings, e.g. for another thread.
+// Smoothing is per stream and is not cloned.
+ChordConfig cloneChordConfig(const ChordConfig& proto);
 void freeChordConfig(ChordConfig& cfg);
-void computeChord(ChordComputeData& out, float* samples, ChordConfig& cfg);
\ No newline at end of file
+// Switches the spectrum front end and window. `history` (n samples, oldest first, may be null
+// for silence) primes a sliding front end so it is valid from the next hop.
+void setChordFrontEnd(ChordConfig& cfg, FrontEnd frontEnd, WindowType window, const float* history);
+// Streaming front ends consume every new sample through here; a no-op for the FFT front end.
+void pushChordSamples(ChordConfig& cfg, const float* x, long count);
+// Restarts a streaming front end from a full window (n samples), e.g. at a parallel batch start.
+void resetChordStream(ChordConfig& cfg, const float* window);
+// Analyzes the window ending at the newest pushed sample. `samples` (the last n samples) is read
+// by the FFT front end only. With cfg.log set the frame is also pushed to the event log.
+void computeChord(ChordComputeData& out, const float* samples, ChordConfig& cfg);
+void computeChordFromSpectrum(ChordComputeData& out, ChordConfig& cfg);
+// Label and name of out from its scores, through the smoother when there is one; the last step
+// of computeChordFromSpectrum, also used when a frame reuses earlier scores (see gate.h).
+void decideChordLabel(ChordComputeData& out, ChordConfig& cfg);
+// Records out as one frame in cfg.log (no-op without one), jobNs being what it took.
+void logChordFrame(ChordConfig& cfg, const ChordComputeData& out, long long jobNs);
+// Counts a hop that was not analyzed, so a streaming front end still resyncs from the window
+// at least every resyncHops hops.
+void skipChordHop(ChordConfig& cfg);
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+/* C API of chordy_core: streaming chord analysis behind an opaque handle.
+ *
+ * Each analyzer owns its window history, FFT scratch, filterbank, vocabulary and smoother, so
+ * separate handles may be used from separate threads at once; one handle is not safe for
+ * concurrent calls. The only process-wide state is the read-only FFT plan cache and the SIMD
+ * kernel table picked at load time. Results are copied into caller-owned structs and arrays,
+ * and chordy_process never allocates.
+ *
+ * Every field of a result describes one frame. With smoothing, a frame's label is decided lag
+ * hops after the frame, so its result is delivered then; chordy_flush delivers the frames still
+ * waiting at the end of a stream. */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct chordy_analyzer chordy_analyzer;
+
+typedef enum chordy_status {
+    CHORDY_OK = 0,
+    CHORDY_ERROR_ARGUMENT,   /* null pointer or a setting out of range */
+    CHORDY_ERROR_VOCABULARY, /* vocabulary file missing or malformed, see chordy_last_error */
+    CHORDY_ERROR_MEMORY,
+    CHORDY_ERROR_NO_RESULT,  /* no frame analyzed yet */
+} chordy_status;
+
+typedef enum chordy_front_end { CHORDY_FRONT_END_FFT = 0, CHORDY_FRONT_END_SLIDING, CHORDY_FRONT_END_MULTIRATE } chordy_front_end;
+typedef enum chordy_window { CHORDY_WINDOW_RECTANGULAR = 0, CHORDY_WINDOW_HANN } chordy_window;
+
+typedef struct chordy_config {
+    int window_size;       /* samples per analysis window, a power of two >= 256 */
+    int hop_size;          /* samples between frames, 1..window_size */
+    float sample_rate;
+    int octaves;           /* chroma octaves above C4 */
+    float threshold;       /* best template score below this is N/A */
+    int hps_harmonics;     /* 0 skips the harmonic product spectrum */
+    chordy_front_end front_end;
+    chordy_window window;
+    int smoothing_lag;     /* fixed-lag Viterbi delay in hops, -1 for raw labels; each result
+                            * then comes out lag hops after its frame was analyzed */
+    float smoothing_stay;  /* probability of keeping the chord between hops */
+    const char* vocabulary_path; /* chord quality file (see res/chords.txt), null for triads */
+} chordy_config;
+
+typedef struct chordy_result {
+    long frame;       /* frames analyzed before this one */
+    double time;      /* seconds from the first processed sample to the end of the window */
+    int chord;        /* label after smoothing, chordy_chord_count() for N/A */
+    int raw;          /* unsmoothed decision */
+    float score;      /* best normalized template score */
+    float f0;         /* HPS fundamental in Hz, 0 when silent */
+    float chroma[12]; /* C to B */
+    char name[32];    /* name of `chord`, e.g. "C Maj" or "N/A" */
+} chordy_result;
+
+/* The GUI defaults: 8192-sample window, 1024 hop, 44.1 kHz, 4 octaves, no smoothing. */
+void chordy_default_config(chordy_config* config);
+
+chordy_status chordy_create(const chordy_config* config, chordy_analyzer** analyzer);
+void chordy_destroy(chordy_analyzer* analyzer);
+/* Applies new settings. The window history is kept when the window size and sample rate are
+ * unchanged; frames still waiting for their smoothed label are dropped (flush first to keep
+ * them). On failure the analyzer keeps its previous settings. */
+chordy_status chordy_configure(chordy_analyzer* analyzer, const chordy_config* config);
+/* Drops the history, the smoother state and the frames waiting for a label, as if freshly
+ * created. */
+void chordy_reset(chordy_analyzer* analyzer);
+
+/* Feeds `count` mono samples and analyzes every hop completed by them. Up to `capacity` of the
+ * results completed meanwhile are written to `results` (may be null), the oldest first: one per
+ * analyzed frame, but with smoothing those of the frames lag hops back. Returns the number of
+ * results completed, or -1 on a bad argument. */
+long chordy_process(chordy_analyzer* analyzer, const float* samples, long count, chordy_result* results, long capacity);
+/* Ends the stream for the smoother: labels the frames still inside its lag (at most
+ * smoothing_lag of them) and writes up to `capacity` of their results, then starts the
+ * smoother afresh on the next frame; history, time and frame count carry on. Returns the
+ * number of results completed (0 without smoothing), or -1 on a bad argument. */
+long chordy_flush(chordy_analyzer* analyzer, chordy_result* results, long capacity);
+/* Analyzes `count` given windows of window_size samples, row i at frames + i*stride (stride >=
+ * window_size makes the rows disjoint, stride = hop_size reads them off one signal in place), in
+ * order through a smoother that starts afresh every call and is flushed at its end, as if they
+ * were consecutive frames of a whole stream. The front end is rebuilt from each row (for the
+ * multirate front end, a row labels as a resync hop of the stream does). Batches run on their
+ * own copy of the analyzer's state, so the stream (history, front end, smoother, pending
+ * frames, time, frame count and the latest result and scores) is left exactly as it was.
+ * Writes results[i] (frame = i, time = -1), all of it about row i, and, when `scores` is not
+ * null, the chordy_get_scores values of row i at scores + i*(chordy_chord_count() + 1).
+ * Returns count, or -1 on a bad argument. */
+long chordy_analyze_frames(chordy_analyzer* analyzer, const float* frames, long count, long stride, chordy_result* results, float* scores);
+/* The latest completed result. */
+chordy_status chordy_get_result(const chordy_analyzer* analyzer, chordy_result* result);
+/* log2 emission of every chord state of the frame of chordy_get_result (chordy_chord_count() + 1
+ * values, N/A last) into `scores`; returns the state count, copying at most `capacity`. */
+int chordy_get_scores(const chordy_analyzer* analyzer, float* scores, int capacity);
+
+int chordy_chord_count(const chordy_analyzer* analyzer);
+/* Name of chord index `chord`; "N/A" when out of range. Valid until the next configure. */
+const char* chordy_chord_name(const chordy_analyzer* analyzer, int chord);
+/* Message of the last failed call on this analyzer, "" if none. */
+const char* chordy_last_error(const chordy_analyzer* analyzer);
+const char* chordy_status_string(chordy_status status);
+
+#ifdef __cplusplus
+}
+#endif
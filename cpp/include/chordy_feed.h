@@ -0,0 +1,88 @@
+#pragma once
+/* Shared-memory results feed: a chordy process started with --feed NAME publishes every frame
+ * into the POSIX shared-memory object /NAME, and any number of local processes read it
+ * without copying through a pipe or making a syscall per frame.
+ *
+ * Layout (version 2, native byte order): a chordy_feed_header, the chord names table at
+ * names_offset (name_size bytes per name, sized for the longest), then `capacity` slots of slot_size bytes at slots_offset. The publisher writes
+ * frame k into slot k % capacity under a per-slot sequence lock (seq is odd while the slot is
+ * being written) and then raises head to k+1, never waiting for readers; a reader that falls
+ * more than `capacity` frames behind skips the overwritten ones. Readers only map the object
+ * read-only, so they can't disturb the publisher or each other.
+ *
+ * Fields may be appended to the header and the frame in a later layout: readers check magic and
+ * version, and use header_size, slot_size and the offsets instead of sizeof. */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHORDY_FEED_MAGIC 0x44524843u /* "CHRD" */
+#define CHORDY_FEED_VERSION 2u
+#define CHORDY_FEED_TOP_K 5
+
+typedef struct chordy_feed_frame {
+    uint64_t frame;       /* publisher's frame number, from 0 */
+    double time;          /* stream seconds at the end of the window */
+    int64_t adc_ns;       /* monotonic clock when the newest sample was captured, 0 for files */
+    int64_t publish_ns;   /* monotonic clock when the frame was published */
+    int32_t chord;        /* label after smoothing, chord_count for N/A */
+    int32_t raw;          /* unsmoothed decision */
+    float score;          /* best normalized template score */
+    float f0;             /* HPS fundamental in Hz, 0 when silent */
+    int32_t top_count;
+    int32_t top[CHORDY_FEED_TOP_K];         /* best chords, best first */
+    float top_scores[CHORDY_FEED_TOP_K];    /* their log2 emissions */
+    float chroma[12];     /* C to B */
+} chordy_feed_frame;
+
+typedef struct chordy_feed_slot {
+    uint32_t seq;         /* 2*(writes so far), odd while being written; accessed atomically */
+    uint32_t reserved;
+    chordy_feed_frame frame;
+} chordy_feed_slot;
+
+typedef struct chordy_feed_header {
+    uint32_t magic;       /* written last when the publisher has filled everything else */
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t slot_size;   /* stride of the slots, a multiple of 64 */
+    uint32_t capacity;    /* slots, a power of two */
+    uint32_t chord_count; /* names_offset holds chord_count + 1 names, N/A last */
+    uint32_t names_offset;
+    uint32_t slots_offset;
+    uint32_t publisher_pid;
+    uint32_t closed;      /* set once the publisher is done; accessed atomically */
+    uint64_t head;        /* frames published; accessed atomically */
+    uint32_t name_size;   /* stride of the names, each NUL-terminated and padded */
+    uint32_t reserved;
+} chordy_feed_header;
+
+typedef struct chordy_feed_reader chordy_feed_reader;
+
+/* Maps the feed /name (no leading slash) read-only. Returns null with errno set: ENOENT when no
+ * publisher has created it yet, EPROTO when the layout is not one this reader understands. The
+ * reader starts at the newest frame. */
+chordy_feed_reader* chordy_feed_open(const char* name);
+void chordy_feed_close(chordy_feed_reader* reader);
+
+/* Copies the next unread frame into *frame: 1 when one was read, 0 when there is none yet (or
+ * the publisher is in the middle of writing it), -1 when the publisher has closed the feed and
+ * every frame has been read. Frames overwritten before they were read are skipped and added to
+ * *missed when it is not null. Never blocks and never enters the kernel. */
+int chordy_feed_next(chordy_feed_reader* reader, chordy_feed_frame* frame, uint64_t* missed);
+/* Copies the newest frame and moves the reader past it: 1 on success, 0 when nothing has been
+ * published yet. */
+int chordy_feed_latest(chordy_feed_reader* reader, chordy_feed_frame* frame);
+
+const chordy_feed_header* chordy_feed_layout(const chordy_feed_reader* reader);
+/* Name of chord index `chord` from the feed's table; "N/A" when out of range. */
+const char* chordy_feed_chord_name(const chordy_feed_reader* reader, int chord);
+/* The clock behind adc_ns and publish_ns (CLOCK_MONOTONIC), for measuring feed latency. */
+int64_t chordy_feed_clock_ns(void);
+
+#ifdef __cplusplus
+}
+#endif
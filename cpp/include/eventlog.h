@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include "vocabulary.h"
+
+// What reaches the event log, from least to most.
+enum class EventLevel {
+    Off,
+    Changes,    // frames whose label differs from the previous frame's
+    Detections, // frames above the N/A threshold, what computeChord used to print
+    Frames,     // every frame
+};
+
+const char* const eventLevelNames[4] = {"off", "changes", "detections", "frames"};
+
+enum class EventFormat { JsonLines, Csv };
+
+const char* const eventFormatNames[2] = {"jsonl", "csv"};
+
+const int eventTopK = 5;
+
+// One analyzed frame as a fixed-size binary record; chord indices are named by the drainer.
+struct ChordEvent {
+    long frame = 0;          // frames offered to the log, filtered ones included
+    double time = -1;        // stream seconds at the end of the window, -1 when untracked
+    long long clockNs = 0;   // steady clock at the push, relative to openEventLog
+    float jobUs = 0;         // analysis time of the frame
+    float score = 0;         // best normalized template score, compared with the threshold
+    float f0 = 0;            // HPS fundamental in Hz
+    int label = 0;           // reported state after smoothing, vocab.chords for N/A
+    int raw = 0;             // unsmoothed decision, vocab.chords for N/A
+    int topCount = 0;
+    int top[eventTopK];      // best chords, best first
+    float topScores[eventTopK]; // their log2 emissions
+};
+
+// Structured trace of the analysis. The analysis thread is the single producer of a
+// preallocated ring of binary records and never touches a file; a drainer thread wakes every
+// few milliseconds and writes the records as JSON Lines or CSV. A full ring drops the record
+// and counts it, unless the log is lossless (offline runs), where the producer yields instead.
+struct EventLog {
+    std::atomic<EventLevel> level{EventLevel::Detections}; // may change while running
+    EventFormat format = EventFormat::JsonLines;
+    bool lossless = false;
+    FILE* out = nullptr;
+    ChordVocabulary vocab; // names for the chord indices
+
+    ChordEvent* ring = nullptr;
+    unsigned long mask = 0;                      // capacity-1, capacity a power of two
+    alignas(64) std::atomic<unsigned long> head{0}; // written by the producer
+    alignas(64) std::atomic<unsigned long> tail{0}; // written by the drainer
+    alignas(64) std::atomic<unsigned long> dropped{0};
+    std::atomic<bool> run{true};
+    std::thread drainer;
+
+    // producer state
+    long frames = 0;
+    int lastLabel = -1;
+    unsigned long tailSeen = 0; // last tail read, refreshed only when the ring looks full
+    long long startNs = 0;
+};
+
+// Opens `path` ("-" for stdout) and starts the drainer; null (with errno set) if the file
+// can't be opened. `capacity` is rounded up to a power of two.
+EventLog* openEventLog(const std::string& path, EventLevel level, EventFormat format, const ChordVocabulary& vocab, bool lossless = false, int capacity = 4096);
+// Stops the drainer after it has written everything pushed so far, then closes the output.
+void closeEventLog(EventLog* log);
+// Producer side, from one thread only: numbers the frame, applies the level, then writes the
+// ring without waiting (unless lossless). Returns false when the record was not written.
+bool logChordEvent(EventLog& log, ChordEvent& ev);
+// Fills ev.top/topScores with the best of `chords` log2 scores by partial selection;
+// `order` is scratch for `chords` indices.
+void selectTopChords(ChordEvent& ev, const float* scores, int chords, int* order);
+
+bool parseEventLevel(const char* s, EventLevel& level);
+bool parseEventFormat(const char* s, EventFormat& format);
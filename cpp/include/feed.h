@@ -0,0 +1,24 @@
+#pragma once
+#include <string>
+#include "chordy_feed.h"
+#include "eventlog.h"
+
+// Publisher side of the shared-memory results feed (layout and reader in chordy_feed.h). One
+// thread publishes; every frame is a slot write under its sequence lock plus a store to head,
+// with no syscall and no wait on readers.
+struct ChordFeed {
+    std::string name;
+    size_t size = 0;
+    chordy_feed_header* header = nullptr;
+    unsigned char* slots = nullptr;
+    unsigned long frames = 0;
+};
+
+// Creates (or replaces) the shared-memory object /name with room for `capacity` frames,
+// rounded up to a power of two. Null with errno set when it can't be created.
+ChordFeed* openChordFeed(const std::string& name, const ChordVocabulary& vocab, int capacity = 1024);
+// Marks the feed closed for readers still mapping it, unmaps it and removes the name.
+void closeChordFeed(ChordFeed* feed);
+// Publishes one frame: ev's label, raw decision, score, f0 and top chords, the 12 chroma bins,
+// and adcNs (0 when unknown). ev.time is the stream time.
+void publishChordFeed(ChordFeed& feed, const ChordEvent& ev, const float* chroma, long long adcNs);
@@ -0,0 +1,21 @@
+#pragma once
+#include <kiss_fftr.h>
+
+// Forward real FFTs behind one interface: the vendored KissFFT, or an in-tree radix-4 Stockham
+// FFT with SSE2/AVX2/AVX-512 stages (dispatched like simd.h). Plans are immutable and cached per
+// (backend, n) for the life of the process, so returning to a size costs a lookup, and since
+// execution takes caller scratch one plan serves any number of threads.
+enum class FftBackend { Kiss, Radix4 };
+
+const char* const fftBackendNames[2] = {"KissFFT", "Radix-4 SIMD"};
+
+struct FftPlan;
+
+// Cached plan for an even n. Radix4 needs a power of two >= 32 and hands out the Kiss plan
+// for other sizes.
+const FftPlan* getFftPlan(FftBackend backend, int n);
+FftBackend fftPlanBackend(const FftPlan* plan);
+// Floats of scratch fftReal needs at size n, whatever the backend.
+inline long fftScratchFloats(int n) { return 2L*n; }
+// out[0..n/2] = DFT of in[0..n).
+void fftReal(const FftPlan* plan, const float* in, kiss_fft_cpx* out, float* scratch);
@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+
+// Weighting of the power spectrum bins inside each quarter-tone band around a pitch: Box
+// averages every bin in the band, Triangle peaks at the pitch and falls off linearly in log
+// frequency to the band edges.
+enum class ChromaShape { Box, Triangle };
+
+const char* const chromaShapeNames[2] = {"Box", "Triangle"};
+
+// Pitch-class filterbank over the power spectrum, precomputed per (n, sampleRate, octaves,
+// shape) as a CSR sparse matrix. Row p*octaves + r holds the weights of pitch class p in
+// octave r above C4; each row sums to one over its band, so applying it yields band means.
+struct ChromaFilterbank {
+    int n = 0;
+    float sampleRate = 0;
+    int octaves = 0;
+    ChromaShape shape = ChromaShape::Box;
+
+    int rows = 0;
+    std::vector<int> rowPtr; // rows+1 offsets into cols/weights
+    std::vector<int> cols;   // spectrum bins
+    std::vector<float> weights;
+    std::vector<float> bands; // per-row output of the last apply
+
+    int highPassBin = 0; // bins below 50 Hz are left out of every band
+    int topBin = 0;      // highest bin any row reads
+};
+
+int freq2Bin(float freq, int sampleRate, int n);
+float midi2Freq(int midi);
+int freq2Midi(float freq);
+
+// Rebuilds the matrix in place; storage is reused when the new bank is no larger.
+void buildChromaFilterbank(ChromaFilterbank& fb, int n, float sampleRate, int octaves, ChromaShape shape);
+// chroma[p] = product over octaves of the band means of pitch class p.
+void applyChromaFilterbank(ChromaFilterbank& fb, const float* spec, float* chroma);
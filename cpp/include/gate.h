@@ -0,0 +1,69 @@
+#pragma once
+#include <vector>
+#include "chord.h"
+
+// Lazy analysis: a cheap check in front of computeChord that reuses the previous result while
+// the signal stays the same. Every hop it takes the energy of the newest hop and a coarse
+// magnitude spectrum of the newest samples (one FFT of at most 1024 points), and compares the
+// spectrum with the one taken at the last full analysis. The window is analyzed when that
+// change passes the onset threshold, on each of the settleHops hops after it (the new sound is
+// still filling the window), after maxSkip reused hops in a row, when the config the result
+// came from changed, and once when the whole window has gone silent. A noise floor never
+// repeats bin for bin, so while the last analysis found no chord, a spectral change whose
+// energy stays within noiseDb of that analysis' isn't an onset. Any other hop copies the last
+// analyzed result out again (nothing to copy when it is the same slot), still stepping the
+// smoother and the event log.
+struct ChordGateSettings {
+    float silenceDb = -60; // hop RMS in dBFS at or below which the hop is silent
+    float onset = 0.2f;    // spectral change, 0 (same) .. 1 (disjoint), that starts an analysis
+    int maxSkip = 16;      // reused hops in a row before a full analysis anyway
+    int settleHops = -1;   // hops analyzed after an onset, -1 for a window's worth
+    float noiseDb = 2;     // energy change in dB that is still the same noise after an N/A
+};
+
+struct ChordGateStats {
+    long frames = 0;        // hops through the gate
+    long analyzed = 0;      // of those, fully analyzed
+    long long analysisNs = 0; // in computeChord
+    long long gateNs = 0;     // in the checks and copies
+};
+
+struct ChordGate {
+    ChordGateSettings settings;
+    int n = 0, m = 0;       // window and gate FFT points
+    int binLo = 0, binHi = 0; // compared bins, 50 Hz to 5 kHz
+    const FftPlan* fft = nullptr;
+    std::vector<float> windowCoeffs, in, scratch, mag, ref; // ref: mag at the last analysis
+    float energy = 0, refEnergy = 0; // sum of mag^2 over the compared bins, now and in ref
+    std::vector<kiss_fft_cpx> out;
+    const ChordComputeData* last = nullptr; // where the last analysis was written, not owned
+    int silentHops = 0, skipped = 0, settle = 0;
+    bool quietAnalyzed = false; // analyzed since the whole window went silent
+    // settings the last result was computed with
+    float threshold = 0;
+    int octaves = 0, hpsHarmonics = 0;
+    FrontEnd frontEnd = FrontEnd::Fft;
+    WindowType window = WindowType::Rectangular;
+    ChromaShape shape = ChromaShape::Box;
+    ChordGateStats stats;
+};
+
+// Gate for cfg's window size, rate and FFT backend.
+ChordGate* initChordGate(const ChordConfig& cfg, const ChordGateSettings& settings = ChordGateSettings());
+void freeChordGate(ChordGate* g);
+// Forgets the last result, so the next hop is analyzed (e.g. after a stream restart, or before
+// the slot it was written to is freed).
+void resetChordGate(ChordGate& g);
+// computeChord behind the gate: `samples` are the last n samples, of which the newest `hop` are
+// new since the previous call. True when the window was analyzed, false when the result was
+// reused. The slot of the last analysis is read back on reuse, so it must stay allocated and
+// unmodified until the next one, also by whoever reads it meanwhile; results can rotate through
+// a pool. Doesn't allocate.
+bool gatedComputeChord(ChordGate& g, ChordComputeData& out, const float* samples, long hop, ChordConfig& cfg);
+
+void addChordGateStats(ChordGateStats& to, const ChordGateStats& from);
+// Share of frames that reused the previous result.
+double chordGateSkipRatio(const ChordGateStats& s);
+// Analysis time saved, as a share of what analyzing every frame would have cost: the skipped
+// frames at the mean analysis time, less the time spent gating.
+double chordGateSavedRatio(const ChordGateStats& s);
@@ -0,0 +1,10 @@
+#pragma once
+
+// Harmonic Product Spectrum, accumulated in the log domain so products of many harmonics can't
+// underflow or overflow: hps[k] is the mean log2 power of bins k, 2k, ..., hk.
+const float hpsFloor = 1e-12f; // power floor before the log, keeps silent bins finite
+
+// Writes the HPS of spec (n/2+1 power bins) into hps (n/2+1 entries, zero above (n/2)/h) and
+// returns the fundamental estimate in Hz: the HPS peak at or above loBin, refined by a
+// parabola through its neighbours, or 0 for silence or harmonics < 1.
+float computeHps(float* hps, const float* spec, int n, float sampleRate, int harmonics, int loBin);
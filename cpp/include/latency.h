@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <cstdio>
+
+// Where a frame's time goes, from the ADC to the label on screen.
+enum class LatencyStage {
+    AdcToCallback,     // driver input latency: first sample of a buffer -> its callback
+    CallbackToCompute, // analysis ring: callback -> compute thread pickup
+    CallbackToDisplay, // display ring: callback -> gui thread pickup
+    Fft,               // window to power spectrum (FFT or sliding DFT)
+    Hps,
+    Chroma,
+    Scoring,           // template GEMV, decision and smoothing
+    Job,               // whole computeChord
+    ComputeToDisplay,  // result ring: published -> gui thread pickup
+    AdcToLabel,        // newest sample of the window -> label published
+    Count,
+};
+
+const char* const latencyStageNames[(int)LatencyStage::Count] = {
+    "adc_to_callback", "callback_to_compute", "callback_to_display", "fft", "hps", "chroma", "scoring", "job", "compute_to_display", "adc_to_label",
+};
+
+// HDR-style histogram of nanosecond values: exact below 64 ns, then 32 sub-buckets per power
+// of two (3% resolution) up to 2^47 ns. Recording is a couple of relaxed atomic adds, so any
+// thread, the audio callback included, may record while another reads percentiles.
+const int latencySubBits = 5;
+const int latencyBuckets = 64 + (47-6)*32 + 32;
+
+struct LatencyHistogram {
+    std::atomic<unsigned long> counts[latencyBuckets] = {};
+    std::atomic<unsigned long> total{0};
+    std::atomic<long long> sumNs{0};
+    std::atomic<long long> maxNs{0};
+};
+
+struct LatencyProbe {
+    LatencyHistogram stages[(int)LatencyStage::Count];
+};
+
+struct LatencySummary {
+    unsigned long count = 0;
+    double meanUs = 0, p50Us = 0, p90Us = 0, p99Us = 0, p999Us = 0, maxUs = 0;
+};
+
+void recordLatency(LatencyHistogram& h, long long ns);
+inline void recordLatency(LatencyProbe& p, LatencyStage s, long long ns) { recordLatency(p.stages[(int)s], ns); }
+// Value at quantile q in [0, 1], as the upper edge of its bucket (capped at the max).
+long long latencyQuantileNs(const LatencyHistogram& h, double q);
+LatencySummary summarizeLatency(const LatencyHistogram& h);
+// Zeroes every histogram; records racing with the reset may survive it.
+void resetLatencyProbe(LatencyProbe& p);
+
+// Aligned text table of every stage with samples.
+void writeLatencyTable(FILE* out, const LatencyProbe& p);
+// JSON object with the summary and the non-empty buckets ([upper ns, count]) of every stage.
+void writeLatencyJson(FILE* out, const LatencyProbe& p);
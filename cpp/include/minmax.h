@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+
+// Min/max envelope of a sample history at power-of-two bucket sizes, for plotting a long history
+// at about two points per pixel. Level l holds the min and max of every bucket of 4<<l samples,
+// aligned to the total sample count, in a circular array over the history. Pushing updates the
+// buckets the new samples land in and their parents only, so a hop costs a pass over the new
+// samples plus a quarter of that for all the levels above.
+struct MinMaxLevel {
+    long bucket = 0;         // samples per bucket
+    std::vector<float> mn, mx; // capacity/bucket entries, bucket b at b & (entries-1)
+};
+
+struct MinMaxPyramid {
+    long capacity = 0; // history in samples, a power of two
+    long written = 0;  // samples pushed, counting a silent history before the first push
+    std::vector<MinMaxLevel> levels; // finest first
+};
+
+// Contiguous slice of one level read out for a plot.
+struct MinMaxSpan {
+    long values = 0; // min, max per bucket, oldest bucket first; 0 when the raw samples are as small
+    long bucket = 1; // samples per bucket
+    long offset = 0; // the first bucket starts this many samples before the newest one
+};
+
+// History of at least minCapacity samples, all silent.
+void initMinMaxPyramid(MinMaxPyramid& p, long minCapacity);
+void pushMinMaxPyramid(MinMaxPyramid& p, const float* x, long count);
+// Envelope of the newest `count` samples (count <= capacity) from the coarsest level that still
+// has points/2 buckets over the range: points to 2*points values (plus the partial buckets at
+// either end) into out[0..values). Reads nothing when count < 2*points, so plot the raw samples.
+MinMaxSpan readMinMaxPyramid(const MinMaxPyramid& p, long count, long points, float* out);
+// One-shot version for arrays redrawn whole every frame (spectra): min, max per bucket of
+// ceil(2*count/points) samples, at most points + 2 values; returns the bucket size, and copies
+// x as is (bucket 1) when count <= points.
+long decimateMinMax(const float* x, long count, long points, float* out, long& values);
@@ -0,0 +1,23 @@
+#pragma once
+
+// Circular float buffer whose pages are mapped twice back to back (memfd/shm + twin mmap), so
+// the newest `count` samples are always one contiguous view and writes never split at the wrap.
+// Where the twin mapping is unavailable it falls back to a 2x buffer that writes both halves.
+struct MirrorBuffer {
+    float* data = nullptr;
+    long capacity = 0; // floats, rounded up to whole pages
+    long writeInd = 0; // next write position in [0, capacity)
+    bool mirrored = false;
+};
+
+bool initMirrorBuffer(MirrorBuffer& b, long minCapacity);
+void freeMirrorBuffer(MirrorBuffer& b);
+// Appends count <= capacity samples, overwriting the oldest.
+void writeMirrorBuffer(MirrorBuffer& b, const float* x, long count);
+// Zeroes the contents, as if freshly initialized.
+void clearMirrorBuffer(MirrorBuffer& b);
+
+// Contiguous view of the newest `count` samples (count <= capacity), oldest first.
+inline const float* mirrorBufferTail(const MirrorBuffer& b, long count) {
+    return b.data + b.writeInd + b.capacity - count;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include "fft.h"
+#include "stft.h"
+#include "mirror.h"
+
+// Multirate constant-Q front end. A cascade of half-band decimators splits the input into
+// octave-spaced sample rates, and each chroma octave is analyzed by its own small FFT at the
+// lowest rate its band survives: octave r above C4 covers the newest n/2^r samples (but
+// enough for two bins per band) in n/(2^r*D) points at rate sampleRate/D. The lowest octave
+// keeps the full window's bin spacing and each octave up gets bins twice as wide, so every
+// band holds about the same number of bins, and the whole front end costs a handful of FFTs
+// of a few hundred points instead of one of n.
+// The octave spectra are painted back onto the n-point grid (scaled to the full FFT's power),
+// so the filterbank, HPS and plots read them like a linear spectrum.
+//
+// The decimators stream: every new sample goes through the cascade once. Like the sliding
+// DFT, every resyncHops hops the state is rebuilt from the window, so the output depends only
+// on the window and the hop index modulo resyncHops.
+struct MultirateOctave {
+    int stage;        // decimation stage read: rate sampleRate/2^stage
+    int m;            // FFT points at that rate
+    int binLo, binHi; // n-grid bins [binLo, binHi] this octave paints
+    unsigned long long binStep; // octave bins per grid bin, 32.32 fixed point (m*2^stage/n)
+    const FftPlan* fft;
+    std::vector<float> windowCoeffs; // m
+};
+
+struct MultirateFrontEnd {
+    int n = 0;
+    float sampleRate = 0;
+    WindowType window = WindowType::Rectangular;
+    std::vector<MultirateOctave> octaves; // lowest first
+    std::vector<MirrorBuffer> stages;     // stages[s] holds the signal at sampleRate/2^s
+    std::vector<int> pending;             // per stage s > 0: inputs from stage s-1 not yet decimated
+    std::vector<float> scratch;           // one chunk of decimator output
+    int resyncHops = 32;
+    long hopCount = 0;
+};
+
+// Octave layout for the chroma octaves above C4 at window size n; the FFT scratch of the
+// caller (n floats in, fftScratchFloats(n), n/2+1 bins out) covers every octave.
+MultirateFrontEnd* initMultirate(int n, float sampleRate, int octaves, WindowType window, FftBackend backend);
+void freeMultirate(MultirateFrontEnd* mr);
+// Replaces the state with `window` (n samples, oldest first) and restarts the hop count.
+void resetMultirate(MultirateFrontEnd& mr, const float* window);
+void pushMultirate(MultirateFrontEnd& mr, const float* x, long count);
+// Writes the painted power spectrum (n/2+1 bins) of the current window; resyncs from `window`.
+void multirateSpectrum(MultirateFrontEnd& mr, float* spec, const float* window, float* in, float* scratch, kiss_fft_cpx* out);
@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include "chord.h"
+#include "gate.h"
+#include "mirror.h"
+#include "pool.h"
+
+// Latest result of one stream, as copied out of the board.
+struct ChordBoardEntry {
+    long frame = -1;  // frames the stream analyzed before this one, -1 before the first
+    int label = 0, raw = 0;
+    float score = 0, f0 = 0;
+    long long publishNs = 0; // steady clock when it was published
+    float chroma[12] = {};
+};
+
+// Single-writer seqlock per stream, a cache line apart so publishers don't share lines.
+struct alignas(64) ChordBoardSlot {
+    std::atomic<unsigned> seq{0}; // odd while a write is in progress
+    ChordBoardEntry entry;
+};
+
+// Lock-free result board: one slot per stream, each written by whichever worker analyzes that
+// stream and read by anyone at any rate. Readers never block writers; a torn read is retried.
+struct ChordResultBoard {
+    int streams = 0;
+    ChordBoardSlot* slots = nullptr;
+};
+
+void initChordResultBoard(ChordResultBoard& b, int streams);
+void freeChordResultBoard(ChordResultBoard& b);
+// One writer per stream at a time.
+void publishChordResult(ChordResultBoard& b, int stream, const ChordComputeData& data, long frame);
+// Copies the stream's latest result; false before its first publish.
+bool readChordResult(const ChordResultBoard& b, int stream, ChordBoardEntry& out);
+
+// Analyzer state of one input stream: its own window history, front end, scratch and smoother.
+struct StreamState {
+    ChordConfig cfg;
+    ChordComputeData* data = nullptr;
+    MirrorBuffer history; // newest n samples are one contiguous view
+    long sinceHop = 0;    // samples since the last analyzed hop boundary
+    long frames = 0;
+    ChordGate* gate = nullptr; // lazy analysis when set, see setStreamGating
+};
+
+// Called on the worker that analyzed the frame, right after it was published to the board.
+typedef void (*StreamFrameFn)(int stream, const ChordComputeData& data, long frame, void* user);
+
+// New samples of one stream, in up to two parts (e.g. the two read regions of a ring).
+struct StreamBlock {
+    const float* parts[2] = {nullptr, nullptr};
+    long counts[2] = {0, 0};
+};
+
+// N independent mono streams (channels of one device, or several devices) analyzed over one
+// fixed-size worker pool. Each run is one task per stream, so a stream's frames stay in order
+// on whichever worker picks it up, and an extra stream costs one more task, not a thread.
+struct MultiStreamAnalyzer {
+    int streams = 0;
+    int n = 0;
+    long hop = 0;
+    WorkerPool* pool = nullptr;
+    std::vector<StreamState> state;
+    ChordResultBoard board;
+    StreamFrameFn onFrame = nullptr; // optional
+    void* user = nullptr;
+};
+
+// Every stream gets cloneChordConfig(proto), plus a smoother when smoothLag >= 0 (`trans` as in
+// setChordSmoothing). The histories start silent, like a fresh window.
+MultiStreamAnalyzer initMultiStreamAnalyzer(int streams, int workers, long hop, const ChordConfig& proto, int smoothLag = -1, const float* trans = nullptr);
+void freeMultiStreamAnalyzer(MultiStreamAnalyzer& m);
+// Hands every stream's newest samples, hop phase and frame count over from `from` (same streams
+// and sample rate) and restarts the front ends on them, so a reconfigured analyzer picks up
+// where the old one stopped instead of from silence. The smoothers start afresh.
+void carryStreamState(MultiStreamAnalyzer& to, const MultiStreamAnalyzer& from);
+// Puts a ChordGate in front of every stream's analysis, or removes them with on = false.
+// Allocates, so call it on setting changes only.
+void setStreamGating(MultiStreamAnalyzer& m, bool on, const ChordGateSettings& settings = ChordGateSettings());
+// Gate counters summed over the streams; read it between runs.
+ChordGateStats streamGateStats(const MultiStreamAnalyzer& m);
+// Feeds one stream on the calling thread and analyzes every hop completed by the samples.
+void analyzeStreamSamples(MultiStreamAnalyzer& m, int stream, const float* x, long count);
+// Feeds blocks[s] to stream s for every stream, in parallel, and blocks until all are done.
+void analyzeStreams(MultiStreamAnalyzer& m, const StreamBlock* blocks);
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstring>
+#include <string>
+#include <vector>
+#include "chord.h"
+#include "pool.h"
+
+// What the offline paths keep of each frame; scores feed a smoother run after the fact.
+struct ChordFrame {
+    std::string name;
+    float f0 = 0;
+    float score = 0;
+    int chord = 0, label = 0;
+    float jobUs = 0; // analysis time of the frame
+    std::vector<float> scores; // reuses its storage from one batch to the next
+    float chroma[12];
+};
+
+inline void storeChordFrame(ChordFrame& f, const ChordComputeData& data, float jobUs) {
+    f.name = data.name;
+    f.f0 = data.f0;
+    f.score = data.score;
+    f.chord = data.chord; f.label = data.label;
+    f.jobUs = jobUs;
+    memcpy(f.chroma, data.chroma, sizeof(f.chroma));
+    f.scores.assign(data.scores, data.scores + data.states);
+}
+
+// Offline multi-core analysis. Frames are independent given their window, so a long signal
+// is cut into batches of consecutive frames that workers label concurrently. Every worker owns
+// its ChordConfig (kiss_fftr_cfg + FFT output) and ChordComputeData scratch, and each frame is
+// written to its own slot, so results come back in timestamp order and match computeChord
+// frame for frame. Streaming front ends restart from the full window at each batch, and
+// batches are aligned to their resync period so the state matches too.
+struct ParallelAnalyzer {
+    WorkerPool* pool;
+    int n;
+    long hop;
+    int batchFrames; // frames per stolen task
+    std::vector<ChordConfig> cfgs;
+    std::vector<ChordComputeData*> data;
+};
+
+// Each worker gets cloneChordConfig(proto).
+ParallelAnalyzer initParallelAnalyzer(int workers, long hop, const ChordConfig& proto);
+void freeParallelAnalyzer(ParallelAnalyzer& pa);
+// `samples` holds the n-hop samples preceding the first frame followed by frames*hop new samples.
+// Frame f is analyzed from samples[f*hop, f*hop+n) into out[f]. Callers splitting a stream
+// into several calls should start each at a multiple of batchFrames frames.
+void analyzeParallel(ParallelAnalyzer& pa, const float* samples, long frames, ChordFrame* out);
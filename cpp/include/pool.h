@@ -0,0 +1,15 @@
+#pragma once
+
+// Fixed-size pool of persistent worker threads with per-worker task deques. A run hands
+// out contiguous task ranges to each worker; idle workers steal from the back of a peer's
+// deque, so uneven task costs still keep every core busy.
+struct WorkerPool;
+
+typedef void (*WorkerTask)(int worker, int task, void* user);
+
+WorkerPool* initWorkerPool(int workers); // workers <= 0 uses std::thread::hardware_concurrency()
+void freeWorkerPool(WorkerPool* pool);
+int workerPoolSize(const WorkerPool* pool);
+// Runs fn(worker, task, user) for every task in [0, tasks) and blocks until all have finished.
+// `worker` is stable per thread in [0, workerPoolSize), so callers can index per-worker state.
+void runWorkerPool(WorkerPool* pool, int tasks, WorkerTask fn, void* user);
@@ -0,0 +1,37 @@
+#pragma once
+#include <kiss_fftr.h>
+
+// Vectorized inner loops of computeChord with one table per instruction set, picked at runtime
+// from what the CPU supports. maxRange matches the scalar path bit for bit; the others agree to
+// float rounding (sums are reassociated, and AVX-512 may fuse multiply-adds).
+enum class SimdLevel { Scalar, Sse2, Avx2, Avx512 };
+
+const char* const simdLevelNames[4] = {"Scalar", "SSE2", "AVX2", "AVX-512"};
+
+struct SimdKernels {
+    // spec[i] = |x[i]|^2 for i in [0, count)
+    void (*powerSpectrum)(float* spec, const kiss_fft_cpx* x, int count);
+    // sum of x[lo, hi), 0 when empty
+    float (*sumRange)(const float* x, int lo, int hi);
+    // max of 0 and x[lo, hi)
+    float (*maxRange)(const float* x, int lo, int hi);
+    // y[r] = sum_c a[c*rows + r]*x[c] for a column-major rows x cols matrix
+    void (*matVec)(float* y, const float* a, int rows, int cols, const float* x);
+    // y[r] = sum_k vals[k]*x[cols[k]] for k in [rowPtr[r], rowPtr[r+1]), a CSR matrix
+    void (*sparseMatVec)(float* y, const int* rowPtr, const int* cols, const float* vals, int rows, const float* x);
+    // y[i] = log2(max(x[i], floor)) for i in [0, count), floor a positive normal float; NaN gives log2(floor)
+    void (*log2Range)(float* y, const float* x, int count, float floor);
+    // in place: x[k] = (x[k] + x[2k] + ... + x[hk])/h for k in [0, count); x needs h*(count-1)+1 entries
+    void (*harmonicMean)(float* x, int count, int h);
+    // out[c][i] = in[i*channels + c] for c in [0, channels), i in [0, frames)
+    void (*deinterleave)(float* const* out, const float* in, int channels, long frames);
+};
+
+// Best level this CPU (and OS) supports; always Scalar off x86.
+SimdLevel detectSimdLevel();
+// Kernels for `level`, clamped to detectSimdLevel().
+const SimdKernels& simdKernels(SimdLevel level);
+// Kernels used by computeChord, detectSimdLevel() unless overridden by setSimdLevel.
+const SimdKernels& activeSimdKernels();
+SimdLevel activeSimdLevel();
+void setSimdLevel(SimdLevel level);
@@ -0,0 +1,27 @@
+#pragma once
+#include "filterbank.h"
+
+// Chroma and scoring compiled for fixed configurations. For the window sizes 2048-16384, 1-6
+// octaves and 44.1/48 kHz, the Box filterbank's band edges are computed at compile time (the
+// same float arithmetic as buildChromaFilterbank), and each band becomes a sum over a constant
+// bin range unrolled into the kernel: no CSR indices, no per-row bounds. Scoring is unrolled
+// for the 24 triads. Every kernel is compiled once for the baseline target and once for AVX2
+// (on x86; elsewhere [1] is the baseline too), and picked per call from activeSimdLevel().
+// Anything else runs the generic path.
+struct SpecializedChroma {
+    int n = 0, octaves = 0, sampleRate = 0;
+    void (*apply[2])(const float* spec, float* chroma); // [0] baseline, [1] AVX2
+};
+
+// y[c] = sum_j templates[j*chords + c]*chroma[j] for the compiled chord count
+struct SpecializedScores {
+    int chords = 0;
+    void (*apply[2])(float* y, const float* templates, const float* chroma);
+};
+
+// Kernel for fb's window size, octaves and rate, or null when they aren't compiled in, the
+// shape isn't Box, or the table doesn't match fb exactly (then the generic path is used).
+const SpecializedChroma* findSpecializedChroma(const ChromaFilterbank& fb);
+const SpecializedScores* findSpecializedScores(int chords);
+// 0 for the baseline kernels, 1 for AVX2, from activeSimdLevel()
+int specializedVariant();
@@ -0,0 +1,41 @@
+#pragma once
+#include "fft.h"
+
+enum class WindowType { Rectangular, Hann };
+
+const char* const windowTypeNames[2] = {"Rectangular", "Hann"};
+
+// Fills w[0..n) with the periodic window (the form whose DFT is a 3-tap kernel).
+void fillWindow(float* w, int n, WindowType type);
+
+// Streaming STFT that reuses the overlap between hops: a sliding DFT over the bins the chroma
+// reads, X_k <- (X_k - x_old + x_new) e^{j2pi k/n} per sample. Its cost is bins*sampleRate no
+// matter how dense the hops are, whereas the FFT path costs one n-point FFT per hop, so it wins
+// when hops get short relative to the window. The Hann window is applied in the frequency
+// domain (0.5X_k - 0.25X_{k-1} - 0.25X_{k+1}). Every resyncHops hops the state is rebuilt
+// from the history with one FFT, which bounds drift and makes the output depend only on the
+// window and the hop index modulo resyncHops.
+struct SlidingDft {
+    int n = 0;
+    int kLo = 0, kHi = 0; // reported bins [kLo, kHi]
+    int tLo = 0, tHi = 0; // tracked bins, one wider on each side for the window kernel
+    WindowType window = WindowType::Rectangular;
+    int resyncHops = 32;
+    long hopCount = 0;
+
+    double* re = nullptr; double* im = nullptr;   // state per tracked bin
+    double* twr = nullptr; double* twi = nullptr; // e^{j2pi k/n}
+    float* history = nullptr; int pos = 0;        // last n samples, pos = oldest
+};
+
+SlidingDft* initSlidingDft(int n, int kLo, int kHi, WindowType window);
+void freeSlidingDft(SlidingDft* s);
+// Moves the reported bin range, keeping the history; the next spectrum resyncs.
+void setSlidingDftRange(SlidingDft& s, int kLo, int kHi);
+// Replaces the history with `window` (n samples, oldest first) and restarts the hop count.
+void resetSlidingDft(SlidingDft& s, const float* window);
+void pushSlidingDft(SlidingDft& s, const float* x, long count);
+// Writes the power spectrum of the current window into spec[kLo..kHi] (other bins zeroed,
+// spec has n/2+1 entries). Resyncs go through `fft` with `window` (n floats), `scratch`
+// (fftScratchFloats(n)) and `out` (n/2+1).
+void slidingDftSpectrum(SlidingDft& s, float* spec, const FftPlan* fft, float* window, float* scratch, kiss_fft_cpx* out);
@@ -0,0 +1,37 @@
+#pragma once
+
+// Online fixed-lag Viterbi decoder. Every step folds one frame of log2 emissions into the best
+// path score per state (an O(states^2) max-plus update) and records the back pointers; the
+// decision for the frame `lag` steps back is the backtrace from the currently best state, so
+// later frames can overturn a transient before it is reported. Larger lags smooth more and
+// delay the labels by lag hops; lag 0 is the greedy online decoder. All storage is allocated
+// up front, steps never touch the heap. A matrix that only distinguishes staying from moving
+// (fillStayTransitions) is detected and decoded in O(states), so large vocabularies stay cheap.
+struct FixedLagViterbi {
+    int states = 0;
+    int lag = 0;
+    float* logTrans = nullptr; // [to*states + from], log2 of the row-normalized transition matrix
+    bool stayMove = false;     // every row is logStay on the diagonal and logMove elsewhere
+    float logStay = 0, logMove = 0;
+    int top = 0, second = 0;   // best and runner-up state of delta
+    float* delta = nullptr;    // best path log score ending in each state
+    float* next = nullptr;
+    int* back = nullptr;       // max(lag, 1) frames of back pointers [slot*states + to], a ring
+    int head = 0;              // ring slot of the newest frame
+    long frames = 0;           // steps since the last reset
+};
+
+// `trans` is states x states, row `from` holding the weights of moving to each state; rows
+// are normalized here. Null means uniform, which reduces to a per-frame argmax.
+FixedLagViterbi* initViterbi(int states, int lag, const float* trans);
+void freeViterbi(FixedLagViterbi* v);
+void resetViterbi(FixedLagViterbi& v);
+// Adds one frame of log2 emissions and returns the decoded state of the frame `lag` steps back,
+// or -1 while fewer than lag+1 frames have been seen.
+int stepViterbi(FixedLagViterbi& v, const float* logEmission);
+// Decodes the frames still inside the lag (min(lag, frames) of them, oldest first) into
+// `states`, e.g. at the end of a stream, and returns how many were written.
+int flushViterbi(const FixedLagViterbi& v, int* states);
+// Transition weights that keep the current state with probability `stay` and spread the rest
+// evenly over the others.
+void fillStayTransitions(float* trans, int states, float stay);
@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+#include <vector>
+
+const std::string notes[12] = {"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
+
+// Chord qualities as pitch-class sets over a root. Each quality is transposed to every root that
+// gives a distinct note set and compiled into one dense template matrix, so the whole vocabulary
+// is scored against a chroma vector with a single matrix-vector product. That's all 12 roots for
+// most qualities; one that repeats under transposition keeps only the roots before it repeats
+// (C, C#, D, D# aug: E aug is C aug), as the others would tie with those and never be reported.
+struct ChordVocabulary {
+    std::vector<std::string> qualities; // display names, e.g. "Maj", "Min", "7"
+    std::vector<int> masks;             // bit k set when the quality has the note k semitones over the root
+    int chords = 0;                     // quality by quality, each over its roots from C up
+    std::vector<int> roots, chordQualities; // per chord, root (0 = C) and index into qualities
+    std::vector<float> templates;       // column-major chords x 12 for matVec, equal L2 norm per chord
+};
+
+// Major and minor triads, the vocabulary chordy has always used.
+void defaultChordVocabulary(ChordVocabulary& v);
+// Appends a quality given as semitone offsets over the root (taken mod 12). Fails on an empty
+// note set, a name already in the vocabulary, or a note set that is another quality's on some
+// root (C6 is Am7), since its templates would duplicate existing ones.
+bool addChordQuality(ChordVocabulary& v, const std::string& name, const int* intervals, int count, std::string& error);
+// Reads one quality per line, "<name> <interval> <interval> ...", a word starting with '#'
+// commenting out the rest of the line.
+// Replaces v only if the whole file parses; otherwise error names the offending line.
+bool loadChordVocabulary(ChordVocabulary& v, const std::string& path, std::string& error);
+// "<root> <quality>", or "N/A" for the no-chord state (any index past the chords).
+std::string chordName(const ChordVocabulary& v, int chord);
@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+// How a consumer thread waits for its producer.
+enum class WaitPolicy {
+    Spin,         // busy-poll: lowest latency, burns a full core
+    Yield,        // poll + std::this_thread::yield
+    SpinThenPark, // busy-poll for spinMicros, then block until notified
+    Park,         // block until notified
+};
+
+const char* const waitPolicyNames[4] = {"Spin", "Yield", "Spin then park", "Park"};
+
+// Event counter the producer bumps after publishing work. Parking is futex/condvar based; the
+// producer only touches the mutex when a consumer is actually asleep.
+struct Waiter {
+    std::atomic<unsigned> seq{0};
+    std::atomic<int> sleepers{0};
+    std::atomic<long long> notifyNs{0}; // steady clock stamp of the last notify, for wake latency
+    std::mutex m;
+    std::condition_variable cv;
+};
+
+// Consumer-side statistics; the atomics are published once per second for other threads.
+struct WaitStats {
+    std::atomic<double> wakeLatencyUs{0};    // mean notify -> running delay of wakes that had to wait
+    std::atomic<double> maxWakeLatencyUs{0};
+    std::atomic<double> cpuPercent{0};       // thread CPU time / wall time
+    std::atomic<double> busyPercent{0};      // time spent on jobs / wall time; cpu - busy is the idle burn
+
+    long long windowStartNs = 0, windowCpuNs = 0, windowBusyNs = 0;
+    double latencySumUs = 0, latencyMaxUs = 0; long latencyCount = 0;
+};
+
+long long steadyNowNs();
+long long threadCpuNs();
+
+// Producer: call after making work available. Never blocks.
+void notifyWaiter(Waiter& w);
+// Consumer: wait until w.seq moves past `seen` according to policy. Parks are bounded by
+// timeoutMicros, so shutdown flags are re-checked even without a notify.
+void waitWaiter(Waiter& w, WaitPolicy policy, unsigned seen, int spinMicros, int timeoutMicros = 10000);
+
+// Consumer bookkeeping: record a wake (after a wait that found work) and job time; every
+// second the window is folded into the published fields.
+void recordWake(WaitStats& stats, const Waiter& w);
+void recordJob(WaitStats& stats, long long jobNs);
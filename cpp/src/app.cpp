@@ -3,6 +3,8 @@
 #include <chrono>
 #include <thread>
 #include <fstream>
+#include <filesystem>
+#include <atomic>
 
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
@@ -15,6 +17,14 @@
 #include "pa_util.h"
 
 #include "chord.h"
+#include "alloccount.h"
+#include "waiter.h"
+#include "mirror.h"
+#include "simd.h"
+#include "multistream.h"
+#include "minmax.h"
+#include "feed.h"
+#include "gate.h"
 
 #define GL_SILENCE_DEPRECATION
 #if defined(IMGUI_IMPL_OPENGL_ES2)
@@ -26,17 +36,44 @@
 #include "../libs/emscripten/emscripten_mainloop_stub.h"
 #endif
 
+// Live audio shapes offered under Settings > Audio.
+const float sampleRateChoices[] = {22050, 44100, 48000, 88200, 96000};
+const int bufferChoices[] = {128, 256, 512, 1024, 2048, 4096};
+const int displayBufferChoices[] = {64, 128, 256, 512, 1024, 2048, 4096, 8192}; // >= ringBufferCount
+const long maxDisplaySamples = 1L << 23; // ~3 minutes at 44.1 kHz
+const int minWindow = 1024, maxWindow = 65536;
+
 struct Settings {
     std::string version = "v1.0.0";
+    // rate, buffer and window lengths change live: the gui rebuilds what they size and the
+    // analysis threads swap it in between jobs (see ComputeGeneration)
     float sampleRate = 44100.0;
     unsigned long samplesPerBuffer = 1024;
     int ringBufferCount = 64;
-    int displayBufferCount = 256; 
-    int computeBufferCount = 8; // must be < displayBufferCount
+    int displayBufferCount = 256; // >= ringBufferCount
+    int computeBufferCount = 8; // window of samplesPerBuffer*computeBufferCount, < displayBufferCount
+    int hopSamples = 1024; // analysis hop, independent of the gui frame rate
     int computeRingFrameCount = 1;
     int octaves = 4;
     float threshold = 0.016f;
+    int hpsHarmonics = 3;
+    bool smoothing = false; // fixed-lag Viterbi over the chord scores
+    int smoothLag = 8;      // hops the labels are delayed by
+    float smoothStay = 0.9f;
+    bool gate = false;      // lazy analysis: reuse the last result until the signal changes
+    ChordVocabulary vocab;  // res/chords.txt when present, else major/minor triads
+    EventLevel logLevel = EventLevel::Detections; // JSON Lines trace on stdout
+    WaitPolicy waitPolicy = WaitPolicy::SpinThenPark; // how the compute thread idles between jobs
+    int spinMicros = 50;
+    FrontEnd frontEnd = FrontEnd::Fft;          // sliding DFT only pays off at small hops
+    WindowType window = WindowType::Rectangular;
+    FftBackend fftBackend = FftBackend::Radix4;
     float maxDisplayHz = 1100;
+    // multi-stream input (--channels N, --device IDX...): every channel of every device is
+    // analyzed as its own stream; the first channel of the first device drives the main view
+    int channels = 1;
+    std::vector<int> devices; // empty = the default input
+    int streamWorkers = 0;    // 0 = one per core, at most one per stream
     ImVec4 accentCol1 = ImColor::HSV(219/360., .58, .93), accentCol2 = ImColor::HSV(99/360., .58, .93), accentCol3 = ImColor::HSV(349/360., .58, .93);
 };
 
@@ -46,6 +83,21 @@ struct GuiState {
     bool collapsed = false;
     int octaves = 4;
     float threshold = 0.016f;
+    int hpsHarmonics = 3;
+    bool smoothing = false;
+    int smoothLag = 8;
+    float smoothStay = 0.9f;
+    bool gate = false;
+    int waitPolicy = 0;
+    int logLevel = 2;
+    int hopSamples = 1024;
+    int frontEnd = 0, window = 0, fftBackend = 0;
+    float sampleRate = 44100; // requested audio shape, applied once the previous change has settled
+    int samplesPerBuffer = 1024, computeBufferCount = 8, displayBufferCount = 256;
+    std::string audioError; // why the last audio change was rolled back
+    bool display = true;
+    bool showLatency = false;
+    bool showStreams = true;
     float plotMxs[3] = {0.2, 14.87, 17.3};
 };
 
@@ -58,14 +110,114 @@ static void glfw_error_callback(int error, const char* description)
     fprintf(stderr, "GLFW Error %d: %s\n", error, description);
 }
 
+// Steady clock stamps of one input buffer: when its first sample hit the ADC (estimated from
+// the PortAudio stream times) and when its callback ran.
+struct BufferStamp {
+    long long adcNs, callbackNs;
+};
+
+// The callback tees every input buffer: the analysis tap feeds the compute thread directly,
+// the display tap is an optional subscriber drained by the gui at its own frame rate. Each tap
+// carries a parallel ring of BufferStamps, written first so a reader always finds the stamps
+// of the buffers it sees.
 struct PaContext {
-    PaUtilRingBuffer rBuffFromRT;
+    PaUtilRingBuffer rBuffFromRT; // display tap
     void* rBuffFromRTData;
+    PaUtilRingBuffer rStampsFromRT;
+    void* rStampsFromRTData;
+
+    PaUtilRingBuffer rBuffToCompute; // analysis tap
+    void* rBuffToComputeData;
+    PaUtilRingBuffer rStampsToCompute;
+    void* rStampsToComputeData;
+    Waiter* computeWaiter = nullptr;
+    LatencyProbe* latency = nullptr;
+
+    std::atomic<bool> display{true};
+    std::atomic<unsigned long> computeOverruns{0}; // buffers lost because the compute thread fell behind
 };
 
+// Tees one mono buffer into the analysis and display taps.
+static void teeBuffer(PaContext* paCtx, const void* inputBuffer, const PaStreamCallbackTimeInfo* timeInfo) {
+    const long long now = steadyNowNs();
+    BufferStamp stamp = {now, now};
+    if(timeInfo && timeInfo->inputBufferAdcTime > 0) { // 0 when the host api can't tell
+        stamp.adcNs = now - (long long)((timeInfo->currentTime - timeInfo->inputBufferAdcTime)*1e9);
+        recordLatency(*paCtx->latency, LatencyStage::AdcToCallback, now - stamp.adcNs);
+    }
+    if(PaUtil_GetRingBufferWriteAvailable(&paCtx->rBuffToCompute) > 0) {
+        PaUtil_WriteRingBuffer(&paCtx->rStampsToCompute, &stamp, 1);
+        PaUtil_WriteRingBuffer(&paCtx->rBuffToCompute, inputBuffer, 1);
+    } else paCtx->computeOverruns++;
+    if(paCtx->computeWaiter) notifyWaiter(*paCtx->computeWaiter);
+    if(paCtx->display.load(std::memory_order_relaxed) && PaUtil_GetRingBufferWriteAvailable(&paCtx->rBuffFromRT) > 0) {
+        PaUtil_WriteRingBuffer(&paCtx->rStampsFromRT, &stamp, 1);
+        PaUtil_WriteRingBuffer(&paCtx->rBuffFromRT, inputBuffer, 1);
+    }
+}
+
 int paCallback(const void* inputBuffer, void* output, unsigned long samplesPerBuffer, const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags flags, void* userData) {
-    PaContext* paCtx = (PaContext*) userData;
-    PaUtil_WriteRingBuffer(&paCtx->rBuffFromRT, inputBuffer, 1);
+    teeBuffer((PaContext*) userData, inputBuffer, timeInfo);
+    return paContinue;
+}
+
+static void freePaContext(PaContext* c) {
+    if(c == nullptr) return;
+    if(c->rBuffFromRTData) PaUtil_FreeMemory(c->rBuffFromRTData);
+    if(c->rBuffToComputeData) PaUtil_FreeMemory(c->rBuffToComputeData);
+    if(c->rStampsFromRTData) PaUtil_FreeMemory(c->rStampsFromRTData);
+    if(c->rStampsToComputeData) PaUtil_FreeMemory(c->rStampsToComputeData);
+    delete c;
+}
+
+// Both taps with elements of samplesPerBuffer samples; null when out of memory.
+static PaContext* initPaContext(unsigned long samplesPerBuffer, int ringBufferCount, Waiter* computeWaiter, LatencyProbe* latency) {
+    PaContext* c = new PaContext();
+    c->rBuffFromRTData = PaUtil_AllocateZeroInitializedMemory(sizeof(float) * samplesPerBuffer * ringBufferCount);
+    c->rBuffToComputeData = PaUtil_AllocateZeroInitializedMemory(sizeof(float) * samplesPerBuffer * ringBufferCount);
+    c->rStampsFromRTData = PaUtil_AllocateZeroInitializedMemory(sizeof(BufferStamp) * ringBufferCount);
+    c->rStampsToComputeData = PaUtil_AllocateZeroInitializedMemory(sizeof(BufferStamp) * ringBufferCount);
+    if(!c->rBuffFromRTData || !c->rBuffToComputeData || !c->rStampsFromRTData || !c->rStampsToComputeData) {
+        freePaContext(c);
+        return nullptr;
+    }
+    PaUtil_InitializeRingBuffer(&c->rBuffFromRT, sizeof(float)*samplesPerBuffer, ringBufferCount, c->rBuffFromRTData);
+    PaUtil_InitializeRingBuffer(&c->rBuffToCompute, sizeof(float)*samplesPerBuffer, ringBufferCount, c->rBuffToComputeData);
+    PaUtil_InitializeRingBuffer(&c->rStampsFromRT, sizeof(BufferStamp), ringBufferCount, c->rStampsFromRTData);
+    PaUtil_InitializeRingBuffer(&c->rStampsToCompute, sizeof(BufferStamp), ringBufferCount, c->rStampsToComputeData);
+    c->computeWaiter = computeWaiter;
+    c->latency = latency;
+    return c;
+}
+
+// One input device of a multi-stream run. Its callback deinterleaves the buffer straight into
+// the next element of each channel's stream ring (a full ring's channel lands in `drop` and
+// counts as an overrun), so a channel costs one SIMD-transposed copy and no extra pass.
+struct DeviceContext {
+    PaContext* focus = nullptr; // first device: channel 0 also goes through teeBuffer
+    int firstStream = 0, channels = 1;
+    PaUtilRingBuffer* streamRings = nullptr; // StreamsContext::rings
+    float** planes = nullptr;       // [channels] destinations of the current buffer
+    unsigned char* claimed = nullptr; // [channels] planes[c] is a ring element
+    float* drop = nullptr;          // channels*samplesPerBuffer
+    Waiter* waiter = nullptr;
+    std::atomic<unsigned long>* overruns = nullptr;
+};
+
+int deviceCallback(const void* inputBuffer, void* output, unsigned long samplesPerBuffer, const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags flags, void* userData) {
+    DeviceContext* dev = (DeviceContext*) userData;
+    for(int c = 0; c < dev->channels; c++) {
+        void* regions[2]; ring_buffer_size_t counts[2];
+        dev->claimed[c] = PaUtil_GetRingBufferWriteRegions(&dev->streamRings[dev->firstStream + c], 1, &regions[0], &counts[0], &regions[1], &counts[1]) == 1;
+        dev->planes[c] = dev->claimed[c] ? (float*)regions[0] : dev->drop + c*samplesPerBuffer;
+        if(!dev->claimed[c]) (*dev->overruns)++;
+    }
+    activeSimdKernels().deinterleave(dev->planes, (const float*)inputBuffer, dev->channels, samplesPerBuffer);
+    if(dev->focus) teeBuffer(dev->focus, dev->planes[0], timeInfo); // before the ring may hand it on
+    for(int c = 0; c < dev->channels; c++) {
+        if(dev->claimed[c]) PaUtil_AdvanceRingBufferWriteIndex(&dev->streamRings[dev->firstStream + c], 1);
+    }
+    notifyWaiter(*dev->waiter);
     return paContinue;
 }
 
@@ -74,46 +226,480 @@ static int pa_error_handler(PaError err){
     return 1;
 }
 
+// Everything the compute thread sizes by the rate, buffer and window. The gui builds a new
+// generation off the hot path and hands it over through ComputeContext::next; the compute
+// thread swaps it in between jobs and publishes it as current (RCU-style), after which it never
+// touches the old one again and the gui frees it.
+struct ComputeGeneration {
+    int n = 0;
+    float sampleRate = 0;
+    unsigned long samplesPerBuffer = 0;
+    PaContext* input = nullptr; // tap it reads, shared by generations until the stream changes
+    MirrorBuffer window; // audio is copied once, from the ring into the mirror; each hop's window is a view of its tail
+    ChordConfig cfg;
+    float smoothStay = -1; // stay probability cfg.smoother was built with
+    ChordGate* gate = nullptr; // used while settings.gate is on; reads back slots of `pool`
+
+    PaUtilRingBuffer rBuffToGui;
+    void* rBuffToGuiData = nullptr;
+
+    // result slots travel compute -> gui over rBuffToGui and come back over rBuffFreeFromGui
+    ChordComputePool pool;
+    PaUtilRingBuffer rBuffFreeFromGui;
+    void* rBuffFreeFromGuiData = nullptr;
+};
+
 struct ComputeContext {
-    bool run = true;     
+    bool run = true;
 
-    PaUtilRingBuffer rBuffFromGui;
-    void* rBuffFromGuiData;
+    std::atomic<ComputeGeneration*> next{nullptr};    // published by the gui, taken between jobs
+    std::atomic<ComputeGeneration*> current{nullptr}; // the generation the compute thread runs on
 
-    PaUtilRingBuffer rBuffToGui;
-    void* rBuffToGuiData;
+    std::atomic<unsigned long> steadyAllocations{0}; // compute thread heap allocations after the first job
+    std::atomic<unsigned long> droppedJobs{0};       // jobs skipped because every slot was in flight
+    std::atomic<float> gateSkipped{0}, gateSaved{0}; // chordGateSkipRatio and chordGateSavedRatio of the generation
+
+    Waiter waiter; // notified by the audio callback after each buffer
+    EventLog* log = nullptr; // drained to stdout off the compute thread
+    ChordFeed* feed = nullptr; // shared-memory results for other processes, with --feed
+    LatencyProbe* latency = nullptr;
+    WaitStats waitStats;
 };
 
+// Per-stream rings of samplesPerBuffer-float elements, filled by the device callbacks.
+struct StreamRings {
+    int streams = 0;
+    unsigned long samplesPerBuffer = 0;
+    PaUtilRingBuffer* rings = nullptr;
+    void** data = nullptr;
+};
+
+// Multi-stream counterpart of ComputeGeneration, swapped the same way by computeStreams.
+struct StreamsGeneration {
+    StreamRings* rings = nullptr; // shared by generations until the streams change
+    float sampleRate = 0;
+    MultiStreamAnalyzer analyzer;
+};
+
+// Analysis of every input stream over one worker pool; results go to the analyzer's board.
+struct StreamsContext {
+    bool run = true;
+    int streams = 0;
+    std::atomic<StreamsGeneration*> next{nullptr};
+    std::atomic<StreamsGeneration*> current{nullptr};
+    Waiter waiter; // notified by every device callback
+    std::atomic<unsigned long> overruns{0}; // stream buffers lost because the workers fell behind
+    std::atomic<float> gateSkipped{0}, gateSaved{0}; // over every stream, while gated
+};
+
+static const char* const latencyExportPath = "chordy-latency.json";
+
+static long nextPow2(long x) {
+    long p = 1; while(p < x) p <<= 1;
+    return p;
+}
+
+static void freeComputeGeneration(ComputeGeneration* gen) {
+    if(gen == nullptr) return;
+    freeMirrorBuffer(gen->window);
+    freeChordConfig(gen->cfg);
+    freeChordGate(gen->gate);
+    freeChordComputePool(gen->pool);
+    if(gen->rBuffToGuiData) PaUtil_FreeMemory(gen->rBuffToGuiData);
+    if(gen->rBuffFreeFromGuiData) PaUtil_FreeMemory(gen->rBuffFreeFromGuiData);
+    delete gen;
+}
+
+// A generation for the current settings reading `input`; its window starts silent until the
+// compute thread carries the newest audio over. Null when out of memory.
+static ComputeGeneration* initComputeGeneration(const Settings& settings, PaContext* input, const ComputeContext& ctx) {
+    ComputeGeneration* gen = new ComputeGeneration();
+    gen->n = settings.samplesPerBuffer*settings.computeBufferCount;
+    gen->sampleRate = settings.sampleRate;
+    gen->samplesPerBuffer = settings.samplesPerBuffer;
+    gen->input = input;
+    if(!initMirrorBuffer(gen->window, gen->n)) { delete gen; return nullptr; }
+    ChordConfig& cfg = gen->cfg;
+    cfg = initChordConfig(gen->n, settings.sampleRate, settings.octaves, settings.threshold);
+    setChordVocabulary(cfg, settings.vocab);
+    cfg.hpsHarmonics = settings.hpsHarmonics;
+    setChordFftBackend(cfg, settings.fftBackend);
+    setChordFrontEnd(cfg, settings.frontEnd, settings.window, nullptr);
+    if(settings.smoothing) {
+        const int states = chordStateCount(cfg);
+        std::vector<float> trans(states*states);
+        fillStayTransitions(trans.data(), states, settings.smoothStay);
+        setChordSmoothing(cfg, settings.smoothLag, trans.data());
+        gen->smoothStay = settings.smoothStay;
+    }
+    cfg.log = ctx.log;
+    cfg.latency = ctx.latency;
+    gen->gate = initChordGate(cfg);
+
+    gen->rBuffToGuiData = PaUtil_AllocateZeroInitializedMemory(sizeof(ChordComputeData*)*settings.computeRingFrameCount);
+    // in flight at once: one slot being filled, the to-gui ring, and one slot on display
+    gen->pool = initChordComputePool(gen->n, chordStateCount(cfg), settings.computeRingFrameCount+2);
+    const long freeRingCount = nextPow2(gen->pool.capacity); // PaUtil rings need power-of-two element counts
+    gen->rBuffFreeFromGuiData = PaUtil_AllocateZeroInitializedMemory(sizeof(ChordComputeData*)*freeRingCount);
+    if(gen->rBuffToGuiData == nullptr || gen->rBuffFreeFromGuiData == nullptr) { freeComputeGeneration(gen); return nullptr; }
+    PaUtil_InitializeRingBuffer(&gen->rBuffToGui, sizeof(ChordComputeData*), settings.computeRingFrameCount, gen->rBuffToGuiData);
+    PaUtil_InitializeRingBuffer(&gen->rBuffFreeFromGui, sizeof(ChordComputeData*), freeRingCount, gen->rBuffFreeFromGuiData);
+    for(int i = 0; i < gen->pool.capacity; i++) {
+        ChordComputeData* slot = &gen->pool.slots[i];
+        PaUtil_WriteRingBuffer(&gen->rBuffFreeFromGui, &slot, 1);
+    }
+    return gen;
+}
+
+static void freeStreamRings(StreamRings* r) {
+    if(r == nullptr) return;
+    for(int s = 0; s < r->streams; s++) if(r->data[s]) PaUtil_FreeMemory(r->data[s]);
+    delete[] r->rings;
+    delete[] r->data;
+    delete r;
+}
+
+static StreamRings* initStreamRings(int streams, unsigned long samplesPerBuffer, int ringBufferCount) {
+    StreamRings* r = new StreamRings();
+    r->streams = streams;
+    r->samplesPerBuffer = samplesPerBuffer;
+    r->rings = new PaUtilRingBuffer[streams];
+    r->data = new void*[streams]();
+    for(int s = 0; s < streams; s++) {
+        r->data[s] = PaUtil_AllocateZeroInitializedMemory(sizeof(float) * samplesPerBuffer * ringBufferCount);
+        if(r->data[s] == nullptr) { freeStreamRings(r); return nullptr; }
+        PaUtil_InitializeRingBuffer(&r->rings[s], sizeof(float)*samplesPerBuffer, ringBufferCount, r->data[s]);
+    }
+    return r;
+}
+
+static void freeStreamsGeneration(StreamsGeneration* gen) {
+    if(gen == nullptr) return;
+    freeMultiStreamAnalyzer(gen->analyzer);
+    delete gen;
+}
+
+// Every stream analyzed with the current settings, reading `rings`.
+static StreamsGeneration* initStreamsGeneration(const Settings& settings, StreamRings* rings) {
+    StreamsGeneration* gen = new StreamsGeneration();
+    gen->rings = rings;
+    gen->sampleRate = settings.sampleRate;
+    const int n = settings.samplesPerBuffer*settings.computeBufferCount;
+    ChordConfig proto = initChordConfig(n, settings.sampleRate, settings.octaves, settings.threshold);
+    setChordVocabulary(proto, settings.vocab);
+    proto.hpsHarmonics = settings.hpsHarmonics;
+    setChordFrontEnd(proto, settings.frontEnd, settings.window, nullptr);
+    setChordFftBackend(proto, settings.fftBackend);
+    std::vector<float> trans(chordStateCount(proto)*chordStateCount(proto));
+    fillStayTransitions(trans.data(), chordStateCount(proto), settings.smoothStay);
+    gen->analyzer = initMultiStreamAnalyzer(rings->streams, settings.streamWorkers, std::min(settings.hopSamples, n), proto, settings.smoothing ? settings.smoothLag : -1, trans.data());
+    if(settings.gate) setStreamGating(gen->analyzer, true);
+    freeChordConfig(proto);
+    return gen;
+}
+
+// One context per device, feeding `channels` consecutive streams of `rings`; the first device
+// also tees its first channel into `focus`.
+static void initDeviceContexts(std::vector<DeviceContext>& devices, int count, int channels, StreamRings* rings, PaContext* focus, StreamsContext& ctx) {
+    devices.resize(count);
+    for(int d = 0; d < count; d++) {
+        DeviceContext& dev = devices[d];
+        dev.focus = d == 0 ? focus : nullptr;
+        dev.firstStream = d*channels;
+        dev.channels = channels;
+        dev.streamRings = rings->rings;
+        dev.planes = new float*[channels];
+        dev.claimed = new unsigned char[channels];
+        dev.drop = new float[channels*rings->samplesPerBuffer];
+        dev.waiter = &ctx.waiter;
+        dev.overruns = &ctx.overruns;
+    }
+}
+
+static void freeDeviceContexts(std::vector<DeviceContext>& devices) {
+    for(auto& dev : devices) { delete[] dev.planes; delete[] dev.claimed; delete[] dev.drop; }
+    devices.clear();
+}
+
 void compute(Settings &settings, ComputeContext &ctx){
-    int n = settings.samplesPerBuffer*settings.computeBufferCount;
-    float* readData = (float*)PaUtil_AllocateZeroInitializedMemory(sizeof(float)*n*settings.computeRingFrameCount);
-    ChordConfig cfg = initChordConfig(n, settings.sampleRate, settings.octaves, settings.threshold);
+    ComputeGeneration* gen = ctx.current.load(std::memory_order_acquire);
+    long sinceHop = 0; // samples since the last analyzed hop boundary
+    long pushed = 0; // samples analyzed by this generation, for the event times
+    double pushedTime = 0; // seconds analyzed by earlier generations
     auto st = std::chrono::high_resolution_clock::now(); auto end = st;
     double dt = 0;
+    ChordComputeData* pt = nullptr; // slot owned by this thread, kept if the gui ring was full
+    bool warm = false; unsigned long warmAllocations = 0;
+    bool waited = false;
+    FrontEnd frontEnd = gen->cfg.frontEnd; WindowType windowType = gen->cfg.window;
+    float smoothStay = gen->smoothStay;
+    bool gating = false;
     while(ctx.run) {
-        int available = PaUtil_GetRingBufferReadAvailable(&ctx.rBuffFromGui);
+        const unsigned seen = ctx.waiter.seq.load(std::memory_order_acquire);
+        if(ComputeGeneration* next = ctx.next.exchange(nullptr, std::memory_order_acq_rel)) {
+            // between jobs: carry the newest audio over so the new window isn't silent (a new
+            // rate starts afresh), then run on the new generation and let the gui free the old
+            if(next->sampleRate == gen->sampleRate) {
+                const long keep = std::min(gen->n, next->n);
+                writeMirrorBuffer(next->window, mirrorBufferTail(gen->window, keep), keep);
+            }
+            resetChordStream(next->cfg, mirrorBufferTail(next->window, next->n));
+            pushedTime += pushed/gen->sampleRate; pushed = 0;
+            pt = nullptr; // belongs to the old pool
+            gen = next;
+            frontEnd = gen->cfg.frontEnd; windowType = gen->cfg.window; smoothStay = gen->smoothStay;
+            gating = false; // the new gate starts empty
+            ctx.current.store(gen, std::memory_order_release);
+            warm = false;
+        }
+        ChordConfig& cfg = gen->cfg;
+        const long n = gen->n, samplesPerBuffer = gen->samplesPerBuffer;
+        PaUtilRingBuffer* rBuffFromRT = &gen->input->rBuffToCompute;
+        PaUtilRingBuffer* rStampsFromRT = &gen->input->rStampsToCompute;
+        int available = PaUtil_GetRingBufferReadAvailable(rBuffFromRT);
         if(available > 0){
-            st = std::chrono::high_resolution_clock::now();
-            PaUtil_ReadRingBuffer(&ctx.rBuffFromGui, readData, available);
-            float* samples = &readData[n*(available-1)];
-            ChordComputeData* pt = initChordComputeData(n); 
-            pt->dt = dt;
-
-            cfg.octaves = settings.octaves; cfg.threshold = settings.threshold;
-            computeChord(*pt, samples, cfg);
-            PaUtil_WriteRingBuffer(&ctx.rBuffToGui, &pt, 1);
-            end = std::chrono::high_resolution_clock::now();
-            dt = std::chrono::duration<double, std::milli>(end-st).count(); // ms 
+            if(waited) { recordWake(ctx.waitStats, ctx.waiter); waited = false; }
+            const long hop = std::max(1L, std::min((long)settings.hopSamples, n));
+            if(sinceHop >= hop) sinceHop = 0; // hop or window shrunk live
+            if(settings.frontEnd != frontEnd || settings.window != windowType) {
+                frontEnd = settings.frontEnd; windowType = settings.window;
+                setChordFrontEnd(cfg, frontEnd, windowType, mirrorBufferTail(gen->window, n));
+                warm = false; // the sliding state is allocated here, not per job
+            }
+            if(settings.fftBackend != cfg.fftBackend) {
+                setChordFftBackend(cfg, settings.fftBackend);
+                warm = false; // first use of a backend builds its plan
+            }
+            const int smoothLag = settings.smoothing ? settings.smoothLag : -1;
+            if(smoothLag != (cfg.smoother ? cfg.smoother->lag : -1) || (smoothLag >= 0 && settings.smoothStay != smoothStay)) {
+                smoothStay = settings.smoothStay;
+                const int states = chordStateCount(cfg);
+                std::vector<float> trans(states*states);
+                fillStayTransitions(trans.data(), states, smoothStay);
+                setChordSmoothing(cfg, smoothLag, trans.data());
+                warm = false; // the decoder is allocated here, not per job
+            }
+
+            void* regions[2]; ring_buffer_size_t counts[2];
+            PaUtil_GetRingBufferReadRegions(rBuffFromRT, available, &regions[0], &counts[0], &regions[1], &counts[1]);
+            // the stamp ring advances in lockstep with the audio ring, so it splits the same way
+            void* stampRegions[2]; ring_buffer_size_t stampCounts[2];
+            PaUtil_GetRingBufferReadRegions(rStampsFromRT, available, &stampRegions[0], &stampCounts[0], &stampRegions[1], &stampCounts[1]);
+            const long long pickupNs = steadyNowNs();
+            for(int r = 0; r < 2; r++) {
+                for(int b = 0; b < stampCounts[r]; b++) recordLatency(*ctx.latency, LatencyStage::CallbackToCompute, pickupNs - ((BufferStamp*)stampRegions[r])[b].callbackNs);
+            }
+            for(int r = 0; r < 2; r++) {
+                const float* x = (const float*)regions[r];
+                const BufferStamp* stamps = (const BufferStamp*)stampRegions[r];
+                long left = counts[r]*samplesPerBuffer;
+                while(left > 0) {
+                    // write up to the next hop boundary, then analyze the window ending there
+                    const long take = std::min(left, hop - sinceHop);
+                    writeMirrorBuffer(gen->window, x, take);
+                    pushChordSamples(cfg, x, take);
+                    pushed += take;
+                    x += take; left -= take; sinceHop += take;
+                    if(sinceHop < hop) break;
+                    sinceHop = 0;
+                    // ADC time of the newest sample in the window
+                    const long last = x - 1 - (const float*)regions[r];
+                    const long long adcNs = stamps[last/samplesPerBuffer].adcNs + (long long)(last%samplesPerBuffer*1e9/gen->sampleRate);
+
+                    st = std::chrono::high_resolution_clock::now();
+                    if(pt == nullptr && PaUtil_ReadRingBuffer(&gen->rBuffFreeFromGui, &pt, 1) == 0) {
+                        ctx.droppedJobs++;
+                        continue;
+                    }
+                    pt->dt = dt;
+
+                    if(settings.octaves != cfg.octaves) {
+                        setChordChroma(cfg, settings.octaves, cfg.filterbank.shape);
+                        warm = false; // the filterbank is rebuilt here, not per job
+                    }
+                    cfg.threshold = settings.threshold;
+                    cfg.hpsHarmonics = settings.hpsHarmonics;
+                    cfg.streamTime = pushedTime + pushed/gen->sampleRate;
+                    if(settings.gate != gating) {
+                        // ungated jobs rewrote the slots, so the gate starts over
+                        gating = settings.gate;
+                        resetChordGate(*gen->gate);
+                        gen->gate->stats = ChordGateStats();
+                    }
+                    if(gating) {
+                        gatedComputeChord(*gen->gate, *pt, mirrorBufferTail(gen->window, n), hop, cfg);
+                        ctx.gateSkipped = chordGateSkipRatio(gen->gate->stats);
+                        ctx.gateSaved = chordGateSavedRatio(gen->gate->stats);
+                    } else computeChord(*pt, mirrorBufferTail(gen->window, n), cfg);
+                    pt->adcNs = adcNs;
+                    pt->publishNs = steadyNowNs(); // the slot belongs to the gui once written
+                    if(ctx.feed) {
+                        ChordEvent ev;
+                        ev.time = cfg.streamTime;
+                        ev.score = pt->score; ev.f0 = pt->f0;
+                        ev.label = pt->label; ev.raw = pt->chord;
+                        selectTopChords(ev, pt->scores, cfg.vocab.chords, cfg.order.data());
+                        publishChordFeed(*ctx.feed, ev, pt->chroma, adcNs);
+                    }
+                    if(PaUtil_WriteRingBuffer(&gen->rBuffToGui, &pt, 1) == 1) {
+                        recordLatency(*ctx.latency, LatencyStage::AdcToLabel, pt->publishNs - adcNs);
+                        pt = nullptr;
+                    }
+                    end = std::chrono::high_resolution_clock::now();
+                    dt = std::chrono::duration<double, std::milli>(end-st).count(); // ms 
+                    recordJob(ctx.waitStats, std::chrono::duration_cast<std::chrono::nanoseconds>(end-st).count());
+
+                    if(!warm) { warm = true; warmAllocations = threadAllocationCount(); }
+                    ctx.steadyAllocations = threadAllocationCount() - warmAllocations;
+                }
+            }
+            PaUtil_AdvanceRingBufferReadIndex(rStampsFromRT, available);
+            PaUtil_AdvanceRingBufferReadIndex(rBuffFromRT, available);
+        } else {
+            waitWaiter(ctx.waiter, settings.waitPolicy, seen, settings.spinMicros);
+            waited = true;
         }
     }
+}
+
+// Follows the live settings that are cheap to change per run; the front end and smoothing
+// are fixed when a generation is built, and a new rate, buffer or window swaps the generation.
+void computeStreams(Settings &settings, StreamsContext &ctx) {
+    StreamsGeneration* gen = ctx.current.load(std::memory_order_acquire);
+    std::vector<StreamBlock> blocks(ctx.streams);
+    std::vector<ring_buffer_size_t> taken(ctx.streams);
+    while(ctx.run) {
+        const unsigned seen = ctx.waiter.seq.load(std::memory_order_acquire);
+        if(StreamsGeneration* next = ctx.next.exchange(nullptr, std::memory_order_acq_rel)) {
+            if(next->sampleRate == gen->sampleRate) carryStreamState(next->analyzer, gen->analyzer);
+            gen = next;
+            ctx.current.store(gen, std::memory_order_release);
+        }
+        MultiStreamAnalyzer& m = gen->analyzer;
+        PaUtilRingBuffer* rings = gen->rings->rings;
+        bool any = false;
+        for(int s = 0; s < ctx.streams; s++) {
+            void* regions[2]; ring_buffer_size_t counts[2];
+            taken[s] = PaUtil_GetRingBufferReadRegions(&rings[s], PaUtil_GetRingBufferReadAvailable(&rings[s]), &regions[0], &counts[0], &regions[1], &counts[1]);
+            for(int r = 0; r < 2; r++) {
+                blocks[s].parts[r] = (const float*)regions[r];
+                blocks[s].counts[r] = counts[r]*gen->rings->samplesPerBuffer;
+            }
+            any |= taken[s] > 0;
+        }
+        if(!any) {
+            waitWaiter(ctx.waiter, settings.waitPolicy, seen, settings.spinMicros);
+            continue;
+        }
+        m.hop = std::max(1, std::min(settings.hopSamples, m.n));
+        if(settings.gate != (m.state[0].gate != nullptr)) setStreamGating(m, settings.gate);
+        for(StreamState& st : m.state) {
+            if(settings.octaves != st.cfg.octaves) setChordChroma(st.cfg, settings.octaves, st.cfg.filterbank.shape);
+            st.cfg.threshold = settings.threshold;
+            st.cfg.hpsHarmonics = settings.hpsHarmonics;
+        }
+        analyzeStreams(m, blocks.data());
+        if(settings.gate) {
+            const ChordGateStats gs = streamGateStats(m);
+            ctx.gateSkipped = chordGateSkipRatio(gs);
+            ctx.gateSaved = chordGateSavedRatio(gs);
+        }
+        for(int s = 0; s < ctx.streams; s++) PaUtil_AdvanceRingBufferReadIndex(&rings[s], taken[s]);
+    }
+}
+
+static void closeInputs(std::vector<PaStream*>& streams) {
+    for(PaStream* stream : streams) {
+        const PaError paErr = Pa_CloseStream(stream); // stops first; no callback runs after this
+        if(paErr != paNoError) pa_error_handler(paErr);
+    }
+    streams.clear();
+}
 
-    if(readData) PaUtil_FreeMemory(readData);
-    freeChordConfig(cfg);
+// Opens and starts one input stream per device at the current rate and buffer size: mono into
+// `paCtx`, or every channel into the device contexts when several streams are analyzed.
+static PaError openInputs(const Settings& settings, bool multiStream, PaContext* paCtx, std::vector<DeviceContext>& devices, std::vector<PaStream*>& streams) {
+    for(size_t d = 0; d < settings.devices.size(); d++) {
+        PaStreamParameters inputParams;
+        inputParams.device = settings.devices[d];
+        if(inputParams.device == paNoDevice || inputParams.device < 0 || inputParams.device >= Pa_GetDeviceCount()) return paDeviceUnavailable;
+        if(Pa_GetDeviceInfo(inputParams.device)->maxInputChannels < settings.channels) return paInvalidChannelCount;
+        inputParams.channelCount = multiStream ? settings.channels : 1; // interleaved, split in the callback
+        inputParams.sampleFormat = paFloat32;
+        inputParams.suggestedLatency = Pa_GetDeviceInfo(inputParams.device)->defaultLowInputLatency;
+        inputParams.hostApiSpecificStreamInfo = nullptr;
+
+        PaStream* stream;
+        PaError paErr;
+        const PaStreamFlags paFlags = paDitherOff;
+        if(multiStream) paErr = Pa_OpenStream(&stream, &inputParams, nullptr, settings.sampleRate, settings.samplesPerBuffer, paFlags, deviceCallback, &devices[d]);
+        else paErr = Pa_OpenStream(&stream, &inputParams, nullptr, settings.sampleRate, settings.samplesPerBuffer, paFlags, paCallback, paCtx);
+        if(paErr != paNoError) return paErr;
+        streams.push_back(stream);
+    }
+    for(PaStream* stream : streams) {
+        const PaError paErr = Pa_StartStream(stream);
+        if(paErr != paNoError) return paErr;
+    }
+    return paNoError;
+}
+
+// Waveform history: the raw samples for short views and their min/max pyramid for long ones,
+// so the plot draws about two points per pixel whatever the length.
+struct DisplayHistory {
+    long samples = 0;
+    MirrorBuffer raw; // the plot reads a contiguous view of its tail
+    MinMaxPyramid envelope;
+};
+
+static void pushDisplay(DisplayHistory& d, const float* x, long count) {
+    writeMirrorBuffer(d.raw, x, count); // samples >= one ring of buffers
+    pushMinMaxPyramid(d.envelope, x, count);
+}
+
+// Resizes the history to `samples`. With `keep` (same rate) the newest samples that still fit
+// are carried over.
+static bool resizeDisplay(DisplayHistory& d, long samples, bool keep) {
+    DisplayHistory next;
+    next.samples = samples;
+    if(!initMirrorBuffer(next.raw, samples)) return false;
+    initMinMaxPyramid(next.envelope, samples);
+    if(keep && d.raw.data) {
+        const long carried = std::min(samples, d.samples);
+        pushDisplay(next, mirrorBufferTail(d.raw, carried), carried);
+    }
+    if(d.raw.data) freeMirrorBuffer(d.raw);
+    d = std::move(next);
+    return true;
+}
+
+// Min/max decimation of a spectrum's first `bins` bins (binHz apart) to about two points per
+// pixel, plotted as one line.
+static void plotSpectrum(const char* label, const float* spec, long bins, float binHz, long pixels, std::vector<float>& scratch) {
+    scratch.resize(2*pixels + 2);
+    long values;
+    const long bucket = decimateMinMax(spec, bins, 2*pixels, scratch.data(), values);
+    ImPlot::PlotLine(label, scratch.data(), values, bucket == 1 ? binHz : bucket*binHz/2);
 }
 
 int gui(int argc, char* argv[])
 {
     Settings settings; 
+    defaultChordVocabulary(settings.vocab);
+    std::string feedName;
+    for(int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        if(a == "--channels" && i+1 < argc) settings.channels = std::max(1, atoi(argv[++i]));
+        else if(a == "--device" && i+1 < argc) settings.devices.push_back(atoi(argv[++i]));
+        else if(a == "--stream-workers" && i+1 < argc) settings.streamWorkers = atoi(argv[++i]);
+        else if(a == "--feed" && i+1 < argc) feedName = argv[++i];
+        else { fprintf(stderr, "usage: %s [--channels N] [--device IDX]... [--stream-workers N] [--feed NAME]\n", argv[0]); return 1; }
+    }
+    std::string vocabFile = std::filesystem::path(argv[0]).parent_path() / "res/chords.txt";
+    std::string vocabError;
+    if(std::filesystem::exists(vocabFile) && !loadChordVocabulary(settings.vocab, vocabFile, vocabError)) {
+        fprintf(stderr, "%s, using major/minor triads\n", vocabError.c_str());
+    }
 
     glfwSetErrorCallback(glfw_error_callback);
     if (!glfwInit())
@@ -181,45 +767,53 @@ int gui(int argc, char* argv[])
     paErr = Pa_Initialize();
     if(paErr != paNoError) return pa_error_handler(paErr);
 
-    PaContext paCtx;
-    paCtx.rBuffFromRTData = PaUtil_AllocateZeroInitializedMemory(sizeof(float) * settings.samplesPerBuffer * settings.ringBufferCount);
-    if(paCtx.rBuffFromRTData == nullptr) return 1;
-    PaUtil_InitializeRingBuffer(&paCtx.rBuffFromRT, sizeof(float)*settings.samplesPerBuffer, settings.ringBufferCount, paCtx.rBuffFromRTData);
-    float* readData = (float*)PaUtil_AllocateZeroInitializedMemory(sizeof(float)*settings.samplesPerBuffer*settings.ringBufferCount);
-    float* displayData = (float*)PaUtil_AllocateZeroInitializedMemory(sizeof(float)*settings.displayBufferCount*settings.samplesPerBuffer);
-    float* tmpData = (float*)PaUtil_AllocateZeroInitializedMemory(sizeof(float)*settings.displayBufferCount*settings.samplesPerBuffer);
-    int displayWriteInd = 0;
-    float xDisplay[settings.samplesPerBuffer*settings.displayBufferCount], xRead[settings.samplesPerBuffer*settings.ringBufferCount], xSpec[settings.samplesPerBuffer*settings.computeBufferCount];
-    for(int i = 0; i < settings.samplesPerBuffer*settings.displayBufferCount; i++){
-        xDisplay[i] = (i-settings.displayBufferCount*(long)settings.samplesPerBuffer)*1.f/settings.sampleRate;
-        if(i < settings.samplesPerBuffer*settings.ringBufferCount) xRead[i] = xDisplay[i];
-        if(i < settings.samplesPerBuffer*settings.computeBufferCount) xSpec[i] = i*settings.sampleRate*1.f/(settings.samplesPerBuffer*settings.computeBufferCount*1.f);
+    LatencyProbe* latency = new LatencyProbe(); // ~100 KB of counters, shared by every thread
+    ComputeContext computeCtx;
+    computeCtx.latency = latency;
+    computeCtx.log = openEventLog("-", settings.logLevel, EventFormat::JsonLines, settings.vocab);
+    if(!feedName.empty()) {
+        computeCtx.feed = openChordFeed(feedName, settings.vocab);
+        if(computeCtx.feed == nullptr) { perror(feedName.c_str()); return 1; }
     }
-
-    PaStreamParameters inputParams;
-    inputParams.device = Pa_GetDefaultInputDevice();
-    if(inputParams.device == paNoDevice) return pa_error_handler(PaErrorCode::paDeviceUnavailable);
-    inputParams.channelCount = 1; // record in mono
-    inputParams.sampleFormat = paFloat32;
-    inputParams.suggestedLatency = Pa_GetDeviceInfo(inputParams.device)->defaultLowInputLatency;
-    inputParams.hostApiSpecificStreamInfo = nullptr;
-
-    PaStream* stream;    
-    const PaStreamFlags paFlags = paDitherOff;
-    paErr = Pa_OpenStream(&stream, &inputParams, nullptr, settings.sampleRate, settings.samplesPerBuffer, paFlags, paCallback, &paCtx);
-    if(paErr != paNoError) return pa_error_handler(paErr);
-    paErr = Pa_StartStream(stream);
-    if(paErr != paNoError) return pa_error_handler(paErr);
+    PaContext* paCtx = initPaContext(settings.samplesPerBuffer, settings.ringBufferCount, &computeCtx.waiter, latency);
+    if(paCtx == nullptr) return 1;
+    DisplayHistory display;
+    if(!resizeDisplay(display, settings.displayBufferCount*settings.samplesPerBuffer, false)) return 1;
+    std::vector<float> plotValues; // decimated points of the plot being drawn
 
     // initialize compute thread
-    ComputeContext computeCtx;
-    ChordComputeData* chordComputeData;
-    computeCtx.rBuffFromGuiData = PaUtil_AllocateZeroInitializedMemory(sizeof(float)*settings.samplesPerBuffer*settings.computeBufferCount*settings.computeRingFrameCount);
-    PaUtil_InitializeRingBuffer(&computeCtx.rBuffFromGui, sizeof(float)*settings.samplesPerBuffer*settings.computeBufferCount, settings.computeRingFrameCount, computeCtx.rBuffFromGuiData);
-    computeCtx.rBuffToGuiData = PaUtil_AllocateZeroInitializedMemory(sizeof(ChordComputeData*)*settings.computeRingFrameCount);
-    PaUtil_InitializeRingBuffer(&computeCtx.rBuffToGui, sizeof(ChordComputeData*), settings.computeRingFrameCount, computeCtx.rBuffToGuiData);
+    ChordComputeData* chordComputeData = nullptr;
+    float chroma[12] = {}; // chordComputeData's chroma as shares of its sum; the slot itself stays as published
+    ComputeGeneration* shownGen = initComputeGeneration(settings, paCtx, computeCtx); // chordComputeData is one of its slots
+    ComputeGeneration* pendingGen = nullptr; // handed to the compute thread, not yet current
+    if(shownGen == nullptr) return 1;
+    computeCtx.current = shownGen;
     std::thread computeThread(compute, std::ref(settings), std::ref(computeCtx));
 
+    // one mono default input keeps the single-stream path; anything else opens every device
+    // with `channels` channels and analyzes each channel as a stream
+    if(settings.devices.empty()) settings.devices.push_back(Pa_GetDefaultInputDevice());
+    const bool multiStream = settings.devices.size() > 1 || settings.channels > 1;
+    StreamsContext streamsCtx;
+    StreamRings* streamRings = nullptr; // the devices write here
+    StreamsGeneration* shownStreamsGen = nullptr, *pendingStreamsGen = nullptr;
+    std::vector<DeviceContext> devices;
+    std::vector<PaStream*> streams;
+    std::thread streamsThread;
+    if(multiStream) {
+        streamsCtx.streams = settings.devices.size()*settings.channels;
+        streamRings = initStreamRings(streamsCtx.streams, settings.samplesPerBuffer, settings.ringBufferCount);
+        if(streamRings == nullptr) return 1;
+        shownStreamsGen = initStreamsGeneration(settings, streamRings);
+        streamsCtx.current = shownStreamsGen;
+        initDeviceContexts(devices, settings.devices.size(), settings.channels, streamRings, paCtx, streamsCtx);
+        streamsThread = std::thread(computeStreams, std::ref(settings), std::ref(streamsCtx));
+    }
+
+    paErr = openInputs(settings, multiStream, paCtx, devices, streams);
+    if(paErr != paNoError) return pa_error_handler(paErr);
+
+
     ImFont* fontSm, *fontMd, *fontLg; 
     auto execPath = std::filesystem::path(argv[0]).parent_path();
     std::string fontFile = execPath / "res/font.ttf";
@@ -232,7 +826,13 @@ int gui(int argc, char* argv[])
     }
      
     // state 
-    GuiState state; state.threshold = settings.threshold; state.octaves = settings.octaves;
+    GuiState state; state.threshold = settings.threshold; state.octaves = settings.octaves; state.waitPolicy = (int)settings.waitPolicy; state.hopSamples = settings.hopSamples; state.logLevel = (int)settings.logLevel;
+    state.frontEnd = (int)settings.frontEnd; state.window = (int)settings.window; state.fftBackend = (int)settings.fftBackend;
+    state.hpsHarmonics = settings.hpsHarmonics;
+    state.smoothing = settings.smoothing; state.smoothLag = settings.smoothLag; state.smoothStay = settings.smoothStay;
+    state.gate = settings.gate;
+    state.sampleRate = settings.sampleRate; state.samplesPerBuffer = settings.samplesPerBuffer;
+    state.computeBufferCount = settings.computeBufferCount; state.displayBufferCount = settings.displayBufferCount;
     // Main loop
 #ifdef __EMSCRIPTEN__
     // For an Emscripten build we are disabling file-system access, so let's not attempt to do a fopen() of the imgui.ini file.
@@ -243,42 +843,127 @@ int gui(int argc, char* argv[])
     while (!glfwWindowShouldClose(window))
 #endif
     {
-        paErr = Pa_IsStreamActive(stream); // 1 if active
+        paErr = streams.empty() ? paNotInitialized : Pa_IsStreamActive(streams[0]); // 1 if active
         if(paErr != paNoError && paErr != 1) {
             fprintf(stderr, "Gui window running, but stream is not active.");
             break;
         }
         
-        auto available = PaUtil_GetRingBufferReadAvailable(&paCtx.rBuffFromRT);
-        PaUtil_ReadRingBuffer(&paCtx.rBuffFromRT, (void*)readData, available);
-        available *= settings.samplesPerBuffer;
-        
+        auto available = PaUtil_GetRingBufferReadAvailable(&paCtx->rBuffFromRT);
         if(available > 0){
-            int countRight = settings.displayBufferCount*settings.samplesPerBuffer-displayWriteInd, countLeft = 0;
-            if(available > countRight){
-                countLeft = available - countRight; // ensure that settings.displayBufferCount >= settings.ringBufferCount
-                memcpy(&tmpData[displayWriteInd], readData, sizeof(float)*countRight);
-                memcpy(&tmpData[0], &readData[countRight], sizeof(float)*countLeft);
-                displayWriteInd = countLeft;
-            } else {
-                countRight = available;
-                memcpy(&tmpData[displayWriteInd], readData, sizeof(float)*countRight);
-                displayWriteInd += countRight;
+            // straight from the ring's storage into the mirror: one copy per sample
+            void* regions[2]; ring_buffer_size_t counts[2];
+            PaUtil_GetRingBufferReadRegions(&paCtx->rBuffFromRT, available, &regions[0], &counts[0], &regions[1], &counts[1]);
+            for(int r = 0; r < 2; r++) pushDisplay(display, (const float*)regions[r], counts[r]*settings.samplesPerBuffer);
+            const long long pickupNs = steadyNowNs();
+            PaUtil_GetRingBufferReadRegions(&paCtx->rStampsFromRT, available, &regions[0], &counts[0], &regions[1], &counts[1]);
+            for(int r = 0; r < 2; r++) {
+                for(int b = 0; b < counts[r]; b++) recordLatency(*latency, LatencyStage::CallbackToDisplay, pickupNs - ((BufferStamp*)regions[r])[b].callbackNs);
             }
+            PaUtil_AdvanceRingBufferReadIndex(&paCtx->rStampsFromRT, available);
+            PaUtil_AdvanceRingBufferReadIndex(&paCtx->rBuffFromRT, available);
+        }
 
-            memcpy(displayData, &tmpData[displayWriteInd], sizeof(float)*(settings.displayBufferCount*settings.samplesPerBuffer-displayWriteInd));
-            memcpy(&displayData[settings.samplesPerBuffer*settings.displayBufferCount-displayWriteInd], tmpData, sizeof(float)*displayWriteInd);
-            PaUtil_WriteRingBuffer(&computeCtx.rBuffFromGui, &displayData[settings.samplesPerBuffer*(settings.displayBufferCount-settings.computeBufferCount)], 1);
+        // once an analysis thread runs on a new generation nothing reads the old one: free it,
+        // with its tap or rings when the streams changed too
+        ComputeGeneration* runningGen = computeCtx.current.load(std::memory_order_acquire);
+        if(runningGen != shownGen) {
+            chordComputeData = nullptr; // a slot of the old pool; the label text stays up
+            if(shownGen->input != runningGen->input) freePaContext(shownGen->input);
+            freeComputeGeneration(shownGen);
+            shownGen = runningGen;
+            pendingGen = nullptr;
         }
-        
-        available = PaUtil_GetRingBufferReadAvailable(&computeCtx.rBuffToGui);
+        if(multiStream) {
+            StreamsGeneration* runningStreamsGen = streamsCtx.current.load(std::memory_order_acquire);
+            if(runningStreamsGen != shownStreamsGen) {
+                if(shownStreamsGen->rings != runningStreamsGen->rings) freeStreamRings(shownStreamsGen->rings);
+                freeStreamsGeneration(shownStreamsGen);
+                shownStreamsGen = runningStreamsGen;
+                pendingStreamsGen = nullptr;
+            }
+        }
+
+        available = PaUtil_GetRingBufferReadAvailable(&shownGen->rBuffToGui);
         if(available > 0) {
-            if(chordComputeData) freeChordComputeData(chordComputeData);
-            while(available--) PaUtil_ReadRingBuffer(&computeCtx.rBuffToGui, &chordComputeData, 1);
+            while(available--) {
+                ChordComputeData* next;
+                PaUtil_ReadRingBuffer(&shownGen->rBuffToGui, &next, 1);
+                recordLatency(*latency, LatencyStage::ComputeToDisplay, steadyNowNs() - next->publishNs);
+                if(chordComputeData) PaUtil_WriteRingBuffer(&shownGen->rBuffFreeFromGui, &chordComputeData, 1);
+                chordComputeData = next;
+            }
             
             state.chordName = chordComputeData->name;
             float sm = 0; for(int p = 0; p < 12; p++) sm += chordComputeData->chroma[p];
-            for(int p = 0; p < 12; p++) chordComputeData->chroma[p] /= sm; // convert to relative chroma
+            for(int p = 0; p < 12; p++) chroma[p] = sm > 0 ? chordComputeData->chroma[p]/sm : 0.f; // relative chroma
+        }
+
+        // Audio reconfiguration, one change at a time: everything sized by the new rate, buffer
+        // or window is built here, off the hot path, and the analysis threads swap it in between
+        // jobs. A new rate or buffer size also needs new streams, so the devices restart once
+        // (before the swap, after everything else is built); if they refuse the new shape the
+        // old streams are reopened and the change is rolled back.
+        const bool audioChanged = state.sampleRate != settings.sampleRate || state.samplesPerBuffer != (int)settings.samplesPerBuffer;
+        const bool windowChanged = state.computeBufferCount != settings.computeBufferCount;
+        if((audioChanged || windowChanged) && pendingGen == nullptr && pendingStreamsGen == nullptr) {
+            const float oldRate = settings.sampleRate;
+            const unsigned long oldBuffer = settings.samplesPerBuffer;
+            const int oldCount = settings.computeBufferCount;
+            settings.sampleRate = state.sampleRate;
+            settings.samplesPerBuffer = state.samplesPerBuffer;
+            settings.computeBufferCount = state.computeBufferCount;
+            PaContext* input = audioChanged ? initPaContext(settings.samplesPerBuffer, settings.ringBufferCount, &computeCtx.waiter, latency) : paCtx;
+            StreamRings* rings = multiStream && audioChanged ? initStreamRings(streamsCtx.streams, settings.samplesPerBuffer, settings.ringBufferCount) : streamRings;
+            ComputeGeneration* gen = input ? initComputeGeneration(settings, input, computeCtx) : nullptr;
+            StreamsGeneration* streamsGen = multiStream && rings ? initStreamsGeneration(settings, rings) : nullptr;
+            bool ok = gen && (!multiStream || streamsGen);
+            if(!ok) state.audioError = "out of memory";
+            if(ok && audioChanged) {
+                closeInputs(streams);
+                std::vector<DeviceContext> nextDevices;
+                if(multiStream) initDeviceContexts(nextDevices, settings.devices.size(), settings.channels, rings, input, streamsCtx);
+                input->display = state.display;
+                paErr = openInputs(settings, multiStream, input, nextDevices, streams);
+                if(paErr == paNoError) {
+                    freeDeviceContexts(devices);
+                    devices.swap(nextDevices);
+                    paCtx = input;
+                    streamRings = rings;
+                    resizeDisplay(display, settings.displayBufferCount*settings.samplesPerBuffer, settings.sampleRate == oldRate);
+                } else {
+                    closeInputs(streams);
+                    freeDeviceContexts(nextDevices);
+                    state.audioError = Pa_GetErrorText(paErr);
+                    ok = false;
+                    settings.sampleRate = oldRate; settings.samplesPerBuffer = oldBuffer;
+                    paErr = openInputs(settings, multiStream, paCtx, devices, streams);
+                    if(paErr != paNoError) { pa_error_handler(paErr); closeInputs(streams); } // the loop ends on the next frame
+                }
+            }
+            if(ok) {
+                settings.hopSamples = state.hopSamples = std::min(settings.hopSamples, gen->n);
+                pendingGen = gen;
+                computeCtx.next.store(gen, std::memory_order_release);
+                notifyWaiter(computeCtx.waiter);
+                if(multiStream) {
+                    pendingStreamsGen = streamsGen;
+                    streamsCtx.next.store(streamsGen, std::memory_order_release);
+                    notifyWaiter(streamsCtx.waiter);
+                }
+                state.audioError.clear();
+            } else {
+                freeComputeGeneration(gen);
+                freeStreamsGeneration(streamsGen);
+                if(input != paCtx) freePaContext(input);
+                if(rings != streamRings) freeStreamRings(rings);
+                settings.sampleRate = oldRate; settings.samplesPerBuffer = oldBuffer; settings.computeBufferCount = oldCount;
+                state.sampleRate = oldRate; state.samplesPerBuffer = oldBuffer; state.computeBufferCount = oldCount;
+            }
+        }
+        if(state.displayBufferCount != settings.displayBufferCount) {
+            if(resizeDisplay(display, state.displayBufferCount*settings.samplesPerBuffer, true)) settings.displayBufferCount = state.displayBufferCount;
+            else state.displayBufferCount = settings.displayBufferCount;
         }
 
         glfwPollEvents();
@@ -325,7 +1010,7 @@ int gui(int argc, char* argv[])
                 for(int p = 0; p < 12; p++) {
                     ImGui::SetCursorPosX((winSize.x-total)*0.5f+run);
                     ImGui::SetCursorPosY(notesY);
-                    ImGui::TextColored(alpha(settings.accentCol1, chordComputeData->chroma[p]*0.9+0.1), notes[p].c_str());
+                    ImGui::TextColored(alpha(settings.accentCol1, chroma[p]*0.9+0.1), notes[p].c_str());
                     run += ImGui::CalcTextSize(notes[p].c_str()).x+spacing;
                 }
                 if(fontMd) ImGui::PopFont();
@@ -352,7 +1037,12 @@ int gui(int argc, char* argv[])
             if (ImPlot::BeginPlot("Waveform", ImVec2(-1, winSize.y*plotWaveHeight), plotFlags)) { 
                 ImPlot::SetupAxes("Time", "Amplitude", plotAxisFlags, plotAxisFlags);
                 ImPlot::SetNextLineStyle(settings.accentCol1);
-                ImPlot::PlotLine("Audio", xDisplay, displayData, settings.displayBufferCount*settings.samplesPerBuffer);
+                // ~2 points per pixel from the pyramid, the raw samples when there are fewer
+                const long pixels = std::max(1.f, winSize.x);
+                plotValues.resize(4*pixels + 8);
+                const MinMaxSpan span = readMinMaxPyramid(display.envelope, display.samples, 2*pixels, plotValues.data());
+                if(span.values > 0) ImPlot::PlotLine("Audio", plotValues.data(), span.values, span.bucket/2./settings.sampleRate, -span.offset/settings.sampleRate);
+                else ImPlot::PlotLine("Audio", mirrorBufferTail(display.raw, display.samples), display.samples, 1./settings.sampleRate, -display.samples/settings.sampleRate);
                 ImPlot::EndPlot();
             }
             if(ImGui::BeginItemTooltip()) {
@@ -367,7 +1057,7 @@ int gui(int argc, char* argv[])
                 if (ImPlot::BeginPlot("Spectra", ImVec2(-1, winSize.y*plotSpecHeight), plotFlags)) {
                     ImPlot::SetupAxes("Frequency", "Power", plotAxisFlags, plotAxisFlags);
                     ImPlot::SetNextLineStyle(settings.accentCol2);
-                    ImPlot::PlotLine("Spectra", xSpec, chordComputeData->spec, settings.computeBufferCount*settings.samplesPerBuffer*settings.maxDisplayHz/settings.sampleRate);
+                    plotSpectrum("Spectra", chordComputeData->spec, shownGen->n*settings.maxDisplayHz/shownGen->sampleRate, shownGen->sampleRate/shownGen->n, winSize.x, plotValues);
                     ImPlot::EndPlot();
                 }
                 if(ImGui::BeginItemTooltip()) {
@@ -376,15 +1066,15 @@ int gui(int argc, char* argv[])
                 }
                 
                 ImGui::SetCursorPosY(winSize.y*(1-plotHPSHeight));
-                ImPlot::SetNextAxesLimits(0, settings.maxDisplayHz, 0, exp2(state.plotMxs[2]), ImPlotCond_Always); 
+                ImPlot::SetNextAxesLimits(0, settings.maxDisplayHz, 0, state.plotMxs[2], ImPlotCond_Always); 
                 if (ImPlot::BeginPlot("HPS", ImVec2(-1, winSize.y*plotHPSHeight), plotFlags)) {
                     ImPlot::SetupAxes("Frequency", "HPS", plotAxisFlags^ImPlotAxisFlags_NoTickLabels, plotAxisFlags);
                     ImPlot::SetNextLineStyle(settings.accentCol3);
-                    ImPlot::PlotLine("HPS", xSpec, chordComputeData->hps, settings.computeBufferCount*settings.samplesPerBuffer*settings.maxDisplayHz/settings.sampleRate);
+                    plotSpectrum("HPS", chordComputeData->hps, shownGen->n*settings.maxDisplayHz/shownGen->sampleRate, shownGen->sampleRate/shownGen->n, winSize.x, plotValues);
                     ImPlot::EndPlot();
                 }
                 if(ImGui::BeginItemTooltip()) {
-                    ImGui::SetTooltip("Harmonic Product Spectrum (Frequency Domain)");
+                    ImGui::SetTooltip("Harmonic Product Spectrum (Frequency Domain), mean log2 power over harmonics");
                     ImGui::EndTooltip();
                 }
             }
@@ -421,6 +1111,32 @@ int gui(int argc, char* argv[])
                 ImGui::TextColored(ImVec4(1, 1, 1, 1), "Main:    %.2f fps", io.Framerate);
                 if(chordComputeData){ 
                     ImGui::TextColored(ImVec4(1, 1, 1, 1), "Compute: %.2f ms/job", chordComputeData->dt);
+                    ImGui::TextColored(ImVec4(1, 1, 1, 1), "Allocs:  %lu steady, %lu dropped, %lu overruns", computeCtx.steadyAllocations.load(), computeCtx.droppedJobs.load(), paCtx->computeOverruns.load());
+                    ImGui::TextColored(ImVec4(1, 1, 1, 1), "Kernels: %s", simdLevelNames[(int)activeSimdLevel()]);
+                    if(chordComputeData->f0 > 0) {
+                        const int midi = freq2Midi(chordComputeData->f0);
+                        ImGui::TextColored(ImVec4(1, 1, 1, 1), "F0:      %.1f Hz (%s%d)", chordComputeData->f0, notes[midi%12].c_str(), midi/12-1);
+                    } else ImGui::TextColored(ImVec4(1, 1, 1, 1), "F0:      -");
+                    if(settings.smoothing) ImGui::TextColored(ImVec4(1, 1, 1, 1), "Smooth:  +%.1f ms label latency", 1e3*settings.smoothLag*settings.hopSamples/settings.sampleRate);
+                    if(settings.gate) ImGui::TextColored(ImVec4(1, 1, 1, 1), "Gate:    %.0f%% reused, %.0f%% analysis time saved", 100*computeCtx.gateSkipped.load(), 100*computeCtx.gateSaved.load());
+                    if(ImGui::BeginItemTooltip()) {
+                        ImGui::SetTooltip("Heap allocations on the compute thread after its first job (should stay 0),\njobs skipped because every result slot was in flight,\nand audio buffers lost because the compute thread fell behind.");
+                        ImGui::EndTooltip();
+                    }
+                    ImGui::TextColored(ImVec4(1, 1, 1, 1), "Wake:    %.1f us (max %.1f us)", computeCtx.waitStats.wakeLatencyUs.load(), computeCtx.waitStats.maxWakeLatencyUs.load());
+                    ImGui::TextColored(ImVec4(1, 1, 1, 1), "CPU:     %.1f%% (jobs %.1f%%)", computeCtx.waitStats.cpuPercent.load(), computeCtx.waitStats.busyPercent.load());
+                    if(ImGui::BeginItemTooltip()) {
+                        ImGui::SetTooltip("Compute thread CPU usage over the last second; anything above the job\nshare is burnt while idle by the wait policy.");
+                        ImGui::EndTooltip();
+                    }
+                    const LatencySummary e2e = summarizeLatency(latency->stages[(int)LatencyStage::AdcToLabel]);
+                    ImGui::TextColored(ImVec4(1, 1, 1, 1), "Label:   %.1f ms p99 after the ADC", e2e.p99Us/1e3);
+                    ImGui::Checkbox("Latency panel", &state.showLatency);
+                }
+                if(multiStream) {
+                    ImGui::TextColored(ImVec4(1, 1, 1, 1), "Streams: %d on %d workers, %lu overruns", streamsCtx.streams, workerPoolSize(shownStreamsGen->analyzer.pool), streamsCtx.overruns.load());
+                    if(settings.gate) ImGui::TextColored(ImVec4(1, 1, 1, 1), "         %.0f%% reused, %.0f%% analysis time saved", 100*streamsCtx.gateSkipped.load(), 100*streamsCtx.gateSaved.load());
+                    ImGui::Checkbox("Streams panel", &state.showStreams);
                 }
                 ImGui::Spacing(); ImGui::Separator(); ImGui::Spacing();
                 
@@ -449,6 +1165,145 @@ int gui(int argc, char* argv[])
                 }
                 ImGui::Spacing();
 
+                ImGui::TextColored(ImVec4(1, 1, 1, 1), "Harmonics");
+                if(ImGui::BeginItemTooltip()) {
+                    ImGui::SetTooltip("harmonics multiplied into the HPS for the F0 estimate.");
+                    ImGui::EndTooltip();
+                }
+                if(ImGui::SliderInt("##8", &state.hpsHarmonics, 1, 8, "%d", ImGuiSliderFlags_NoInput|ImGuiSliderFlags_AlwaysClamp)){
+                    settings.hpsHarmonics = state.hpsHarmonics;
+                }
+                ImGui::Spacing();
+
+                if(ImGui::Checkbox("Smoothing", &state.smoothing)){
+                    settings.smoothing = state.smoothing;
+                }
+                if(ImGui::BeginItemTooltip()) {
+                    ImGui::SetTooltip("Viterbi-smooth the labels: each is decided lag hops late, so transients can be overruled.");
+                    ImGui::EndTooltip();
+                }
+                if(ImGui::SliderInt("##9", &state.smoothLag, 0, 32, "lag %d", ImGuiSliderFlags_NoInput|ImGuiSliderFlags_AlwaysClamp)){
+                    settings.smoothLag = state.smoothLag;
+                }
+                if(ImGui::SliderFloat("##10", &state.smoothStay, 0.5, 0.99, "stay %.2f", ImGuiSliderFlags_NoInput|ImGuiSliderFlags_AlwaysClamp)){
+                    settings.smoothStay = state.smoothStay;
+                }
+                if(ImGui::BeginItemTooltip()) {
+                    ImGui::SetTooltip("probability of keeping the current chord from one hop to the next.");
+                    ImGui::EndTooltip();
+                }
+                ImGui::Spacing();
+
+                if(ImGui::Checkbox("Lazy analysis", &state.gate)){
+                    settings.gate = state.gate;
+                }
+                if(ImGui::BeginItemTooltip()) {
+                    ImGui::SetTooltip("only analyze a hop after an onset or a silence, repeating the last result while the sound holds.");
+                    ImGui::EndTooltip();
+                }
+                ImGui::Spacing();
+
+                ImGui::TextColored(ImVec4(1, 1, 1, 1), "Audio");
+                if(ImGui::BeginItemTooltip()) {
+                    ImGui::SetTooltip("Sample rate, buffer, analysis window and waveform length, applied live.\nA new rate or buffer restarts the input streams once.");
+                    ImGui::EndTooltip();
+                }
+                char label[64];
+                snprintf(label, sizeof(label), "%.0f Hz", state.sampleRate);
+                if(ImGui::BeginCombo("##12", label)) {
+                    for(float rate : sampleRateChoices) {
+                        snprintf(label, sizeof(label), "%.0f Hz", rate);
+                        if(ImGui::Selectable(label, rate == state.sampleRate)) state.sampleRate = rate;
+                    }
+                    ImGui::EndCombo();
+                }
+                snprintf(label, sizeof(label), "buffer %d", state.samplesPerBuffer);
+                if(ImGui::BeginCombo("##13", label)) {
+                    for(int buffer : bufferChoices) {
+                        snprintf(label, sizeof(label), "buffer %d", buffer);
+                        if(ImGui::Selectable(label, buffer == state.samplesPerBuffer)) {
+                            // keep the window length where possible
+                            const int n = state.samplesPerBuffer*state.computeBufferCount;
+                            state.samplesPerBuffer = buffer;
+                            state.computeBufferCount = std::max(1, std::min(std::max(n, minWindow)/buffer, state.displayBufferCount/2));
+                        }
+                    }
+                    ImGui::EndCombo();
+                }
+                snprintf(label, sizeof(label), "window %d (%.0f ms)", state.samplesPerBuffer*state.computeBufferCount, 1e3*state.samplesPerBuffer*state.computeBufferCount/state.sampleRate);
+                if(ImGui::BeginCombo("##14", label)) {
+                    for(int count = std::max(1, minWindow/state.samplesPerBuffer); count*state.samplesPerBuffer <= maxWindow && count < state.displayBufferCount; count *= 2) {
+                        snprintf(label, sizeof(label), "window %d (%.0f ms)", state.samplesPerBuffer*count, 1e3*state.samplesPerBuffer*count/state.sampleRate);
+                        if(ImGui::Selectable(label, count == state.computeBufferCount)) state.computeBufferCount = count;
+                    }
+                    ImGui::EndCombo();
+                }
+                snprintf(label, sizeof(label), "waveform %.2f s", state.displayBufferCount*state.samplesPerBuffer/state.sampleRate);
+                if(ImGui::BeginCombo("##15", label)) {
+                    for(int count : displayBufferChoices) {
+                        if(count <= state.computeBufferCount || (long)count*state.samplesPerBuffer > maxDisplaySamples) continue;
+                        snprintf(label, sizeof(label), "waveform %.2f s", count*state.samplesPerBuffer/state.sampleRate);
+                        if(ImGui::Selectable(label, count == state.displayBufferCount)) state.displayBufferCount = count;
+                    }
+                    ImGui::EndCombo();
+                }
+                if(!state.audioError.empty()) ImGui::TextColored(settings.accentCol3, "kept the old shape: %s", state.audioError.c_str());
+                ImGui::Spacing();
+
+                ImGui::TextColored(ImVec4(1, 1, 1, 1), "Hop");
+                if(ImGui::BeginItemTooltip()) {
+                    ImGui::SetTooltip("samples between chord analyses, independent of the frame rate.");
+                    ImGui::EndTooltip();
+                }
+                if(ImGui::SliderInt("##4", &state.hopSamples, 64, settings.samplesPerBuffer*settings.computeBufferCount, "%d", ImGuiSliderFlags_AlwaysClamp|ImGuiSliderFlags_Logarithmic)){
+                    settings.hopSamples = state.hopSamples;
+                }
+                if(ImGui::Checkbox("Display audio", &state.display)){
+                    paCtx->display = state.display;
+                }
+                if(ImGui::BeginItemTooltip()) {
+                    ImGui::SetTooltip("Subscribe the waveform to the audio stream; analysis runs either way.");
+                    ImGui::EndTooltip();
+                }
+                ImGui::Spacing();
+
+                ImGui::TextColored(ImVec4(1, 1, 1, 1), "Front End");
+                if(ImGui::BeginItemTooltip()) {
+                    ImGui::SetTooltip("Full FFT per hop, a sliding DFT updated per sample over the chroma bins,\nor per-octave FFTs over decimated signals (constant-Q, a fraction of the FFT cost).");
+                    ImGui::EndTooltip();
+                }
+                if(ImGui::Combo("##5", &state.frontEnd, frontEndNames, IM_ARRAYSIZE(frontEndNames))){
+                    settings.frontEnd = (FrontEnd)state.frontEnd;
+                }
+                if(ImGui::Combo("##6", &state.window, windowTypeNames, IM_ARRAYSIZE(windowTypeNames))){
+                    settings.window = (WindowType)state.window;
+                }
+                if(ImGui::Combo("##7", &state.fftBackend, fftBackendNames, IM_ARRAYSIZE(fftBackendNames))){
+                    settings.fftBackend = (FftBackend)state.fftBackend;
+                }
+                ImGui::Spacing();
+
+                ImGui::TextColored(ImVec4(1, 1, 1, 1), "Wait Policy");
+                if(ImGui::BeginItemTooltip()) {
+                    ImGui::SetTooltip("How the compute thread idles between jobs.");
+                    ImGui::EndTooltip();
+                }
+                if(ImGui::Combo("##3", &state.waitPolicy, waitPolicyNames, IM_ARRAYSIZE(waitPolicyNames))){
+                    settings.waitPolicy = (WaitPolicy)state.waitPolicy;
+                }
+                ImGui::Spacing();
+
+                ImGui::TextColored(ImVec4(1, 1, 1, 1), "Event Log");
+                if(ImGui::BeginItemTooltip()) {
+                    ImGui::SetTooltip("Which frames are traced to stdout as JSON Lines.");
+                    ImGui::EndTooltip();
+                }
+                if(ImGui::Combo("##11", &state.logLevel, eventLevelNames, IM_ARRAYSIZE(eventLevelNames))){
+                    settings.logLevel = (EventLevel)state.logLevel;
+                    if(computeCtx.log) computeCtx.log->level = settings.logLevel;
+                }
+                ImGui::Spacing();
+
                 ImGui::TextColored(ImVec4(1, 1, 1, 1), "Display Maximum");
                 if(ImGui::BeginItemTooltip()) {
                     ImGui::SetTooltip("Maximum for the y-axis of each plot.");
@@ -474,6 +1329,59 @@ int gui(int argc, char* argv[])
             ImGui::End();
         }
         
+        // Latency Window
+        if(state.showLatency) {
+            ImGui::SetNextWindowSize(ImVec2(560, 0), ImGuiCond_FirstUseEver);
+            if(ImGui::Begin("Latency", &state.showLatency)) {
+                if(ImGui::BeginTable("stages", 5, ImGuiTableFlags_RowBg|ImGuiTableFlags_BordersInnerV)) {
+                    const char* heads[5] = {"Stage", "Count", "p50 us", "p99 us", "Max us"};
+                    for(auto h : heads) ImGui::TableSetupColumn(h);
+                    ImGui::TableHeadersRow();
+                    for(int s = 0; s < (int)LatencyStage::Count; s++) {
+                        const LatencySummary l = summarizeLatency(latency->stages[s]);
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn(); ImGui::TextUnformatted(latencyStageNames[s]);
+                        ImGui::TableNextColumn(); ImGui::Text("%lu", l.count);
+                        ImGui::TableNextColumn(); ImGui::Text("%.1f", l.p50Us);
+                        ImGui::TableNextColumn(); ImGui::Text("%.1f", l.p99Us);
+                        ImGui::TableNextColumn(); ImGui::Text("%.1f", l.maxUs);
+                    }
+                    ImGui::EndTable();
+                }
+                if(ImGui::Button("Reset")) resetLatencyProbe(*latency);
+                ImGui::SameLine();
+                ImGui::TextDisabled("exported to %s on exit", latencyExportPath);
+            }
+            ImGui::End();
+        }
+
+        // Streams Window
+        if(multiStream && state.showStreams) {
+            ImGui::SetNextWindowSize(ImVec2(480, 0), ImGuiCond_FirstUseEver);
+            if(ImGui::Begin("Streams", &state.showStreams)) {
+                if(ImGui::BeginTable("streams", 6, ImGuiTableFlags_RowBg|ImGuiTableFlags_BordersInnerV)) {
+                    const char* heads[6] = {"Device", "Channel", "Chord", "Score", "F0 Hz", "Age ms"};
+                    for(auto h : heads) ImGui::TableSetupColumn(h);
+                    ImGui::TableHeadersRow();
+                    const long long now = steadyNowNs();
+                    for(int s = 0; s < streamsCtx.streams; s++) {
+                        ChordBoardEntry e;
+                        const bool has = readChordResult(shownStreamsGen->analyzer.board, s, e);
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn(); ImGui::Text("%d", settings.devices[s/settings.channels]);
+                        ImGui::TableNextColumn(); ImGui::Text("%d", s%settings.channels);
+                        if(!has) { ImGui::TableNextColumn(); ImGui::TextDisabled("-"); continue; }
+                        ImGui::TableNextColumn(); ImGui::TextUnformatted(chordName(settings.vocab, e.label).c_str());
+                        ImGui::TableNextColumn(); ImGui::Text("%.4f", e.score);
+                        ImGui::TableNextColumn(); ImGui::Text("%.1f", e.f0);
+                        ImGui::TableNextColumn(); ImGui::Text("%.1f", (now - e.publishNs)/1e6);
+                    }
+                    ImGui::EndTable();
+                }
+            }
+            ImGui::End();
+        }
+
         // if(fontSm) ImGui::PopFont();
         // Rendering
         ImGui::Render();
@@ -509,24 +1417,40 @@ int gui(int argc, char* argv[])
     glfwDestroyWindow(window);
     glfwTerminate();
 
-    paErr = Pa_CloseStream(stream);
-    if(paErr != paNoError) return pa_error_handler(paErr);
+    closeInputs(streams);
+    // still alive: the generation on screen and one handed over but maybe not yet retired; a
+    // pending one always reads the newest tap and rings
+    if(multiStream) {
+        streamsCtx.run = false;
+        notifyWaiter(streamsCtx.waiter);
+        streamsThread.join();
+        freeStreamsGeneration(pendingStreamsGen);
+        if(shownStreamsGen->rings != streamRings) freeStreamRings(shownStreamsGen->rings);
+        freeStreamsGeneration(shownStreamsGen);
+        freeStreamRings(streamRings);
+        freeDeviceContexts(devices);
+    }
+
+    computeCtx.run = false;
+    notifyWaiter(computeCtx.waiter);
+    computeThread.join();
+    closeEventLog(computeCtx.log);
+    closeChordFeed(computeCtx.feed);
+    freeComputeGeneration(pendingGen);
+    if(shownGen->input != paCtx) freePaContext(shownGen->input);
+    freeComputeGeneration(shownGen);
+
+    writeLatencyTable(stderr, *latency);
+    if(FILE* f = fopen(latencyExportPath, "w")) { writeLatencyJson(f, *latency); fclose(f); }
+    delete latency;
 
-    if(paCtx.rBuffFromRTData) PaUtil_FreeMemory(paCtx.rBuffFromRTData);
-    if(readData) PaUtil_FreeMemory(readData);
-    if(displayData) PaUtil_FreeMemory(displayData);
-    if(tmpData) PaUtil_FreeMemory(tmpData);
+    freePaContext(paCtx);
+    freeMirrorBuffer(display.raw);
 
     paErr = Pa_Terminate();
     if(paErr != paNoError){
         printf("PortAudio termination error: %s\n", Pa_GetErrorText(paErr));
     }
 
-    computeCtx.run = false;
-    if(chordComputeData) freeChordComputeData(chordComputeData);
-    if(computeCtx.rBuffFromGuiData) PaUtil_FreeMemory(computeCtx.rBuffFromGuiData);
-    if(computeCtx.rBuffToGuiData) PaUtil_FreeMemory(computeCtx.rBuffToGuiData);
-    computeThread.join();
-
     return 0;
 }
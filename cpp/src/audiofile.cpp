@@ -0,0 +1,169 @@
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include "audiofile.h"
+
+static uint32_t readLE32(const unsigned char* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t readLE16(const unsigned char* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static int formatBytes(SampleFormat fmt) {
+    switch (fmt) {
+        case SampleFormat::U8: return 1;
+        case SampleFormat::S8: return 1;
+        case SampleFormat::S16: return 2;
+        case SampleFormat::S24: return 3;
+        case SampleFormat::S32: return 4;
+        case SampleFormat::F32: return 4;
+        case SampleFormat::F64: return 8;
+    }
+    return 4;
+}
+
+bool parseSampleFormat(const std::string& s, SampleFormat& fmt) {
+    if(s == "u8") fmt = SampleFormat::U8;
+    else if(s == "s8") fmt = SampleFormat::S8;
+    else if(s == "s16") fmt = SampleFormat::S16;
+    else if(s == "s24") fmt = SampleFormat::S24;
+    else if(s == "s32") fmt = SampleFormat::S32;
+    else if(s == "f32") fmt = SampleFormat::F32;
+    else if(s == "f64") fmt = SampleFormat::F64;
+    else return false;
+    return true;
+}
+
+static bool audioError(AudioFile& f, const std::string& path, const char* msg) {
+    fprintf(stderr, "Audio Error %s: %s\n", path.c_str(), msg);
+    closeAudioFile(f);
+    return false;
+}
+
+static bool readWavHeader(AudioFile& f, const std::string& path) {
+    unsigned char hdr[12];
+    if(fread(hdr, 1, 12, f.fp) != 12 || memcmp(hdr, "RIFF", 4) || memcmp(hdr+8, "WAVE", 4))
+        return audioError(f, path, "not a RIFF/WAVE file");
+
+    bool haveFmt = false;
+    unsigned char chunk[8];
+    while(fread(chunk, 1, 8, f.fp) == 8) {
+        uint32_t size = readLE32(chunk+4);
+        if(!memcmp(chunk, "fmt ", 4)) {
+            unsigned char fmt[40] = {0};
+            uint32_t n = size < sizeof(fmt) ? size : sizeof(fmt);
+            if(size < 16 || fread(fmt, 1, n, f.fp) != n) return audioError(f, path, "truncated fmt chunk");
+            if(size > n) fseek(f.fp, size-n, SEEK_CUR);
+
+            int tag = readLE16(fmt);
+            f.channels = readLE16(fmt+2);
+            f.sampleRate = (float)readLE32(fmt+4);
+            int bits = readLE16(fmt+14);
+            if(tag == 0xFFFE && size >= 26) tag = readLE16(fmt+24); // WAVE_FORMAT_EXTENSIBLE subformat
+
+            if(tag == 1) {
+                switch(bits) {
+                    case 8: f.format = SampleFormat::U8; break; // 8-bit WAV is unsigned
+                    case 16: f.format = SampleFormat::S16; break;
+                    case 24: f.format = SampleFormat::S24; break;
+                    case 32: f.format = SampleFormat::S32; break;
+                    default: return audioError(f, path, "unsupported PCM bit depth");
+                }
+            } else if(tag == 3) {
+                if(bits == 32) f.format = SampleFormat::F32;
+                else if(bits == 64) f.format = SampleFormat::F64;
+                else return audioError(f, path, "unsupported float bit depth");
+            } else {
+                return audioError(f, path, "unsupported WAV encoding");
+            }
+            if(f.channels < 1) return audioError(f, path, "invalid channel count");
+            haveFmt = true;
+        } else if(!memcmp(chunk, "data", 4)) {
+            if(!haveFmt) return audioError(f, path, "data chunk before fmt chunk");
+            f.bytesLeft = size;
+            if(size == 0xFFFFFFFF || size == 0) f.bytesLeft = -1; // streamed WAVs leave the size unset
+            return true;
+        } else {
+            if(fseek(f.fp, size + (size & 1), SEEK_CUR)) break; // chunks are word aligned
+        }
+    }
+    return audioError(f, path, "missing data chunk");
+}
+
+bool openAudioFile(AudioFile& f, const std::string& path, const RawAudioOptions& opts) {
+    if(path == "-") {
+        f.fp = stdin; f.ownsFp = false;
+    } else {
+        f.fp = fopen(path.c_str(), "rb"); f.ownsFp = true;
+        if(f.fp == nullptr) return audioError(f, path, strerror(errno));
+    }
+
+    if(opts.raw) {
+        f.channels = opts.channels;
+        f.sampleRate = opts.sampleRate;
+        f.format = opts.format;
+        f.bytesLeft = -1;
+    } else if(!readWavHeader(f, path)) {
+        return false;
+    }
+    f.bytesPerSample = formatBytes(f.format);
+    return true;
+}
+
+long readAudioFile(AudioFile& f, float* out, long frames) {
+    if(f.fp == nullptr || frames <= 0) return 0;
+    const long frameBytes = (long)f.bytesPerSample*f.channels;
+    if(f.bytesLeft >= 0 && frames*frameBytes > f.bytesLeft) frames = f.bytesLeft/frameBytes;
+    if(frames > f.scratchFrames) {
+        free(f.scratch);
+        f.scratch = (unsigned char*)malloc(frames*frameBytes);
+        f.scratchFrames = frames;
+    }
+
+    long got = (long)fread(f.scratch, frameBytes, frames, f.fp);
+    if(f.bytesLeft >= 0) f.bytesLeft -= got*frameBytes;
+
+    const long count = got*f.channels;
+    const unsigned char* p = f.scratch;
+    switch(f.format) {
+        case SampleFormat::U8:
+            for(long i = 0; i < count; i++) out[i] = (p[i] - 128)/128.f;
+            break;
+        case SampleFormat::S8:
+            for(long i = 0; i < count; i++) out[i] = (int8_t)p[i]/128.f;
+            break;
+        case SampleFormat::S16:
+            for(long i = 0; i < count; i++) out[i] = (int16_t)readLE16(p+2*i)/32768.f;
+            break;
+        case SampleFormat::S24:
+            for(long i = 0; i < count; i++) {
+                int32_t v = (p[3*i] << 8) | (p[3*i+1] << 16) | ((uint32_t)p[3*i+2] << 24);
+                out[i] = (v >> 8)/8388608.f;
+            }
+            break;
+        case SampleFormat::S32:
+            for(long i = 0; i < count; i++) out[i] = (int32_t)readLE32(p+4*i)/2147483648.f;
+            break;
+        case SampleFormat::F32:
+            for(long i = 0; i < count; i++) { uint32_t v = readLE32(p+4*i); memcpy(&out[i], &v, 4); }
+            break;
+        case SampleFormat::F64:
+            for(long i = 0; i < count; i++) {
+                uint64_t v = readLE32(p+8*i) | ((uint64_t)readLE32(p+8*i+4) << 32);
+                double d; memcpy(&d, &v, 8); out[i] = (float)d;
+            }
+            break;
+    }
+    return got;
+}
+
+void closeAudioFile(AudioFile& f) {
+    if(f.fp && f.ownsFp) fclose(f.fp);
+    f.fp = nullptr;
+    free(f.scratch);
+    f.scratch = nullptr;
+    f.scratchFrames = 0;
+}
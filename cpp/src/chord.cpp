@@ -1,14 +1,19 @@
 #include <map>
-#include <iostream>
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include "chord.h"
+#include "simd.h"
+#include "hps.h"
+#include "waiter.h"
 
-ChordComputeData* initChordComputeData(int n) {
-    ChordComputeData* x = (ChordComputeData*)malloc(sizeof(ChordComputeData));
+ChordComputeData* initChordComputeData(int n, int states) {
+    ChordComputeData* x = new ChordComputeData();
     x->spec = (float*)malloc(sizeof(float)*(n/2+1));
     x->hps = (float*)malloc(sizeof(float)*(n/2+1));
     x->chroma = (float*)malloc(sizeof(float)*12);
+    x->states = states;
+    x->scores = (float*)malloc(sizeof(float)*states);
     return x;
 }
 
@@ -16,116 +21,247 @@ void freeChordComputeData(ChordComputeData* x) {
     free(x->spec);
     free(x->hps);
     free(x->chroma);
+    free(x->scores);
     delete x;
 }
 
+ChordComputePool initChordComputePool(int n, int states, int capacity) {
+    ChordComputePool pool;
+    pool.capacity = capacity;
+    pool.slots = new ChordComputeData[capacity];
+    const int stride = 2*(n/2+1) + 12 + states;
+    pool.arena = new float[(size_t)stride*capacity]();
+    for(int i = 0; i < capacity; i++) {
+        float* base = &pool.arena[(size_t)stride*i];
+        pool.slots[i].spec = base;
+        pool.slots[i].hps = base + (n/2+1);
+        pool.slots[i].chroma = base + 2*(n/2+1);
+        pool.slots[i].states = states;
+        pool.slots[i].scores = base + 2*(n/2+1) + 12;
+        pool.slots[i].dt = 0;
+    }
+    return pool;
+}
+
+void freeChordComputePool(ChordComputePool& pool) {
+    delete[] pool.slots;
+    delete[] pool.arena;
+    pool.slots = nullptr; pool.arena = nullptr;
+    pool.capacity = 0;
+}
+
 ChordConfig initChordConfig(int n, float sampleRate, int octaves, float threshold) {
     ChordConfig cfg;
     cfg.octaves = octaves;
     cfg.threshold = threshold;
     cfg.n = n;
     cfg.sampleRate = sampleRate;
-    cfg.cfg = kiss_fftr_alloc(n, 0, nullptr, nullptr);
-    cfg.out = (kiss_fft_cpx*)malloc(sizeof(kiss_fft_cpx)*n);
+    cfg.fft = getFftPlan(cfg.fftBackend, n);
+    cfg.fftScratch = (float*)malloc(sizeof(float)*fftScratchFloats(n));
+    cfg.in = (kiss_fft_scalar*)malloc(sizeof(kiss_fft_scalar)*n);
+    cfg.out = (kiss_fft_cpx*)malloc(sizeof(kiss_fft_cpx)*(n/2+1));
+    cfg.windowCoeffs = (float*)malloc(sizeof(float)*n);
+    fillWindow(cfg.windowCoeffs, n, cfg.window);
+    buildChromaFilterbank(cfg.filterbank, n, sampleRate, octaves, ChromaShape::Box);
+    cfg.fixedChroma = findSpecializedChroma(cfg.filterbank);
+    ChordVocabulary vocab;
+    defaultChordVocabulary(vocab);
+    setChordVocabulary(cfg, vocab);
+    return cfg;
+}
+
+ChordConfig cloneChordConfig(const ChordConfig& proto) {
+    ChordConfig cfg = initChordConfig(proto.n, proto.sampleRate, proto.octaves, proto.threshold);
+    cfg.hpsHarmonics = proto.hpsHarmonics;
+    cfg.latency = proto.latency;
+    setChordVocabulary(cfg, proto.vocab);
+    setChordFftBackend(cfg, proto.fftBackend);
+    if(proto.filterbank.shape != cfg.filterbank.shape) setChordChroma(cfg, proto.octaves, proto.filterbank.shape);
+    setChordFrontEnd(cfg, proto.frontEnd, proto.window, nullptr);
+    if(cfg.sliding) cfg.sliding->resyncHops = proto.sliding->resyncHops;
+    if(cfg.multirate) cfg.multirate->resyncHops = proto.multirate->resyncHops;
     return cfg;
 }
 
 void freeChordConfig(ChordConfig& cfg) {
+    freeSlidingDft(cfg.sliding);
+    cfg.sliding = nullptr;
+    freeMultirate(cfg.multirate);
+    cfg.multirate = nullptr;
+    freeViterbi(cfg.smoother);
+    cfg.smoother = nullptr;
+    free(cfg.windowCoeffs);
+    free(cfg.in);
     free(cfg.out);
-    free(cfg.cfg);
+    free(cfg.fftScratch);
 }
 
-const bool mask[2][12] = {
-    {1, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 0},
-    {1, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0},
-};
+void setChordVocabulary(ChordConfig& cfg, const ChordVocabulary& vocab) {
+    cfg.vocab = vocab;
+    cfg.fixedScores = findSpecializedScores(vocab.chords);
+    cfg.order.assign(vocab.chords, 0);
+    if(cfg.smoother) setChordSmoothing(cfg, cfg.smoother->lag, nullptr);
+}
 
-std::string maskIndToName(int ind) {
-    switch (ind) {
-        case 0: return "Maj";
-        case 1: return "Min"; 
-        default: return "";
+void setChordSmoothing(ChordConfig& cfg, int lag, const float* trans) {
+    freeViterbi(cfg.smoother);
+    cfg.smoother = nullptr;
+    if(lag < 0) return;
+    const int states = chordStateCount(cfg);
+    std::vector<float> stay;
+    if(trans == nullptr) {
+        stay.resize(states*states);
+        fillStayTransitions(stay.data(), states, 0.9f);
+        trans = stay.data();
     }
+    cfg.smoother = initViterbi(states, lag, trans);
 }
 
-int freq2Midi(float freq) {
-    return std::round(12 * std::log2(freq / 440.0) + 69);
+// the octave layout follows the chroma octaves, window and backend; the rebuilt state is
+// stale until the next spectrum resyncs it from the window
+static void sizeMultirate(ChordConfig& cfg) {
+    const int resyncHops = cfg.multirate ? cfg.multirate->resyncHops : 32;
+    freeMultirate(cfg.multirate);
+    cfg.multirate = initMultirate(cfg.n, cfg.sampleRate, cfg.octaves, cfg.window, cfg.fftBackend);
+    cfg.multirate->resyncHops = resyncHops;
 }
 
-float midi2Freq(int midi) {
-    return std::exp2f((midi-69)/12.)*440.;
+void setChordFftBackend(ChordConfig& cfg, FftBackend backend) {
+    cfg.fftBackend = backend;
+    cfg.fft = getFftPlan(backend, cfg.n);
+    if(cfg.multirate) sizeMultirate(cfg);
 }
 
-int freq2Bin(float freq, int sampleRate, int n) {
-    return std::floorf(freq*n/sampleRate);
+// the sliding DFT only tracks the bins the filterbank reads
+static void sizeSlidingRange(ChordConfig& cfg) {
+    setSlidingDftRange(*cfg.sliding, cfg.filterbank.highPassBin, std::max(cfg.filterbank.highPassBin, cfg.filterbank.topBin));
 }
 
+void setChordChroma(ChordConfig& cfg, int octaves, ChromaShape shape) {
+    cfg.octaves = octaves;
+    buildChromaFilterbank(cfg.filterbank, cfg.n, cfg.sampleRate, octaves, shape);
+    cfg.fixedChroma = findSpecializedChroma(cfg.filterbank);
+    if(cfg.sliding) sizeSlidingRange(cfg);
+    if(cfg.multirate) sizeMultirate(cfg);
+}
 
-
-void computeChord(ChordComputeData& out, float* samples, ChordConfig& cfg) {
-    kiss_fftr(cfg.cfg, samples, cfg.out);
-    
-    for(int i = 0; i < cfg.n/2; i++) {
-        out.spec[i] = cfg.out[i].r * cfg.out[i].r + cfg.out[i].i * cfg.out[i].i;
+void setChordFrontEnd(ChordConfig& cfg, FrontEnd frontEnd, WindowType window, const float* history) {
+    if(window != cfg.window) {
+        cfg.window = window;
+        fillWindow(cfg.windowCoeffs, cfg.n, window);
     }
-    
-    const int highPassBin = freq2Bin(50, cfg.sampleRate, cfg.n);
-    const float qrat = 1.02930223664349F; // quarter tone ratio
-    float mid = midi2Freq(60);
-    for(int p = 0; p < 12; p++) {
-        float lbf = mid/qrat, ubf = mid*qrat;
-        out.chroma[p] = 1;
-        for(int r = 0; r < cfg.octaves; r++){
-            // downsample to bins
-            const int lbi = freq2Bin(lbf, cfg.sampleRate, cfg.n), ubi = std::min(freq2Bin(ubf, cfg.sampleRate, cfg.n), cfg.n/2);
-            // ignore first 3 bins (high pass filter)
-            float sm = 0; for(int j = std::max(lbi, highPassBin); j <= ubi; j++) sm += out.spec[j];
-            float avg = sm/(ubi-lbi+1);
-
-            // harmonic product spectrum
-            out.chroma[p] *= avg; 
-            lbf *= 2.F; ubf *= 2.F;
-        }
-        mid *= qrat*qrat;
+    cfg.frontEnd = frontEnd;
+    if(frontEnd == FrontEnd::Sliding) {
+        if(cfg.sliding == nullptr) cfg.sliding = initSlidingDft(cfg.n, 0, 0, window);
+        cfg.sliding->window = window;
+        sizeSlidingRange(cfg);
+        if(history) resetSlidingDft(*cfg.sliding, history);
+    } else {
+        freeSlidingDft(cfg.sliding);
+        cfg.sliding = nullptr;
+    }
+    if(frontEnd == FrontEnd::Multirate) {
+        if(cfg.multirate == nullptr || cfg.multirate->window != window) sizeMultirate(cfg);
+        if(history) resetMultirate(*cfg.multirate, history);
+    } else {
+        freeMultirate(cfg.multirate);
+        cfg.multirate = nullptr;
     }
+}
 
-    float chords[24]; int inds[24];
-    for(int c = 0; c < 24; c++) {
-        inds[c] = c;
-        int i = c/12, p = c%12;
-        float sm = 0, sz = 0;
-        for(int q = 0; q < 12; q++) {
-            sm += mask[i][q]*out.chroma[(p+q)%12];
-            sz += mask[i][q];
+void pushChordSamples(ChordConfig& cfg, const float* x, long count) {
+    if(cfg.frontEnd == FrontEnd::Sliding) pushSlidingDft(*cfg.sliding, x, count);
+    else if(cfg.frontEnd == FrontEnd::Multirate) pushMultirate(*cfg.multirate, x, count);
+}
+
+void resetChordStream(ChordConfig& cfg, const float* window) {
+    if(cfg.frontEnd == FrontEnd::Sliding) resetSlidingDft(*cfg.sliding, window);
+    else if(cfg.frontEnd == FrontEnd::Multirate) resetMultirate(*cfg.multirate, window);
+}
+
+
+
+void computeChord(ChordComputeData& out, const float* samples, ChordConfig& cfg) {
+    const long long st = cfg.log || cfg.latency ? steadyNowNs() : 0;
+    if(cfg.frontEnd == FrontEnd::Sliding) {
+        slidingDftSpectrum(*cfg.sliding, out.spec, cfg.fft, cfg.in, cfg.fftScratch, cfg.out);
+    } else if(cfg.frontEnd == FrontEnd::Multirate) {
+        multirateSpectrum(*cfg.multirate, out.spec, samples, cfg.in, cfg.fftScratch, cfg.out);
+    } else {
+        const float* in = samples;
+        if(cfg.window != WindowType::Rectangular) {
+            for(int i = 0; i < cfg.n; i++) cfg.in[i] = samples[i]*cfg.windowCoeffs[i];
+            in = cfg.in;
         }
-        chords[c] = sm/sz;
+        fftReal(cfg.fft, in, cfg.out, cfg.fftScratch);
+        activeSimdKernels().powerSpectrum(out.spec, cfg.out, cfg.n/2+1);
     }
+    if(cfg.latency) recordLatency(*cfg.latency, LatencyStage::Fft, steadyNowNs() - st);
+    computeChordFromSpectrum(out, cfg);
+    const long long jobNs = st ? steadyNowNs() - st : 0;
+    if(cfg.latency) recordLatency(*cfg.latency, LatencyStage::Job, jobNs);
+    logChordFrame(cfg, out, jobNs);
+}
 
-    std::sort(inds, inds+24, [&chords](int a, int b) {
-        return chords[a] > chords[b];
-    });
+void logChordFrame(ChordConfig& cfg, const ChordComputeData& out, long long jobNs) {
+    if(cfg.log == nullptr) return;
+    ChordEvent ev;
+    ev.time = cfg.streamTime;
+    ev.jobUs = jobNs/1e3;
+    ev.score = out.score; ev.f0 = out.f0;
+    ev.label = out.label; ev.raw = out.chord;
+    selectTopChords(ev, out.scores, cfg.vocab.chords, cfg.order.data());
+    logChordEvent(*cfg.log, ev);
+}
 
-    float maxSpec = 0;
-    for(int i = highPassBin; i < cfg.n/2; i++) {
-        maxSpec = std::max(maxSpec, out.spec[i]);
-    }
+void skipChordHop(ChordConfig& cfg) {
+    // hold the count on a resync boundary, so the next spectrum call rebuilds
+    if(cfg.sliding && cfg.sliding->hopCount % cfg.sliding->resyncHops != 0) cfg.sliding->hopCount++;
+    if(cfg.multirate && cfg.multirate->hopCount % cfg.multirate->resyncHops != 0) cfg.multirate->hopCount++;
+}
+
+void computeChordFromSpectrum(ChordComputeData& out, ChordConfig& cfg) {
+    const SimdKernels& k = activeSimdKernels();
+    const int highPassBin = cfg.filterbank.highPassBin;
+    // stage stamps, each taken only when a probe is attached
+    LatencyProbe* lp = cfg.latency;
+    long long t0 = lp ? steadyNowNs() : 0, t1;
+    out.f0 = computeHps(out.hps, out.spec, cfg.n, cfg.sampleRate, cfg.hpsHarmonics, highPassBin);
+    if(lp) { t1 = steadyNowNs(); recordLatency(*lp, LatencyStage::Hps, t1 - t0); t0 = t1; }
+    const int variant = cfg.fixedChroma || cfg.fixedScores ? specializedVariant() : 0;
+    if(cfg.fixedChroma) cfg.fixedChroma->apply[variant](out.spec, out.chroma);
+    else applyChromaFilterbank(cfg.filterbank, out.spec, out.chroma);
+    if(lp) { t1 = steadyNowNs(); recordLatency(*lp, LatencyStage::Chroma, t1 - t0); t0 = t1; }
+
+    // the whole vocabulary in one GEMV, straight into the emission slots
+    const int chords = cfg.vocab.chords;
+    float* scores = out.scores;
+    assert(out.states > chords);
+    if(cfg.fixedScores) cfg.fixedScores->apply[variant](scores, cfg.vocab.templates.data(), out.chroma);
+    else k.matVec(scores, cfg.vocab.templates.data(), chords, 12, out.chroma);
+
+    // the peak over the bins the filterbank reads, which every front end fills, so the threshold
+    // means the same on all of them
+    float maxSpec = k.maxRange(out.spec, highPassBin, std::max(highPassBin, cfg.filterbank.topBin) + 1);
     
-    for(int c = 0; c < 24; c++) chords[c] /= maxSpec;
+    for(int c = 0; c < chords; c++) scores[c] /= maxSpec;
 
     int best = 0;
-    for(int c = 0; c < 24; c++) {
-        if(chords[c] > chords[best]) best = c;
+    for(int c = 0; c < chords; c++) {
+        if(scores[c] > scores[best]) best = c;
     }
+    out.score = scores[best];
+    out.chord = out.score > cfg.threshold ? best : chords;
 
-    if(chords[best] > cfg.threshold){
-        out.name = notes[best%12] + " " + maskIndToName(best/12); 
-        std::cout << "COMPUTE: " << chords[best] << " / " << maxSpec << " \t<- ";        
-        for(int i = 0; i < 5; i++) {
-            int idx = inds[i];
-            std::cout << notes[idx%12] << " " << maskIndToName(idx/12) << ", ";
-        }
-        std::cout << std::endl;
-    } else {
-        out.name = "N/A";
-    }
+    k.log2Range(scores, scores, chords, 1e-30f);
+    scores[chords] = std::log2(std::max(cfg.threshold, 1e-30f));
+    decideChordLabel(out, cfg);
+    if(lp) recordLatency(*lp, LatencyStage::Scoring, steadyNowNs() - t0);
+}
+
+void decideChordLabel(ChordComputeData& out, ChordConfig& cfg) {
+    const int chords = cfg.vocab.chords;
+    out.label = cfg.smoother ? stepViterbi(*cfg.smoother, out.scores) : out.chord;
+    if(out.label < 0) out.label = chords; // smoother still filling its lag
+    out.name = chordName(cfg.vocab, out.label);
 }
\ No newline at end of file
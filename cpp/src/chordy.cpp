@@ -0,0 +1,315 @@
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <new>
+#include <string>
+#include <vector>
+#include "chordy.h"
+#include "chord.h"
+#include "mirror.h"
+
+struct chordy_analyzer {
+    chordy_config config;
+    std::string vocabularyPath; // config.vocabulary_path points here
+
+    ChordConfig cfg;
+    ChordComputeData* data = nullptr;
+    std::vector<std::string> names; // chord names, N/A last
+    MirrorBuffer history;           // newest window_size samples are one contiguous view
+    long sinceHop = 0;              // samples since the last analyzed hop boundary
+    long samples = 0;
+    long frames = 0;
+    // with smoothing, a frame's label comes lag hops after its analysis: the frames still waiting
+    // for it, with their scores, in rings of lag+1 slots (one slot without smoothing)
+    std::vector<chordy_result> pending;
+    std::vector<float> pendingScores;
+    std::vector<int> flushed;       // flushViterbi output, lag states
+    long completed = 0;             // frames with their final result since the last reset
+    chordy_result last;
+    std::vector<float> lastScores;
+    std::string error;
+
+    // chordy_analyze_frames runs on its own copy of the config, scratch and smoother, built on
+    // first use after each configure, so batches never touch the stream
+    ChordConfig batchCfg;
+    ChordComputeData* batchData = nullptr;
+};
+
+static void freeBatch(chordy_analyzer& a) {
+    if(a.batchData == nullptr) return;
+    freeChordConfig(a.batchCfg);
+    freeChordComputeData(a.batchData);
+    a.batchData = nullptr;
+}
+
+static bool isPow2(int x) { return x > 0 && (x & (x-1)) == 0; }
+
+static chordy_status fail(chordy_analyzer* a, chordy_status status, const std::string& error) {
+    if(a) a->error = error;
+    return status;
+}
+
+static chordy_status validate(const chordy_config* c, std::string& error) {
+    if(!isPow2(c->window_size) || c->window_size < 256) error = "window_size must be a power of two >= 256";
+    else if(c->hop_size < 1 || c->hop_size > c->window_size) error = "hop_size must be in 1..window_size";
+    else if(!(c->sample_rate > 0)) error = "sample_rate must be positive";
+    else if(c->octaves < 1 || c->octaves > 8) error = "octaves must be in 1..8";
+    else if(!(c->threshold >= 0)) error = "threshold must be >= 0";
+    else if(c->hps_harmonics < 0 || c->hps_harmonics > 16) error = "hps_harmonics must be in 0..16";
+    else if(c->front_end < CHORDY_FRONT_END_FFT || c->front_end > CHORDY_FRONT_END_MULTIRATE) error = "unknown front_end";
+    else if(c->window != CHORDY_WINDOW_RECTANGULAR && c->window != CHORDY_WINDOW_HANN) error = "unknown window";
+    else if(c->smoothing_lag >= 0 && !(c->smoothing_stay > 0 && c->smoothing_stay <= 1)) error = "smoothing_stay must be in (0, 1]";
+    else return CHORDY_OK;
+    return CHORDY_ERROR_ARGUMENT;
+}
+
+// the frame's own fields; the label is set once the smoother has decided it
+static void fillResult(chordy_analyzer& a, const ChordComputeData& d, chordy_result& r) {
+    r.frame = a.frames;
+    r.time = a.samples/(double)a.config.sample_rate;
+    r.raw = d.chord;
+    r.score = d.score; r.f0 = d.f0;
+    memcpy(r.chroma, d.chroma, sizeof(r.chroma));
+}
+
+static void setLabel(const chordy_analyzer& a, chordy_result& r, int chord) {
+    r.chord = chord;
+    const std::string& name = a.names[std::min<size_t>(chord, a.names.size()-1)];
+    strncpy(r.name, name.c_str(), sizeof(r.name)-1); // zero-padded, so the struct is all defined bytes
+    r.name[sizeof(r.name)-1] = 0;
+}
+
+// hops between a frame's analysis and its label
+static int labelLag(const ChordConfig& cfg) {
+    return cfg.smoother ? cfg.smoother->lag : 0;
+}
+
+// whether the frame just analyzed completed the one labelLag hops before it
+static bool labelReady(const ChordConfig& cfg) {
+    return cfg.smoother == nullptr || cfg.smoother->frames > cfg.smoother->lag;
+}
+
+// gives the pending frame `frame` its label, makes it the latest result and appends it to the
+// caller's array while there is room
+static void completeFrame(chordy_analyzer& a, long frame, int chord, chordy_result* results, long capacity, long& done) {
+    const long slot = frame % a.pending.size();
+    const int states = a.data->states;
+    setLabel(a, a.pending[slot], chord);
+    a.last = a.pending[slot];
+    memcpy(a.lastScores.data(), &a.pendingScores[slot*states], sizeof(float)*states);
+    a.completed++;
+    if(results && done < capacity) results[done] = a.last;
+    done++;
+}
+
+extern "C" {
+
+void chordy_default_config(chordy_config* c) {
+    if(c == nullptr) return;
+    c->window_size = 8192;
+    c->hop_size = 1024;
+    c->sample_rate = 44100;
+    c->octaves = 4;
+    c->threshold = 0.016f;
+    c->hps_harmonics = 3;
+    c->front_end = CHORDY_FRONT_END_FFT;
+    c->window = CHORDY_WINDOW_RECTANGULAR;
+    c->smoothing_lag = -1;
+    c->smoothing_stay = 0.9f;
+    c->vocabulary_path = nullptr;
+}
+
+chordy_status chordy_configure(chordy_analyzer* a, const chordy_config* c) {
+    if(a == nullptr || c == nullptr) return fail(a, CHORDY_ERROR_ARGUMENT, "null argument");
+    std::string error;
+    if(validate(c, error) != CHORDY_OK) return fail(a, CHORDY_ERROR_ARGUMENT, error);
+
+    // everything that can fail happens before the analyzer is touched
+    ChordVocabulary vocab;
+    defaultChordVocabulary(vocab);
+    if(c->vocabulary_path && !loadChordVocabulary(vocab, c->vocabulary_path, error)) return fail(a, CHORDY_ERROR_VOCABULARY, error);
+    const int n = c->window_size;
+    const bool keepHistory = a->data && a->cfg.n == n && a->cfg.sampleRate == c->sample_rate;
+    MirrorBuffer history;
+    if(!keepHistory && !initMirrorBuffer(history, n)) return fail(a, CHORDY_ERROR_MEMORY, "history buffer");
+
+    ChordConfig cfg = initChordConfig(n, c->sample_rate, c->octaves, c->threshold);
+    cfg.hpsHarmonics = c->hps_harmonics;
+    setChordVocabulary(cfg, vocab);
+    if(c->smoothing_lag >= 0) {
+        const int states = chordStateCount(cfg);
+        std::vector<float> trans(states*states);
+        fillStayTransitions(trans.data(), states, c->smoothing_stay);
+        setChordSmoothing(cfg, c->smoothing_lag, trans.data());
+    }
+    ChordComputeData* data = initChordComputeData(n, chordStateCount(cfg));
+
+    if(!keepHistory) {
+        if(a->data) freeMirrorBuffer(a->history);
+        a->history = history;
+        a->sinceHop = 0;
+    }
+    if(a->sinceHop >= c->hop_size) a->sinceHop = 0; // hop shrunk
+    const float* window = a->data ? mirrorBufferTail(a->history, n) : nullptr;
+    setChordFrontEnd(cfg, (FrontEnd)c->front_end, (WindowType)c->window, window);
+    if(a->data) { freeChordConfig(a->cfg); freeChordComputeData(a->data); }
+    freeBatch(*a);
+    a->cfg = cfg;
+    a->data = data;
+
+    // the new smoother starts afresh, so frames still waiting for a label are dropped
+    const int states = chordStateCount(cfg), ring = labelLag(cfg) + 1;
+    a->pending.assign(ring, chordy_result());
+    a->pendingScores.assign(ring*states, 0.f);
+    a->flushed.assign(labelLag(cfg), 0);
+    if((int)a->lastScores.size() != states) { a->lastScores.assign(states, 0.f); a->completed = 0; }
+
+    a->names.clear();
+    for(int chord = 0; chord <= vocab.chords; chord++) a->names.push_back(chordName(vocab, chord));
+    a->config = *c;
+    a->vocabularyPath = c->vocabulary_path ? c->vocabulary_path : "";
+    a->config.vocabulary_path = c->vocabulary_path ? a->vocabularyPath.c_str() : nullptr;
+    a->error.clear();
+    return CHORDY_OK;
+}
+
+chordy_status chordy_create(const chordy_config* c, chordy_analyzer** out) {
+    if(out == nullptr) return CHORDY_ERROR_ARGUMENT;
+    *out = nullptr;
+    chordy_analyzer* a = new(std::nothrow) chordy_analyzer();
+    if(a == nullptr) return CHORDY_ERROR_MEMORY;
+    const chordy_status status = chordy_configure(a, c);
+    if(status != CHORDY_OK) { delete a; return status; }
+    *out = a;
+    return CHORDY_OK;
+}
+
+void chordy_destroy(chordy_analyzer* a) {
+    if(a == nullptr) return;
+    if(a->data) {
+        freeChordConfig(a->cfg);
+        freeChordComputeData(a->data);
+        freeMirrorBuffer(a->history);
+    }
+    freeBatch(*a);
+    delete a;
+}
+
+void chordy_reset(chordy_analyzer* a) {
+    if(a == nullptr) return;
+    const long n = a->cfg.n;
+    std::vector<float> silence(n, 0.f); // a reset is a setting change, not a hot path
+    writeMirrorBuffer(a->history, silence.data(), n);
+    resetChordStream(a->cfg, mirrorBufferTail(a->history, n));
+    if(a->cfg.smoother) resetViterbi(*a->cfg.smoother);
+    a->sinceHop = 0; a->samples = 0; a->frames = 0; a->completed = 0;
+}
+
+long chordy_process(chordy_analyzer* a, const float* x, long count, chordy_result* results, long capacity) {
+    if(a == nullptr || (x == nullptr && count > 0) || count < 0) return -1;
+    const long hop = a->config.hop_size, n = a->cfg.n;
+    long done = 0;
+    while(count > 0) {
+        // write up to the next hop boundary, then analyze the window ending there
+        const long take = std::min(count, hop - a->sinceHop);
+        writeMirrorBuffer(a->history, x, take);
+        pushChordSamples(a->cfg, x, take);
+        x += take; count -= take; a->sinceHop += take; a->samples += take;
+        if(a->sinceHop < hop) break;
+        a->sinceHop = 0;
+
+        computeChord(*a->data, mirrorBufferTail(a->history, n), a->cfg);
+        const long slot = a->frames % a->pending.size();
+        const int states = a->data->states;
+        fillResult(*a, *a->data, a->pending[slot]);
+        memcpy(&a->pendingScores[slot*states], a->data->scores, sizeof(float)*states);
+        if(labelReady(a->cfg)) completeFrame(*a, a->frames - labelLag(a->cfg), a->data->label, results, capacity, done);
+        a->frames++;
+    }
+    return done;
+}
+
+long chordy_flush(chordy_analyzer* a, chordy_result* results, long capacity) {
+    if(a == nullptr || capacity < 0) return -1;
+    if(a->cfg.smoother == nullptr) return 0;
+    const int count = flushViterbi(*a->cfg.smoother, a->flushed.data());
+    long done = 0;
+    for(int i = 0; i < count; i++) completeFrame(*a, a->frames - count + i, a->flushed[i], results, capacity, done);
+    resetViterbi(*a->cfg.smoother);
+    return done;
+}
+
+long chordy_analyze_frames(chordy_analyzer* a, const float* frames, long count, long stride, chordy_result* results, float* scores) {
+    if(a == nullptr || results == nullptr || (frames == nullptr && count > 0) || count < 0 || stride < 0) return -1;
+    if(a->batchData == nullptr) {
+        a->batchCfg = cloneChordConfig(a->cfg);
+        if(a->config.smoothing_lag >= 0) {
+            const int states = chordStateCount(a->cfg);
+            std::vector<float> trans(states*states);
+            fillStayTransitions(trans.data(), states, a->config.smoothing_stay);
+            setChordSmoothing(a->batchCfg, a->config.smoothing_lag, trans.data());
+        }
+        a->batchData = initChordComputeData(a->cfg.n, chordStateCount(a->cfg));
+    }
+    ChordConfig& cfg = a->batchCfg;
+    ChordComputeData& data = *a->batchData;
+    if(cfg.smoother) resetViterbi(*cfg.smoother); // every batch is a sequence of its own
+    const int states = data.states;
+    const bool stream = cfg.frontEnd != FrontEnd::Fft;
+    for(long i = 0; i < count; i++) {
+        const float* x = frames + i*stride;
+        if(stream) resetChordStream(cfg, x);
+        computeChord(data, x, cfg);
+        fillResult(*a, data, results[i]);
+        results[i].frame = i;
+        results[i].time = -1;
+        if(labelReady(cfg)) setLabel(*a, results[i - labelLag(cfg)], data.label);
+        if(scores) memcpy(scores + i*states, data.scores, sizeof(float)*states);
+    }
+    if(cfg.smoother) {
+        // the rows still inside the lag, decoded from the whole batch
+        const int rest = flushViterbi(*cfg.smoother, a->flushed.data());
+        for(int i = 0; i < rest; i++) setLabel(*a, results[count - rest + i], a->flushed[i]);
+    }
+    return count;
+}
+
+chordy_status chordy_get_result(const chordy_analyzer* a, chordy_result* r) {
+    if(a == nullptr || r == nullptr) return CHORDY_ERROR_ARGUMENT;
+    if(a->completed == 0) return CHORDY_ERROR_NO_RESULT;
+    *r = a->last;
+    return CHORDY_OK;
+}
+
+int chordy_get_scores(const chordy_analyzer* a, float* scores, int capacity) {
+    if(a == nullptr) return 0;
+    const int states = a->data->states;
+    if(scores && a->completed > 0) memcpy(scores, a->lastScores.data(), sizeof(float)*std::min(states, std::max(capacity, 0)));
+    return states;
+}
+
+int chordy_chord_count(const chordy_analyzer* a) {
+    return a ? a->cfg.vocab.chords : 0;
+}
+
+const char* chordy_chord_name(const chordy_analyzer* a, int chord) {
+    if(a == nullptr || chord < 0 || chord >= (int)a->names.size()) return "N/A";
+    return a->names[chord].c_str();
+}
+
+const char* chordy_last_error(const chordy_analyzer* a) {
+    return a ? a->error.c_str() : "";
+}
+
+const char* chordy_status_string(chordy_status status) {
+    switch(status) {
+        case CHORDY_OK: return "ok";
+        case CHORDY_ERROR_ARGUMENT: return "invalid argument";
+        case CHORDY_ERROR_VOCABULARY: return "vocabulary could not be loaded";
+        case CHORDY_ERROR_MEMORY: return "out of memory";
+        case CHORDY_ERROR_NO_RESULT: return "no frame analyzed yet";
+    }
+    return "unknown status";
+}
+
+}
@@ -0,0 +1,134 @@
+#include <cmath>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include "eventlog.h"
+#include "waiter.h"
+
+static void writeHeader(EventLog& log) {
+    if(log.format != EventFormat::Csv) return;
+    fprintf(log.out, "frame,time,clock_ms,job_us,label,raw,score,f0");
+    for(int i = 1; i <= eventTopK; i++) fprintf(log.out, ",top%d,top%d_score", i, i);
+    fprintf(log.out, "\n");
+}
+
+static void writeEvent(EventLog& log, const ChordEvent& ev) {
+    const std::string label = chordName(log.vocab, ev.label), raw = chordName(log.vocab, ev.raw);
+    if(log.format == EventFormat::Csv) {
+        fprintf(log.out, "%ld,%.6f,%.3f,%.2f,%s,%s,", ev.frame, ev.time, ev.clockNs/1e6, ev.jobUs, label.c_str(), raw.c_str());
+        if(std::isfinite(ev.score)) fprintf(log.out, "%g", ev.score);
+        fprintf(log.out, ",%.2f", ev.f0);
+        for(int i = 0; i < eventTopK; i++) {
+            if(i < ev.topCount) fprintf(log.out, ",%s,%.4f", chordName(log.vocab, ev.top[i]).c_str(), ev.topScores[i]);
+            else fprintf(log.out, ",,");
+        }
+        fprintf(log.out, "\n");
+        return;
+    }
+    fprintf(log.out, "{\"frame\":%ld,", ev.frame);
+    if(ev.time >= 0) fprintf(log.out, "\"time\":%.6f,", ev.time);
+    fprintf(log.out, "\"clock_ms\":%.3f,\"job_us\":%.2f,\"label\":\"%s\",\"raw\":\"%s\",", ev.clockNs/1e6, ev.jobUs, label.c_str(), raw.c_str());
+    if(std::isfinite(ev.score)) fprintf(log.out, "\"score\":%g,", ev.score); // silence divides 0 by 0
+    else fprintf(log.out, "\"score\":null,");
+    fprintf(log.out, "\"f0\":%.2f,\"top\":[", ev.f0);
+    for(int i = 0; i < ev.topCount; i++) {
+        fprintf(log.out, "%s{\"chord\":\"%s\",\"score\":%.4f}", i ? "," : "", chordName(log.vocab, ev.top[i]).c_str(), ev.topScores[i]);
+    }
+    fprintf(log.out, "]}\n");
+}
+
+// writes everything published so far; true if there was anything
+static bool drain(EventLog& log) {
+    const unsigned long head = log.head.load(std::memory_order_acquire);
+    unsigned long tail = log.tail.load(std::memory_order_relaxed);
+    if(tail == head) return false;
+    for(; tail != head; tail++) {
+        writeEvent(log, log.ring[tail & log.mask]);
+        log.tail.store(tail+1, std::memory_order_release); // free the slot as soon as it is read
+    }
+    fflush(log.out);
+    return true;
+}
+
+static void drainLoop(EventLog* log) {
+    while(log->run.load(std::memory_order_acquire)) {
+        if(!drain(*log)) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    drain(*log);
+}
+
+EventLog* openEventLog(const std::string& path, EventLevel level, EventFormat format, const ChordVocabulary& vocab, bool lossless, int capacity) {
+    FILE* out = path == "-" ? stdout : fopen(path.c_str(), "w");
+    if(out == nullptr) return nullptr;
+    EventLog* log = new EventLog();
+    log->level = level;
+    log->format = format;
+    log->lossless = lossless;
+    log->out = out;
+    log->vocab = vocab;
+    unsigned long cap = 1;
+    while(cap < (unsigned long)std::max(capacity, 2)) cap <<= 1;
+    log->ring = new ChordEvent[cap];
+    log->mask = cap-1;
+    log->startNs = steadyNowNs();
+    writeHeader(*log);
+    log->drainer = std::thread(drainLoop, log);
+    return log;
+}
+
+void closeEventLog(EventLog* log) {
+    if(log == nullptr) return;
+    log->run.store(false, std::memory_order_release);
+    log->drainer.join();
+    const unsigned long dropped = log->dropped.load();
+    if(dropped) fprintf(stderr, "event log: %lu records dropped, the drainer fell behind\n", dropped);
+    if(log->out == stdout) fflush(stdout);
+    else fclose(log->out);
+    delete[] log->ring;
+    delete log;
+}
+
+bool logChordEvent(EventLog& log, ChordEvent& ev) {
+    ev.frame = log.frames++;
+    const int last = log.lastLabel;
+    log.lastLabel = ev.label;
+    switch(log.level.load(std::memory_order_relaxed)) {
+        case EventLevel::Off: return false;
+        case EventLevel::Changes: if(ev.label == last) return false; break;
+        case EventLevel::Detections: if(ev.raw >= log.vocab.chords) return false; break;
+        case EventLevel::Frames: break;
+    }
+    ev.clockNs = steadyNowNs() - log.startNs;
+
+    const unsigned long head = log.head.load(std::memory_order_relaxed);
+    while(head - log.tailSeen > log.mask && head - (log.tailSeen = log.tail.load(std::memory_order_acquire)) > log.mask) {
+        if(!log.lossless) { log.dropped.fetch_add(1, std::memory_order_relaxed); return false; }
+        std::this_thread::yield();
+    }
+    log.ring[head & log.mask] = ev;
+    log.head.store(head+1, std::memory_order_release);
+    return true;
+}
+
+void selectTopChords(ChordEvent& ev, const float* scores, int chords, int* order) {
+    ev.topCount = std::min(eventTopK, chords);
+    for(int c = 0; c < chords; c++) order[c] = c;
+    std::partial_sort(order, order + ev.topCount, order + chords, [scores](int a, int b) {
+        return scores[a] > scores[b];
+    });
+    for(int i = 0; i < ev.topCount; i++) { ev.top[i] = order[i]; ev.topScores[i] = scores[order[i]]; }
+}
+
+bool parseEventLevel(const char* s, EventLevel& level) {
+    for(int i = 0; i < 4; i++) {
+        if(!strcmp(s, eventLevelNames[i])) { level = (EventLevel)i; return true; }
+    }
+    return false;
+}
+
+bool parseEventFormat(const char* s, EventFormat& format) {
+    for(int i = 0; i < 2; i++) {
+        if(!strcmp(s, eventFormatNames[i])) { format = (EventFormat)i; return true; }
+    }
+    return false;
+}
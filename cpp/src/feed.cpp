@@ -0,0 +1,205 @@
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "feed.h"
+#include "waiter.h"
+
+static std::string shmPath(const std::string& name) {
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+static uint32_t roundUp64(size_t bytes) {
+    return (bytes + 63) & ~(size_t)63;
+}
+
+ChordFeed* openChordFeed(const std::string& name, const ChordVocabulary& vocab, int capacity) {
+    uint32_t slots = 1;
+    while(slots < (uint32_t)std::max(capacity, 1)) slots *= 2;
+    // names in whole 16-byte strides, so long custom qualities arrive intact
+    size_t longest = 0;
+    for(int c = 0; c <= vocab.chords; c++) longest = std::max(longest, chordName(vocab, c).size());
+    const uint32_t nameSize = (longest + 1 + 15) & ~(size_t)15;
+    const uint32_t namesOffset = roundUp64(sizeof(chordy_feed_header));
+    const uint32_t slotsOffset = roundUp64(namesOffset + (vocab.chords + 1)*(size_t)nameSize);
+    const uint32_t slotSize = roundUp64(sizeof(chordy_feed_slot)); // no two slots share a cache line
+    const size_t size = slotsOffset + (size_t)slots*slotSize;
+
+    // a fresh object every time: readers of a previous run keep their mapping of the old one
+    const std::string path = shmPath(name);
+    shm_unlink(path.c_str());
+    const int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if(fd < 0) return nullptr;
+    if(ftruncate(fd, size) != 0) {
+        const int err = errno;
+        close(fd); shm_unlink(path.c_str());
+        errno = err;
+        return nullptr;
+    }
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int err = errno;
+    close(fd);
+    if(base == MAP_FAILED) { shm_unlink(path.c_str()); errno = err; return nullptr; }
+
+    ChordFeed* feed = new ChordFeed();
+    feed->name = path;
+    feed->size = size;
+    feed->header = (chordy_feed_header*)base;
+    feed->slots = (unsigned char*)base + slotsOffset;
+    chordy_feed_header& h = *feed->header; // zero-filled by ftruncate
+    h.version = CHORDY_FEED_VERSION;
+    h.header_size = sizeof(chordy_feed_header);
+    h.slot_size = slotSize;
+    h.capacity = slots;
+    h.chord_count = vocab.chords;
+    h.names_offset = namesOffset;
+    h.slots_offset = slotsOffset;
+    h.publisher_pid = getpid();
+    h.name_size = nameSize;
+    char* names = (char*)base + namesOffset;
+    for(int c = 0; c <= vocab.chords; c++) {
+        const std::string chord = chordName(vocab, c);
+        memcpy(names + c*nameSize, chord.c_str(), chord.size()); // the rest is zero already
+    }
+    __atomic_store_n(&h.magic, CHORDY_FEED_MAGIC, __ATOMIC_RELEASE); // readers may map it from here
+    return feed;
+}
+
+void closeChordFeed(ChordFeed* feed) {
+    if(feed == nullptr) return;
+    __atomic_store_n(&feed->header->closed, 1u, __ATOMIC_RELEASE);
+    munmap(feed->header, feed->size);
+    shm_unlink(feed->name.c_str());
+    delete feed;
+}
+
+void publishChordFeed(ChordFeed& feed, const ChordEvent& ev, const float* chroma, long long adcNs) {
+    chordy_feed_frame f;
+    f.frame = feed.frames;
+    f.time = ev.time;
+    f.adc_ns = adcNs;
+    f.publish_ns = steadyNowNs();
+    f.chord = ev.label; f.raw = ev.raw;
+    f.score = ev.score; f.f0 = ev.f0;
+    f.top_count = std::min(ev.topCount, CHORDY_FEED_TOP_K);
+    for(int i = 0; i < CHORDY_FEED_TOP_K; i++) {
+        f.top[i] = i < f.top_count ? ev.top[i] : -1;
+        f.top_scores[i] = i < f.top_count ? ev.topScores[i] : 0.f;
+    }
+    memcpy(f.chroma, chroma, sizeof(f.chroma));
+
+    chordy_feed_slot* slot = (chordy_feed_slot*)(feed.slots + (feed.frames & (feed.header->capacity-1))*feed.header->slot_size);
+    const uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->seq, seq+1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE); // odd before any of the frame
+    memcpy(&slot->frame, &f, sizeof(f));
+    __atomic_store_n(&slot->seq, seq+2, __ATOMIC_RELEASE);
+    __atomic_store_n(&feed.header->head, (uint64_t)++feed.frames, __ATOMIC_RELEASE);
+}
+
+struct chordy_feed_reader {
+    const chordy_feed_header* header;
+    size_t size;
+    const char* names;
+    const unsigned char* slots;
+    uint64_t next; // frame to read next
+};
+
+chordy_feed_reader* chordy_feed_open(const char* name) {
+    if(name == nullptr) { errno = EINVAL; return nullptr; }
+    const int fd = shm_open(shmPath(name).c_str(), O_RDONLY, 0);
+    if(fd < 0) return nullptr;
+    struct stat st;
+    if(fstat(fd, &st) != 0) { const int err = errno; close(fd); errno = err; return nullptr; }
+    const size_t size = st.st_size;
+    if(size < sizeof(chordy_feed_header)) { close(fd); errno = ENOENT; return nullptr; } // not sized yet
+    void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    const int err = errno;
+    close(fd);
+    if(base == MAP_FAILED) { errno = err; return nullptr; }
+
+    const chordy_feed_header* h = (const chordy_feed_header*)base;
+    const uint32_t magic = __atomic_load_n(&h->magic, __ATOMIC_ACQUIRE);
+    int bad = 0;
+    if(magic == 0) bad = ENOENT; // the publisher is still filling it in
+    else if(magic != CHORDY_FEED_MAGIC || h->version != CHORDY_FEED_VERSION
+            || h->header_size < sizeof(chordy_feed_header) || h->slot_size < sizeof(chordy_feed_slot)
+            || h->capacity == 0 || (h->capacity & (h->capacity-1)) != 0
+            || h->name_size == 0
+            || h->names_offset + (h->chord_count + 1ull)*h->name_size > size
+            || h->slots_offset + (uint64_t)h->capacity*h->slot_size > size) bad = EPROTO;
+    if(bad) { munmap(base, size); errno = bad; return nullptr; }
+
+    chordy_feed_reader* r = new chordy_feed_reader();
+    r->header = h;
+    r->size = size;
+    r->names = (const char*)base + h->names_offset;
+    r->slots = (const unsigned char*)base + h->slots_offset;
+    r->next = __atomic_load_n(&h->head, __ATOMIC_ACQUIRE);
+    return r;
+}
+
+void chordy_feed_close(chordy_feed_reader* reader) {
+    if(reader == nullptr) return;
+    munmap((void*)reader->header, reader->size);
+    delete reader;
+}
+
+int chordy_feed_next(chordy_feed_reader* r, chordy_feed_frame* frame, uint64_t* missed) {
+    const chordy_feed_header* h = r->header;
+    const uint64_t capacity = h->capacity;
+    for(;;) {
+        const uint64_t head = __atomic_load_n(&h->head, __ATOMIC_ACQUIRE);
+        if(r->next >= head) {
+            // closed is set after the last head store, so a second look at head settles it
+            if(!__atomic_load_n(&h->closed, __ATOMIC_ACQUIRE)) return 0;
+            return r->next >= __atomic_load_n(&h->head, __ATOMIC_ACQUIRE) ? -1 : 0;
+        }
+        if(head - r->next > capacity) { // already overwritten
+            if(missed) *missed += head - capacity - r->next;
+            r->next = head - capacity;
+        }
+        const chordy_feed_slot* slot = (const chordy_feed_slot*)(r->slots + (r->next & (capacity-1))*h->slot_size);
+        const uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if(seq & 1) return 0; // being rewritten; the next call finds the newer frame there
+        memcpy(frame, &slot->frame, sizeof(*frame));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE); // the copy before the second seq read
+        if(__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq) return 0;
+        if(frame->frame < r->next) return 0;
+        if(frame->frame > r->next) {
+            // lapped between the head read and the copy: frames up to frame - capacity are gone
+            const uint64_t to = frame->frame - capacity + 1;
+            if(missed) *missed += to - r->next;
+            r->next = to;
+            continue;
+        }
+        r->next++;
+        return 1;
+    }
+}
+
+int chordy_feed_latest(chordy_feed_reader* r, chordy_feed_frame* frame) {
+    for(;;) {
+        const uint64_t head = __atomic_load_n(&r->header->head, __ATOMIC_ACQUIRE);
+        if(head == 0) return 0;
+        r->next = head - 1;
+        if(chordy_feed_next(r, frame, nullptr) == 1) return 1;
+    }
+}
+
+const chordy_feed_header* chordy_feed_layout(const chordy_feed_reader* reader) {
+    return reader->header;
+}
+
+const char* chordy_feed_chord_name(const chordy_feed_reader* reader, int chord) {
+    const uint32_t count = reader->header->chord_count;
+    if(chord < 0 || (uint32_t)chord > count) chord = count; // N/A is last
+    return reader->names + (size_t)chord*reader->header->name_size;
+}
+
+int64_t chordy_feed_clock_ns(void) {
+    return steadyNowNs();
+}
@@ -0,0 +1,274 @@
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <utility>
+#include "fft.h"
+#include "simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CHORDY_X86 1
+#include <immintrin.h>
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+// A real FFT of n points runs as a complex FFT of n/2 points over the even/odd samples packed
+// as re/im, followed by a split into the n/2+1 real-signal bins (as kiss_fftr does).
+struct FftPlan {
+    FftBackend backend;
+    int n;
+    std::vector<kiss_fft_cpx> split; // e^{-i pi ((k+1)/(n/2) + 1/2)}, k < n/4
+    kiss_fft_cfg kiss = nullptr;     // Kiss: n/2-point complex plan
+    std::vector<float> tw;           // Radix4: per stage of length L, w^p, w^2p, w^3p (re, im) for p < L/4
+};
+
+// Shared by both backends, in kiss_fftr's exact operation order so Kiss output is unchanged.
+// z is the n/2-point complex spectrum, re at zr[k*stride], im at zi[k*stride].
+static void realSplit(const FftPlan& pl, const float* zr, const float* zi, int stride, kiss_fft_cpx* out) {
+    const int m = pl.n/2;
+    out[0].r = zr[0] + zi[0];
+    out[m].r = zr[0] - zi[0];
+    out[0].i = out[m].i = 0;
+    for(int k = 1; k <= m/2; k++) {
+        const float fpkr = zr[k*stride], fpki = zi[k*stride];
+        const float fpnkr = zr[(m-k)*stride], fpnki = -zi[(m-k)*stride];
+        const float f1kr = fpkr + fpnkr, f1ki = fpki + fpnki;
+        const float f2kr = fpkr - fpnkr, f2ki = fpki - fpnki;
+        const kiss_fft_cpx w = pl.split[k-1];
+        const float twr = f2kr*w.r - f2ki*w.i, twi = f2kr*w.i + f2ki*w.r;
+        out[k].r = (f1kr + twr)*.5f;
+        out[k].i = (f1ki + twi)*.5f;
+        out[m-k].r = (f1kr - twr)*.5f;
+        out[m-k].i = (twi - f1ki)*.5f;
+    }
+}
+
+#define FFT_FN(name) name##Scalar
+#define FFT_TARGET
+#define V float
+#define VW 1
+#define VLOAD(p) (*(p))
+#define VSTORE(p, v) (*(p) = (v))
+#define VSET1(x) (x)
+#define VADD(a, b) ((a) + (b))
+#define VSUB(a, b) ((a) - (b))
+#define VMUL(a, b) ((a) * (b))
+#include "fft_stages.inc"
+#undef FFT_FN
+#undef FFT_TARGET
+#undef V
+#undef VW
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VADD
+#undef VSUB
+#undef VMUL
+
+#ifdef CHORDY_X86
+#define FFT_FN(name) name##Sse2
+#define FFT_TARGET TARGET_SSE2
+#define V __m128
+#define VW 4
+#define VLOAD(p) _mm_loadu_ps(p)
+#define VSTORE(p, v) _mm_storeu_ps(p, v)
+#define VSET1(x) _mm_set1_ps(x)
+#define VADD(a, b) _mm_add_ps(a, b)
+#define VSUB(a, b) _mm_sub_ps(a, b)
+#define VMUL(a, b) _mm_mul_ps(a, b)
+#include "fft_stages.inc"
+#undef FFT_FN
+#undef FFT_TARGET
+#undef V
+#undef VW
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VADD
+#undef VSUB
+#undef VMUL
+
+#define FFT_FN(name) name##Avx2
+#define FFT_TARGET TARGET_AVX2
+#define V __m256
+#define VW 8
+#define VLOAD(p) _mm256_loadu_ps(p)
+#define VSTORE(p, v) _mm256_storeu_ps(p, v)
+#define VSET1(x) _mm256_set1_ps(x)
+#define VADD(a, b) _mm256_add_ps(a, b)
+#define VSUB(a, b) _mm256_sub_ps(a, b)
+#define VMUL(a, b) _mm256_mul_ps(a, b)
+#include "fft_stages.inc"
+#undef FFT_FN
+#undef FFT_TARGET
+#undef V
+#undef VW
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VADD
+#undef VSUB
+#undef VMUL
+
+#define FFT_FN(name) name##Avx512
+#define FFT_TARGET TARGET_AVX512
+#define V __m512
+#define VW 16
+#define VLOAD(p) _mm512_loadu_ps(p)
+#define VSTORE(p, v) _mm512_storeu_ps(p, v)
+#define VSET1(x) _mm512_set1_ps(x)
+#define VADD(a, b) _mm512_add_ps(a, b)
+#define VSUB(a, b) _mm512_sub_ps(a, b)
+#define VMUL(a, b) _mm512_mul_ps(a, b)
+#include "fft_stages.inc"
+#undef FFT_FN
+#undef FFT_TARGET
+#undef V
+#undef VW
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VADD
+#undef VSUB
+#undef VMUL
+
+TARGET_SSE2 static inline void loadComplexSse2(const float* p, __m128& re, __m128& im) {
+    const __m128 a = _mm_loadu_ps(p), b = _mm_loadu_ps(p + 4);
+    re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+// The first stage has s = 1, too short to vectorize along q, so it runs along p instead: it
+// reads the interleaved real input as complex pairs and transposes each 4x4 block of outputs.
+TARGET_SSE2 static void radix4FirstStageSse2(int L, const float* in, float* yr, float* yi, const float* tw) {
+    const int m = L/4;
+    const float *w1r = tw, *w1i = tw + m, *w2r = tw + 2*m, *w2i = tw + 3*m, *w3r = tw + 4*m, *w3i = tw + 5*m;
+    for(int p = 0; p < m; p += 4) {
+        __m128 ar, ai, br, bi, cr, ci, dr, di;
+        loadComplexSse2(in + 2*p, ar, ai);
+        loadComplexSse2(in + 2*(p + m), br, bi);
+        loadComplexSse2(in + 2*(p + 2*m), cr, ci);
+        loadComplexSse2(in + 2*(p + 3*m), dr, di);
+        const __m128 apcr = _mm_add_ps(ar, cr), apci = _mm_add_ps(ai, ci), amcr = _mm_sub_ps(ar, cr), amci = _mm_sub_ps(ai, ci);
+        const __m128 bpdr = _mm_add_ps(br, dr), bpdi = _mm_add_ps(bi, di), bmdr = _mm_sub_ps(br, dr), bmdi = _mm_sub_ps(bi, di);
+        const __m128 t1r = _mm_add_ps(amcr, bmdi), t1i = _mm_sub_ps(amci, bmdr);
+        const __m128 t2r = _mm_sub_ps(apcr, bpdr), t2i = _mm_sub_ps(apci, bpdi);
+        const __m128 t3r = _mm_sub_ps(amcr, bmdi), t3i = _mm_add_ps(amci, bmdr);
+        const __m128 c1r = _mm_loadu_ps(w1r + p), c1i = _mm_loadu_ps(w1i + p), c2r = _mm_loadu_ps(w2r + p), c2i = _mm_loadu_ps(w2i + p);
+        const __m128 c3r = _mm_loadu_ps(w3r + p), c3i = _mm_loadu_ps(w3i + p);
+        __m128 y0r = _mm_add_ps(apcr, bpdr), y0i = _mm_add_ps(apci, bpdi);
+        __m128 y1r = _mm_sub_ps(_mm_mul_ps(t1r, c1r), _mm_mul_ps(t1i, c1i)), y1i = _mm_add_ps(_mm_mul_ps(t1r, c1i), _mm_mul_ps(t1i, c1r));
+        __m128 y2r = _mm_sub_ps(_mm_mul_ps(t2r, c2r), _mm_mul_ps(t2i, c2i)), y2i = _mm_add_ps(_mm_mul_ps(t2r, c2i), _mm_mul_ps(t2i, c2r));
+        __m128 y3r = _mm_sub_ps(_mm_mul_ps(t3r, c3r), _mm_mul_ps(t3i, c3i)), y3i = _mm_add_ps(_mm_mul_ps(t3r, c3i), _mm_mul_ps(t3i, c3r));
+        _MM_TRANSPOSE4_PS(y0r, y1r, y2r, y3r);
+        _MM_TRANSPOSE4_PS(y0i, y1i, y2i, y3i);
+        _mm_storeu_ps(yr + 4*p, y0r); _mm_storeu_ps(yr + 4*p + 4, y1r); _mm_storeu_ps(yr + 4*p + 8, y2r); _mm_storeu_ps(yr + 4*p + 12, y3r);
+        _mm_storeu_ps(yi + 4*p, y0i); _mm_storeu_ps(yi + 4*p + 4, y1i); _mm_storeu_ps(yi + 4*p + 8, y2i); _mm_storeu_ps(yi + 4*p + 12, y3i);
+    }
+}
+#endif
+
+// widest stage the level supports whose vector width divides s
+static void radix4Stage(SimdLevel level, int L, int s, const float* xr, const float* xi, float* yr, float* yi, const float* tw) {
+#ifdef CHORDY_X86
+    if(level >= SimdLevel::Avx512 && s % 16 == 0) return radix4StageAvx512(L, s, xr, xi, yr, yi, tw);
+    if(level >= SimdLevel::Avx2 && s % 8 == 0) return radix4StageAvx2(L, s, xr, xi, yr, yi, tw);
+    if(level >= SimdLevel::Sse2 && s % 4 == 0) return radix4StageSse2(L, s, xr, xi, yr, yi, tw);
+#endif
+    radix4StageScalar(L, s, xr, xi, yr, yi, tw);
+}
+
+static void radix2Stage(SimdLevel level, int s, const float* xr, const float* xi, float* yr, float* yi) {
+#ifdef CHORDY_X86
+    if(level >= SimdLevel::Avx512 && s % 16 == 0) return radix2StageAvx512(s, xr, xi, yr, yi);
+    if(level >= SimdLevel::Avx2 && s % 8 == 0) return radix2StageAvx2(s, xr, xi, yr, yi);
+    if(level >= SimdLevel::Sse2 && s % 4 == 0) return radix2StageSse2(s, xr, xi, yr, yi);
+#endif
+    radix2StageScalar(s, xr, xi, yr, yi);
+}
+
+// scratch holds two split-complex buffers of n/2 points that the stages ping-pong between
+static void radix4Forward(const FftPlan& pl, const float* in, kiss_fft_cpx* out, float* scratch) {
+    const SimdLevel level = activeSimdLevel();
+    const int m = pl.n/2;
+    float* re[2] = {scratch, scratch + 2*m};
+    float* im[2] = {scratch + m, scratch + 3*m};
+    const float* tw = pl.tw.data();
+    int cur = 0, L = m, s = 1;
+
+#ifdef CHORDY_X86
+    if(level >= SimdLevel::Sse2) radix4FirstStageSse2(L, in, re[0], im[0], tw);
+    else
+#endif
+    {
+        for(int i = 0; i < m; i++) { re[1][i] = in[2*i]; im[1][i] = in[2*i+1]; }
+        radix4StageScalar(L, s, re[1], im[1], re[0], im[0], tw);
+    }
+    tw += 6*(L/4); L /= 4; s *= 4;
+
+    for(; L >= 4; tw += 6*(L/4), L /= 4, s *= 4) {
+        radix4Stage(level, L, s, re[cur], im[cur], re[cur^1], im[cur^1], tw);
+        cur ^= 1;
+    }
+    if(L == 2) {
+        radix2Stage(level, s, re[cur], im[cur], re[cur^1], im[cur^1]);
+        cur ^= 1;
+    }
+    realSplit(pl, re[cur], im[cur], 1, out);
+}
+
+static FftPlan* makeFftPlan(FftBackend backend, int n) {
+    FftPlan* pl = new FftPlan();
+    pl->backend = backend;
+    pl->n = n;
+    const int m = n/2;
+    for(int k = 0; k < m/2; k++) {
+        const double phase = -M_PI*((double)(k+1)/m + .5);
+        pl->split.push_back({(float)std::cos(phase), (float)std::sin(phase)});
+    }
+    if(backend == FftBackend::Kiss) {
+        pl->kiss = kiss_fft_alloc(m, 0, nullptr, nullptr);
+    } else {
+        for(int L = m; L >= 4; L /= 4) {
+            const int q = L/4;
+            const size_t base = pl->tw.size();
+            pl->tw.resize(base + 6*q);
+            for(int p = 0; p < q; p++) {
+                for(int j = 1; j <= 3; j++) {
+                    const double phase = -2*M_PI*j*p/L;
+                    pl->tw[base + (2*j-2)*q + p] = std::cos(phase);
+                    pl->tw[base + (2*j-1)*q + p] = std::sin(phase);
+                }
+            }
+        }
+    }
+    return pl;
+}
+
+// plans live until exit; configs hold raw pointers into this cache
+static std::mutex fftPlanMutex;
+static std::map<std::pair<int, int>, FftPlan*> fftPlans;
+
+const FftPlan* getFftPlan(FftBackend backend, int n) {
+    if(backend == FftBackend::Radix4 && (n < 32 || (n & (n-1)) != 0)) backend = FftBackend::Kiss;
+    std::lock_guard<std::mutex> lock(fftPlanMutex);
+    FftPlan*& pl = fftPlans[{(int)backend, n}];
+    if(pl == nullptr) pl = makeFftPlan(backend, n);
+    return pl;
+}
+
+FftBackend fftPlanBackend(const FftPlan* plan) {
+    return plan->backend;
+}
+
+void fftReal(const FftPlan* plan, const float* in, kiss_fft_cpx* out, float* scratch) {
+    if(plan->backend == FftBackend::Kiss) {
+        // kiss_fft only touches its own state when input and output alias, so a shared plan is safe
+        kiss_fft(plan->kiss, (const kiss_fft_cpx*)in, (kiss_fft_cpx*)scratch);
+        realSplit(*plan, scratch, scratch + 1, 2, out);
+    } else {
+        radix4Forward(*plan, in, out, scratch);
+    }
+}
@@ -0,0 +1,73 @@
+#include <cmath>
+#include <algorithm>
+#include "filterbank.h"
+#include "simd.h"
+
+int freq2Midi(float freq) {
+    return std::round(12 * std::log2(freq / 440.0) + 69);
+}
+
+float midi2Freq(int midi) {
+    return std::exp2f((midi-69)/12.)*440.;
+}
+
+int freq2Bin(float freq, int sampleRate, int n) {
+    return std::floor(freq*n/sampleRate);
+}
+
+const float qrat = 1.02930223664349F; // quarter tone ratio
+
+void buildChromaFilterbank(ChromaFilterbank& fb, int n, float sampleRate, int octaves, ChromaShape shape) {
+    fb.n = n; fb.sampleRate = sampleRate; fb.octaves = octaves; fb.shape = shape;
+    fb.rows = 12*octaves;
+    fb.rowPtr.assign(fb.rows+1, 0);
+    fb.cols.clear(); fb.weights.clear();
+    fb.bands.assign(fb.rows, 0.f);
+    fb.highPassBin = freq2Bin(50, sampleRate, n);
+    fb.topBin = 0;
+
+    // walk the bands in float exactly as the per-job loop used to, so the bin edges are unchanged
+    float mid = midi2Freq(60);
+    for(int p = 0; p < 12; p++) {
+        float lbf = mid/qrat, ubf = mid*qrat, cf = mid;
+        for(int r = 0; r < octaves; r++) {
+            const int row = p*octaves + r;
+            const int lbi = freq2Bin(lbf, sampleRate, n), ubi = std::min(freq2Bin(ubf, sampleRate, n), n/2);
+            const int start = fb.cols.size();
+            if(shape == ChromaShape::Box) {
+                // mean over the whole band, bins under the high pass count as zero
+                for(int j = std::max(lbi, fb.highPassBin); j <= ubi; j++) {
+                    fb.cols.push_back(j);
+                    fb.weights.push_back(1.f/(ubi-lbi+1));
+                }
+            } else {
+                float total = 0;
+                for(int j = lbi; j <= ubi; j++) {
+                    const float f = std::max(j, 1)*sampleRate/n;
+                    const float w = std::max(0.f, 1.f - std::fabs(std::log2(f/cf))/std::log2(qrat));
+                    total += w;
+                    if(j >= fb.highPassBin && w > 0) { fb.cols.push_back(j); fb.weights.push_back(w); }
+                }
+                // a band narrower than one bin spacing falls on its nearest bin
+                if(total == 0 && lbi <= ubi && std::lround(cf*n/sampleRate) >= fb.highPassBin) {
+                    fb.cols.push_back(std::min((int)std::lround(cf*n/sampleRate), n/2));
+                    fb.weights.push_back(total = 1);
+                }
+                for(int k = start; k < (int)fb.cols.size(); k++) fb.weights[k] /= total;
+            }
+            if((int)fb.cols.size() > start) fb.topBin = std::max(fb.topBin, fb.cols.back());
+            fb.rowPtr[row+1] = fb.cols.size();
+            lbf *= 2.F; ubf *= 2.F; cf *= 2.F;
+        }
+        mid *= qrat*qrat;
+    }
+}
+
+void applyChromaFilterbank(ChromaFilterbank& fb, const float* spec, float* chroma) {
+    activeSimdKernels().sparseMatVec(fb.bands.data(), fb.rowPtr.data(), fb.cols.data(), fb.weights.data(), fb.rows, spec);
+    for(int p = 0; p < 12; p++) {
+        chroma[p] = 1;
+        // harmonic product spectrum
+        for(int r = 0; r < fb.octaves; r++) chroma[p] *= fb.bands[p*fb.octaves + r];
+    }
+}
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "gate.h"
+#include "waiter.h"
+
+ChordGate* initChordGate(const ChordConfig& cfg, const ChordGateSettings& settings) {
+    ChordGate* g = new ChordGate();
+    g->settings = settings;
+    g->n = cfg.n;
+    g->m = 1;
+    while(g->m*2 <= std::min(cfg.n, 1024)) g->m *= 2;
+    g->binLo = std::max(1, freq2Bin(50, cfg.sampleRate, g->m));
+    g->binHi = std::max(g->binLo, std::min(freq2Bin(5000, cfg.sampleRate, g->m), g->m/2));
+    g->fft = getFftPlan(cfg.fftBackend, g->m);
+    g->windowCoeffs.resize(g->m);
+    fillWindow(g->windowCoeffs.data(), g->m, WindowType::Hann);
+    g->in.resize(g->m);
+    g->scratch.resize(fftScratchFloats(g->m));
+    g->out.resize(g->m/2+1);
+    g->mag.resize(g->m/2+1);
+    g->ref.resize(g->m/2+1);
+    return g;
+}
+
+void freeChordGate(ChordGate* g) {
+    delete g;
+}
+
+void resetChordGate(ChordGate& g) {
+    g.last = nullptr;
+    g.silentHops = g.skipped = g.settle = 0;
+    g.quietAnalyzed = false;
+}
+
+static void copyResult(ChordComputeData& to, const ChordComputeData& from, int n) {
+    memcpy(to.spec, from.spec, sizeof(float)*(n/2+1));
+    memcpy(to.hps, from.hps, sizeof(float)*(n/2+1));
+    memcpy(to.chroma, from.chroma, sizeof(float)*12);
+    memcpy(to.scores, from.scores, sizeof(float)*from.states);
+    to.f0 = from.f0; to.score = from.score;
+    to.chord = from.chord;
+}
+
+static bool sameConfig(const ChordGate& g, const ChordConfig& cfg) {
+    return g.threshold == cfg.threshold && g.octaves == cfg.octaves && g.hpsHarmonics == cfg.hpsHarmonics
+        && g.frontEnd == cfg.frontEnd && g.window == cfg.window && g.shape == cfg.filterbank.shape;
+}
+
+// mean square of x[0, count), four running sums so it vectorizes
+static float meanSquare(const float* x, long count) {
+    float acc[4] = {};
+    long i = 0;
+    for(; i+4 <= count; i += 4) {
+        for(int l = 0; l < 4; l++) acc[l] += x[i+l]*x[i+l];
+    }
+    for(; i < count; i++) acc[0] += x[i]*x[i];
+    return ((acc[0]+acc[2]) + (acc[1]+acc[3]))/count;
+}
+
+// sum |mag - ref| / sum (mag + ref) over the compared bins of the newest m samples
+static float spectralChange(ChordGate& g, const float* newest) {
+    for(int i = 0; i < g.m; i++) g.in[i] = newest[i]*g.windowCoeffs[i];
+    fftReal(g.fft, g.in.data(), g.out.data(), g.scratch.data());
+    float diff = 0, total = 0, energy = 0;
+    for(int k = g.binLo; k <= g.binHi; k++) {
+        const float power = g.out[k].r*g.out[k].r + g.out[k].i*g.out[k].i;
+        g.mag[k] = std::sqrt(power);
+        diff += std::fabs(g.mag[k] - g.ref[k]);
+        total += g.mag[k] + g.ref[k];
+        energy += power;
+    }
+    g.energy = energy;
+    return total > 0 ? diff/total : 0.f;
+}
+
+// The last analysis found no chord and the energy is where it was: the same noise floor, whose
+// spectrum differs bin for bin on every hop.
+static bool steadyNoise(const ChordGate& g, const ChordConfig& cfg) {
+    const float ratio = std::pow(10.f, g.settings.noiseDb/10);
+    return g.last->chord >= cfg.vocab.chords && g.energy <= g.refEnergy*ratio && g.energy*ratio >= g.refEnergy;
+}
+
+bool gatedComputeChord(ChordGate& g, ChordComputeData& out, const float* samples, long hop, ChordConfig& cfg) {
+    const long long st = steadyNowNs();
+    const ChordGateSettings& s = g.settings;
+    hop = std::max(1L, std::min(hop, (long)g.n));
+    const int windowHops = (g.n + hop - 1)/hop;
+
+    const bool silent = meanSquare(samples + g.n - hop, hop) <= std::pow(10.f, s.silenceDb/10);
+    g.silentHops = silent ? std::min(g.silentHops + 1, windowHops) : 0;
+    if(!silent) g.quietAnalyzed = false;
+
+    bool analyze;
+    if(g.last == nullptr || !sameConfig(g, cfg)) {
+        analyze = true;
+        spectralChange(g, samples + g.n - g.m);
+    } else if(g.silentHops >= windowHops) {
+        analyze = !g.quietAnalyzed; // nothing but silence in the window: once, then reuse
+        if(analyze) spectralChange(g, samples + g.n - g.m);
+    } else if(spectralChange(g, samples + g.n - g.m) > s.onset && !steadyNoise(g, cfg)) {
+        analyze = true;
+        g.settle = s.settleHops >= 0 ? s.settleHops : windowHops;
+    } else if(g.settle > 0) {
+        analyze = true;
+        g.settle--;
+    } else analyze = g.skipped >= s.maxSkip;
+
+    g.stats.frames++;
+    if(analyze) {
+        const long long at = steadyNowNs();
+        computeChord(out, samples, cfg);
+        const long long done = steadyNowNs();
+        g.stats.analysisNs += done - at;
+        g.stats.analyzed++;
+        std::copy(g.mag.begin() + g.binLo, g.mag.begin() + g.binHi + 1, g.ref.begin() + g.binLo);
+        g.refEnergy = g.energy;
+        g.last = &out;
+        g.skipped = 0;
+        if(g.silentHops >= windowHops) g.quietAnalyzed = true;
+        g.threshold = cfg.threshold; g.octaves = cfg.octaves; g.hpsHarmonics = cfg.hpsHarmonics;
+        g.frontEnd = cfg.frontEnd; g.window = cfg.window; g.shape = cfg.filterbank.shape;
+        g.stats.gateNs += (at - st) + (steadyNowNs() - done);
+        return true;
+    }
+
+    if(&out != g.last) copyResult(out, *g.last, g.n);
+    g.skipped++;
+    skipChordHop(cfg);
+    decideChordLabel(out, cfg);
+    const long long jobNs = steadyNowNs() - st;
+    logChordFrame(cfg, out, jobNs);
+    g.stats.gateNs += jobNs;
+    return false;
+}
+
+void addChordGateStats(ChordGateStats& to, const ChordGateStats& from) {
+    to.frames += from.frames;
+    to.analyzed += from.analyzed;
+    to.analysisNs += from.analysisNs;
+    to.gateNs += from.gateNs;
+}
+
+double chordGateSkipRatio(const ChordGateStats& s) {
+    return s.frames ? (double)(s.frames - s.analyzed)/s.frames : 0.;
+}
+
+double chordGateSavedRatio(const ChordGateStats& s) {
+    if(s.analyzed == 0) return 0.;
+    const double mean = (double)s.analysisNs/s.analyzed;
+    return ((s.frames - s.analyzed)*mean - s.gateNs)/(s.frames*mean);
+}
@@ -0,0 +1,31 @@
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include "hps.h"
+#include "simd.h"
+
+float computeHps(float* hps, const float* spec, int n, float sampleRate, int harmonics, int loBin) {
+    const int half = n/2;
+    if(harmonics < 1) {
+        memset(hps, 0, sizeof(float)*(half+1));
+        return 0;
+    }
+    const SimdKernels& k = activeSimdKernels();
+    const int count = half/harmonics + 1;
+    k.log2Range(hps, spec, half+1, hpsFloor);
+    k.harmonicMean(hps, count, harmonics);
+    memset(hps + count, 0, sizeof(float)*(half+1-count));
+
+    int best = -1;
+    float mx = std::log2(hpsFloor) + 1; // at least twice the floor
+    for(int b = std::max(loBin, 1); b < count; b++) {
+        if(hps[b] > mx) { mx = hps[b]; best = b; }
+    }
+    if(best < 0) return 0;
+    float d = 0;
+    if(best+1 < count) {
+        const float a = hps[best-1], c = hps[best+1], den = a - 2*mx + c;
+        if(den < 0) d = 0.5f*(a - c)/den;
+    }
+    return (best + d)*sampleRate/n;
+}
@@ -0,0 +1,89 @@
+#include <algorithm>
+#include "latency.h"
+
+const long long latencyMaxNs = (1LL << 48) - 1;
+
+static int bucketOf(long long ns) {
+    if(ns < 64) return ns;
+    const int e = 63 - __builtin_clzll(ns); // >= 6
+    const int sub = ns >> (e - latencySubBits); // [32, 64)
+    return 64 + (e-6)*32 + (sub-32);
+}
+
+static long long bucketUpperNs(int b) {
+    if(b < 64) return b;
+    const int e = 6 + (b-64)/32, sub = 32 + (b-64)%32;
+    return ((long long)(sub+1) << (e - latencySubBits)) - 1;
+}
+
+void recordLatency(LatencyHistogram& h, long long ns) {
+    ns = std::clamp(ns, 0LL, latencyMaxNs); // the ADC estimate can land a hair after now
+    h.counts[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+    h.total.fetch_add(1, std::memory_order_relaxed);
+    h.sumNs.fetch_add(ns, std::memory_order_relaxed);
+    long long mx = h.maxNs.load(std::memory_order_relaxed);
+    while(ns > mx && !h.maxNs.compare_exchange_weak(mx, ns, std::memory_order_relaxed));
+}
+
+long long latencyQuantileNs(const LatencyHistogram& h, double q) {
+    const unsigned long total = h.total.load(std::memory_order_relaxed);
+    if(total == 0) return 0;
+    const unsigned long rank = std::max(1UL, (unsigned long)(q*total + 0.5));
+    unsigned long seen = 0;
+    for(int b = 0; b < latencyBuckets; b++) {
+        seen += h.counts[b].load(std::memory_order_relaxed);
+        if(seen >= rank) return std::min(bucketUpperNs(b), h.maxNs.load(std::memory_order_relaxed));
+    }
+    return h.maxNs.load(std::memory_order_relaxed);
+}
+
+LatencySummary summarizeLatency(const LatencyHistogram& h) {
+    LatencySummary s;
+    s.count = h.total.load(std::memory_order_relaxed);
+    if(s.count == 0) return s;
+    s.meanUs = h.sumNs.load(std::memory_order_relaxed)/1e3/s.count;
+    s.p50Us = latencyQuantileNs(h, .5)/1e3;
+    s.p90Us = latencyQuantileNs(h, .9)/1e3;
+    s.p99Us = latencyQuantileNs(h, .99)/1e3;
+    s.p999Us = latencyQuantileNs(h, .999)/1e3;
+    s.maxUs = h.maxNs.load(std::memory_order_relaxed)/1e3;
+    return s;
+}
+
+void resetLatencyProbe(LatencyProbe& p) {
+    for(auto& h : p.stages) {
+        for(auto& c : h.counts) c.store(0, std::memory_order_relaxed);
+        h.total = 0; h.sumNs = 0; h.maxNs = 0;
+    }
+}
+
+void writeLatencyTable(FILE* out, const LatencyProbe& p) {
+    fprintf(out, "%-20s %9s %10s %10s %10s %10s %10s\n", "stage (us)", "count", "mean", "p50", "p99", "p99.9", "max");
+    for(int s = 0; s < (int)LatencyStage::Count; s++) {
+        const LatencySummary l = summarizeLatency(p.stages[s]);
+        if(l.count == 0) continue;
+        fprintf(out, "%-20s %9lu %10.1f %10.1f %10.1f %10.1f %10.1f\n", latencyStageNames[s], l.count, l.meanUs, l.p50Us, l.p99Us, l.p999Us, l.maxUs);
+    }
+}
+
+void writeLatencyJson(FILE* out, const LatencyProbe& p) {
+    fprintf(out, "{\"stages\":{");
+    bool first = true;
+    for(int s = 0; s < (int)LatencyStage::Count; s++) {
+        const LatencyHistogram& h = p.stages[s];
+        const LatencySummary l = summarizeLatency(h);
+        if(l.count == 0) continue;
+        fprintf(out, "%s\n  \"%s\":{\"count\":%lu,\"mean_us\":%.3f,\"p50_us\":%.3f,\"p90_us\":%.3f,\"p99_us\":%.3f,\"p999_us\":%.3f,\"max_us\":%.3f,\"buckets\":[",
+            first ? "" : ",", latencyStageNames[s], l.count, l.meanUs, l.p50Us, l.p90Us, l.p99Us, l.p999Us, l.maxUs);
+        first = false;
+        bool firstBucket = true;
+        for(int b = 0; b < latencyBuckets; b++) {
+            const unsigned long c = h.counts[b].load(std::memory_order_relaxed);
+            if(c == 0) continue;
+            fprintf(out, "%s[%lld,%lu]", firstBucket ? "" : ",", bucketUpperNs(b), c);
+            firstBucket = false;
+        }
+        fprintf(out, "]}");
+    }
+    fprintf(out, "\n}}\n");
+}
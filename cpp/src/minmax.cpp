@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cstring>
+#include "minmax.h"
+
+const long finestBucket = 4;
+const long minBuckets = 16; // coarsest level keeps at least this many over the whole history
+
+void initMinMaxPyramid(MinMaxPyramid& p, long minCapacity) {
+    p.capacity = finestBucket*minBuckets;
+    while(p.capacity < minCapacity) p.capacity *= 2;
+    p.written = p.capacity; // the history starts out as silence, so every bucket is live
+    p.levels.clear();
+    for(long bucket = finestBucket; p.capacity/bucket >= minBuckets; bucket *= 2) {
+        MinMaxLevel l;
+        l.bucket = bucket;
+        l.mn.assign(p.capacity/bucket, 0.f);
+        l.mx.assign(p.capacity/bucket, 0.f);
+        p.levels.push_back(std::move(l));
+    }
+}
+
+void pushMinMaxPyramid(MinMaxPyramid& p, const float* x, long count) {
+    if(count > p.capacity) { // only the newest capacity samples stay visible
+        p.written += count - p.capacity;
+        x += count - p.capacity;
+        count = p.capacity;
+    }
+    if(count <= 0) return;
+    const long start = p.written;
+    p.written += count;
+
+    // finest level straight from the samples, one bucket at a time
+    MinMaxLevel& f = p.levels[0];
+    const long fMask = f.mn.size() - 1;
+    for(long i = 0; i < count;) {
+        const long abs = start + i, b = abs/f.bucket;
+        const long end = std::min(count, (b+1)*f.bucket - start);
+        float mn = x[i], mx = x[i];
+        for(long j = i+1; j < end; j++) { mn = std::min(mn, x[j]); mx = std::max(mx, x[j]); }
+        if(abs % f.bucket != 0) { // continues a partial bucket
+            mn = std::min(mn, f.mn[b & fMask]);
+            mx = std::max(mx, f.mx[b & fMask]);
+        }
+        f.mn[b & fMask] = mn; f.mx[b & fMask] = mx;
+        i = end;
+    }
+
+    // then every parent of a touched bucket from its two children; a child past the newest
+    // sample holds an older bucket and is skipped
+    long lo = start/f.bucket, hi = (p.written-1)/f.bucket;
+    for(size_t l = 1; l < p.levels.size(); l++) {
+        const MinMaxLevel& c = p.levels[l-1];
+        MinMaxLevel& q = p.levels[l];
+        const long cMask = c.mn.size() - 1, qMask = q.mn.size() - 1, newest = hi;
+        lo /= 2; hi /= 2;
+        for(long b = lo; b <= hi; b++) {
+            float mn = c.mn[2*b & cMask], mx = c.mx[2*b & cMask];
+            if(2*b+1 <= newest) { mn = std::min(mn, c.mn[(2*b+1) & cMask]); mx = std::max(mx, c.mx[(2*b+1) & cMask]); }
+            q.mn[b & qMask] = mn; q.mx[b & qMask] = mx;
+        }
+    }
+}
+
+MinMaxSpan readMinMaxPyramid(const MinMaxPyramid& p, long count, long points, float* out) {
+    MinMaxSpan span;
+    if(count < 2*points || p.levels.empty()) return span;
+    size_t l = 0;
+    while(l+1 < p.levels.size() && p.levels[l+1].bucket*points <= 2*count) l++;
+    const MinMaxLevel& lv = p.levels[l];
+    const long mask = lv.mn.size() - 1;
+    const long first = (p.written - count)/lv.bucket, last = (p.written-1)/lv.bucket;
+    for(long b = first; b <= last; b++) {
+        out[span.values++] = lv.mn[b & mask];
+        out[span.values++] = lv.mx[b & mask];
+    }
+    span.bucket = lv.bucket;
+    span.offset = p.written - first*lv.bucket;
+    return span;
+}
+
+long decimateMinMax(const float* x, long count, long points, float* out, long& values) {
+    if(count <= points) {
+        memcpy(out, x, sizeof(float)*count);
+        values = count;
+        return 1;
+    }
+    const long bucket = (2*count + points - 1)/points;
+    values = 0;
+    for(long i = 0; i < count; i += bucket) {
+        const long end = std::min(count, i + bucket);
+        float mn = x[i], mx = x[i];
+        for(long j = i+1; j < end; j++) { mn = std::min(mn, x[j]); mx = std::max(mx, x[j]); }
+        out[values++] = mn; out[values++] = mx;
+    }
+    return bucket;
+}
@@ -0,0 +1,90 @@
+#include <cstring>
+#include <new>
+#include <algorithm>
+#include <cstdio>
+#include <atomic>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "mirror.h"
+
+#if !defined(_WIN32)
+static int anonymousFd(size_t bytes) {
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+    int fd = memfd_create("chordy-mirror", MFD_CLOEXEC);
+#else
+    static std::atomic<int> counter{0};
+    char name[64];
+    snprintf(name, sizeof(name), "/chordy-mirror-%d-%d", (int)getpid(), counter++);
+    int fd = shm_open(name, O_RDWR|O_CREAT|O_EXCL, 0600);
+    if(fd >= 0) shm_unlink(name);
+#endif
+    if(fd < 0) return -1;
+    if(ftruncate(fd, bytes) != 0) { close(fd); return -1; }
+    return fd;
+}
+
+static float* mapTwice(size_t bytes) {
+    int fd = anonymousFd(bytes);
+    if(fd < 0) return nullptr;
+
+    // reserve 2x address space, then map the same pages over both halves
+    char* base = (char*)mmap(nullptr, 2*bytes, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if(base == MAP_FAILED) { close(fd); return nullptr; }
+    void* lo = mmap(base, bytes, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, fd, 0);
+    void* hi = mmap(base+bytes, bytes, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, fd, 0);
+    close(fd);
+    if(lo != base || hi != base+bytes) { munmap(base, 2*bytes); return nullptr; }
+    return (float*)base;
+}
+#endif
+
+bool initMirrorBuffer(MirrorBuffer& b, long minCapacity) {
+    long page = 4096;
+#if !defined(_WIN32)
+    page = sysconf(_SC_PAGESIZE);
+#endif
+    const long pageFloats = page/sizeof(float);
+    b.capacity = (minCapacity + pageFloats-1)/pageFloats*pageFloats;
+    b.writeInd = 0;
+    b.data = nullptr;
+    b.mirrored = false;
+#if !defined(_WIN32)
+    b.data = mapTwice(b.capacity*sizeof(float));
+    b.mirrored = b.data != nullptr;
+#endif
+    if(b.data == nullptr) b.data = new (std::nothrow) float[2*b.capacity]();
+    return b.data != nullptr;
+}
+
+void freeMirrorBuffer(MirrorBuffer& b) {
+    if(b.data == nullptr) return;
+#if !defined(_WIN32)
+    if(b.mirrored) munmap(b.data, 2*b.capacity*sizeof(float));
+    else delete[] b.data;
+#else
+    delete[] b.data;
+#endif
+    b.data = nullptr;
+}
+
+void writeMirrorBuffer(MirrorBuffer& b, const float* x, long count) {
+    if(b.mirrored) {
+        memcpy(b.data + b.writeInd, x, sizeof(float)*count); // spills into the alias past the end
+    } else {
+        // emulate the alias: keep both halves identical
+        long right = std::min(count, b.capacity - b.writeInd);
+        memcpy(b.data + b.writeInd, x, sizeof(float)*right);
+        memcpy(b.data + b.writeInd + b.capacity, x, sizeof(float)*right);
+        memcpy(b.data, x + right, sizeof(float)*(count-right));
+        memcpy(b.data + b.capacity, x + right, sizeof(float)*(count-right));
+    }
+    b.writeInd = (b.writeInd + count) % b.capacity;
+}
+
+void clearMirrorBuffer(MirrorBuffer& b) {
+    memset(b.data, 0, sizeof(float)*(b.mirrored ? b.capacity : 2*b.capacity));
+    b.writeInd = 0;
+}
@@ -0,0 +1,142 @@
+#include <cmath>
+#include <algorithm>
+#include "multirate.h"
+#include "filterbank.h"
+#include "simd.h"
+
+// Half-band lowpass, 31 taps: 0.5 at the center, zero at the other even offsets, Blackman
+// windowed sinc at the odd ones. Passband to 0.15, stopband from 0.35 of the input rate.
+const int halfTaps = 15;
+const long multirateChunk = 4096; // input samples run through the cascade at a time
+const int minOctavePoints = 64;
+
+struct HalfBand {
+    float odd[(halfTaps+1)/2]; // taps at offsets 1, 3, ..., halfTaps
+    float center;
+};
+
+static HalfBand designHalfBand() {
+    HalfBand h;
+    double sum = 0.5, taps[(halfTaps+1)/2];
+    for(int j = 0; j < (halfTaps+1)/2; j++) {
+        const int k = 2*j+1;
+        const double w = 0.42 + 0.5*std::cos(M_PI*k/(halfTaps+1)) + 0.08*std::cos(2*M_PI*k/(halfTaps+1));
+        taps[j] = std::sin(M_PI*k/2)/(M_PI*k)*w;
+        sum += 2*taps[j];
+    }
+    for(int j = 0; j < (halfTaps+1)/2; j++) h.odd[j] = taps[j]/sum; // unit gain at DC
+    h.center = 0.5/sum;
+    return h;
+}
+
+static const HalfBand halfBand = designHalfBand();
+
+// y[i] = filtered a around a[2i+1+halfTaps]; a holds 2*outs + 2*halfTaps samples
+static void decimate(float* __restrict y, const float* __restrict a, long outs) {
+    for(long i = 0; i < outs; i++) {
+        const float* c = a + 2*i+1 + halfTaps;
+        float acc = halfBand.center*c[0];
+        for(int j = 0; j < (halfTaps+1)/2; j++) acc += halfBand.odd[j]*(c[-(2*j+1)] + c[2*j+1]);
+        y[i] = acc;
+    }
+}
+
+MultirateFrontEnd* initMultirate(int n, float sampleRate, int octaves, WindowType window, FftBackend backend) {
+    MultirateFrontEnd* mr = new MultirateFrontEnd();
+    mr->n = n;
+    mr->sampleRate = sampleRate;
+    mr->window = window;
+    const float qrat = std::exp2(1/24.);
+    int stages = 1, binLo = 0;
+    for(int r = 0; r < octaves; r++) {
+        MultirateOctave o;
+        // the window span halves per octave up, as long as its narrowest band (a quarter tone
+        // either side of the pitch) still spans two bins; then decimate while the top band
+        // edge stays under 0.3 of the rate (inside the half-band passband) and the FFT keeps
+        // a few bins
+        const float fLo = midi2Freq(60 + 12*r)/qrat, fHi = midi2Freq(72 + 12*r)/qrat;
+        int minSpan = minOctavePoints;
+        while(minSpan < n && minSpan*fLo*(qrat*qrat - 1) < 2*sampleRate) minSpan *= 2;
+        const int span = std::max(n >> r, std::min(n, minSpan));
+        int d = 1;
+        while(2*d*fHi <= 0.3f*sampleRate && span/(2*d) >= minOctavePoints) d *= 2;
+        o.stage = __builtin_ctz(d);
+        o.m = span/d & ~1; // n needn't be a power of two, but the real FFT wants even points
+        o.binStep = ((unsigned long long)o.m*d << 32)/n;
+        o.binLo = binLo;
+        o.binHi = r == octaves-1 ? n/2 : std::min(freq2Bin(fHi, sampleRate, n), n/2);
+        o.fft = getFftPlan(backend, o.m);
+        o.windowCoeffs.resize(o.m);
+        fillWindow(o.windowCoeffs.data(), o.m, window);
+        binLo = std::max(binLo, o.binHi+1);
+        stages = std::max(stages, o.stage+1);
+        mr->octaves.push_back(std::move(o));
+    }
+    mr->stages.resize(stages);
+    mr->pending.assign(stages, 0);
+    for(int s = 0; s < stages; s++) {
+        long capacity = (multirateChunk >> s) + 2*halfTaps + 2;
+        for(const MultirateOctave& o : mr->octaves) if(o.stage == s) capacity = std::max(capacity, (long)o.m);
+        initMirrorBuffer(mr->stages[s], capacity);
+    }
+    mr->scratch.resize(multirateChunk/2 + 1);
+    return mr;
+}
+
+void freeMultirate(MultirateFrontEnd* mr) {
+    if(mr == nullptr) return;
+    for(MirrorBuffer& b : mr->stages) freeMirrorBuffer(b);
+    delete mr;
+}
+
+void pushMultirate(MultirateFrontEnd& mr, const float* x, long count) {
+    while(count > 0) {
+        const long take = std::min(count, multirateChunk);
+        writeMirrorBuffer(mr.stages[0], x, take);
+        long produced = take;
+        for(size_t s = 1; s < mr.stages.size(); s++) {
+            // every second input of stage s-1 yields an output; an odd one waits for the next push
+            const long total = mr.pending[s] + produced, outs = total/2;
+            decimate(mr.scratch.data(), mirrorBufferTail(mr.stages[s-1], total + 2*halfTaps), outs);
+            mr.pending[s] = total % 2;
+            writeMirrorBuffer(mr.stages[s], mr.scratch.data(), outs);
+            produced = outs;
+        }
+        x += take; count -= take;
+    }
+}
+
+static void rebuild(MultirateFrontEnd& mr, const float* window) {
+    for(MirrorBuffer& b : mr.stages) clearMirrorBuffer(b);
+    std::fill(mr.pending.begin(), mr.pending.end(), 0);
+    pushMultirate(mr, window, mr.n);
+}
+
+void resetMultirate(MultirateFrontEnd& mr, const float* window) {
+    rebuild(mr, window);
+    mr.hopCount = 0;
+}
+
+void multirateSpectrum(MultirateFrontEnd& mr, float* spec, const float* window, float* in, float* scratch, kiss_fft_cpx* out) {
+    if(mr.hopCount++ % mr.resyncHops == 0) rebuild(mr, window);
+
+    const SimdKernels& k = activeSimdKernels();
+    for(const MultirateOctave& o : mr.octaves) {
+        if(o.binLo > o.binHi) continue; // above Nyquist
+        const float* x = mirrorBufferTail(mr.stages[o.stage], o.m);
+        if(mr.window != WindowType::Rectangular) {
+            for(int i = 0; i < o.m; i++) in[i] = x[i]*o.windowCoeffs[i];
+            x = in;
+        }
+        fftReal(o.fft, x, out, scratch);
+        float* power = in; // free again once the FFT has run
+        k.powerSpectrum(power, out, o.m/2+1);
+
+        // grid bin b reads the nearest octave bin; scale to what an n-point FFT would measure
+        const float gain = (float)mr.n/o.m*mr.n/o.m;
+        for(int b = o.binLo; b <= o.binHi; b++) {
+            const int j = (b*o.binStep + (1ULL << 31)) >> 32;
+            spec[b] = j <= o.m/2 ? gain*power[j] : 0.f;
+        }
+    }
+}
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cstring>
+#include "multistream.h"
+#include "waiter.h"
+
+void initChordResultBoard(ChordResultBoard& b, int streams) {
+    b.streams = streams;
+    b.slots = new ChordBoardSlot[streams];
+}
+
+void freeChordResultBoard(ChordResultBoard& b) {
+    delete[] b.slots;
+    b.slots = nullptr;
+    b.streams = 0;
+}
+
+void publishChordResult(ChordResultBoard& b, int stream, const ChordComputeData& data, long frame) {
+    ChordBoardSlot& slot = b.slots[stream];
+    ChordBoardEntry e;
+    e.frame = frame;
+    e.label = data.label; e.raw = data.chord;
+    e.score = data.score; e.f0 = data.f0;
+    e.publishNs = data.publishNs;
+    memcpy(e.chroma, data.chroma, sizeof(e.chroma));
+
+    const unsigned seq = slot.seq.load(std::memory_order_relaxed);
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release); // odd seq is visible before the data
+    memcpy(&slot.entry, &e, sizeof(e));
+    slot.seq.store(seq + 2, std::memory_order_release);
+}
+
+bool readChordResult(const ChordResultBoard& b, int stream, ChordBoardEntry& out) {
+    const ChordBoardSlot& slot = b.slots[stream];
+    while(true) {
+        const unsigned before = slot.seq.load(std::memory_order_acquire);
+        if(before & 1) continue; // mid-write, the writer finishes in a few ns
+        memcpy(&out, &slot.entry, sizeof(out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(slot.seq.load(std::memory_order_relaxed) == before) return out.frame >= 0;
+    }
+}
+
+MultiStreamAnalyzer initMultiStreamAnalyzer(int streams, int workers, long hop, const ChordConfig& proto, int smoothLag, const float* trans) {
+    MultiStreamAnalyzer m;
+    m.streams = streams;
+    m.n = proto.n;
+    m.hop = hop;
+    m.pool = initWorkerPool(std::min(workers > 0 ? workers : streams, streams));
+    m.state.resize(streams);
+    for(StreamState& s : m.state) {
+        s.cfg = cloneChordConfig(proto);
+        s.cfg.log = nullptr; // a log has a single producer
+        if(smoothLag >= 0) setChordSmoothing(s.cfg, smoothLag, trans);
+        s.data = initChordComputeData(m.n, chordStateCount(proto));
+        initMirrorBuffer(s.history, m.n);
+        resetChordStream(s.cfg, mirrorBufferTail(s.history, m.n));
+    }
+    initChordResultBoard(m.board, streams);
+    return m;
+}
+
+void freeMultiStreamAnalyzer(MultiStreamAnalyzer& m) {
+    freeWorkerPool(m.pool);
+    m.pool = nullptr;
+    for(StreamState& s : m.state) {
+        freeChordConfig(s.cfg);
+        freeChordComputeData(s.data);
+        freeMirrorBuffer(s.history);
+        freeChordGate(s.gate);
+    }
+    m.state.clear();
+    freeChordResultBoard(m.board);
+}
+
+void carryStreamState(MultiStreamAnalyzer& to, const MultiStreamAnalyzer& from) {
+    const long keep = std::min(to.n, from.n);
+    for(int s = 0; s < std::min(to.streams, from.streams); s++) {
+        StreamState& t = to.state[s];
+        const StreamState& f = from.state[s];
+        writeMirrorBuffer(t.history, mirrorBufferTail(f.history, keep), keep);
+        resetChordStream(t.cfg, mirrorBufferTail(t.history, to.n));
+        t.sinceHop = f.sinceHop;
+        t.frames = f.frames;
+    }
+}
+
+void setStreamGating(MultiStreamAnalyzer& m, bool on, const ChordGateSettings& settings) {
+    for(StreamState& s : m.state) {
+        freeChordGate(s.gate);
+        s.gate = on ? initChordGate(s.cfg, settings) : nullptr;
+    }
+}
+
+ChordGateStats streamGateStats(const MultiStreamAnalyzer& m) {
+    ChordGateStats total;
+    for(const StreamState& s : m.state) if(s.gate) addChordGateStats(total, s.gate->stats);
+    return total;
+}
+
+void analyzeStreamSamples(MultiStreamAnalyzer& m, int stream, const float* x, long count) {
+    StreamState& s = m.state[stream];
+    if(s.sinceHop >= m.hop) s.sinceHop = 0; // hop shrunk
+    while(count > 0) {
+        // write up to the next hop boundary, then analyze the window ending there
+        const long take = std::min(count, m.hop - s.sinceHop);
+        writeMirrorBuffer(s.history, x, take);
+        pushChordSamples(s.cfg, x, take);
+        x += take; count -= take; s.sinceHop += take;
+        if(s.sinceHop < m.hop) break;
+        s.sinceHop = 0;
+
+        if(s.gate) gatedComputeChord(*s.gate, *s.data, mirrorBufferTail(s.history, m.n), m.hop, s.cfg);
+        else computeChord(*s.data, mirrorBufferTail(s.history, m.n), s.cfg);
+        s.data->publishNs = steadyNowNs();
+        publishChordResult(m.board, stream, *s.data, s.frames);
+        if(m.onFrame) m.onFrame(stream, *s.data, s.frames, m.user);
+        s.frames++;
+    }
+}
+
+struct StreamRun {
+    MultiStreamAnalyzer* m;
+    const StreamBlock* blocks;
+};
+
+static void analyzeStreamTask(int, int stream, void* user) {
+    StreamRun* run = (StreamRun*)user;
+    const StreamBlock& b = run->blocks[stream];
+    for(int p = 0; p < 2; p++) {
+        if(b.counts[p] > 0) analyzeStreamSamples(*run->m, stream, b.parts[p], b.counts[p]);
+    }
+}
+
+void analyzeStreams(MultiStreamAnalyzer& m, const StreamBlock* blocks) {
+    StreamRun run = {&m, blocks};
+    runWorkerPool(m.pool, m.streams, analyzeStreamTask, &run);
+}
@@ -0,0 +1,51 @@
+#include <algorithm>
+#include "parallel.h"
+#include "waiter.h"
+
+ParallelAnalyzer initParallelAnalyzer(int workers, long hop, const ChordConfig& proto) {
+    ParallelAnalyzer pa;
+    pa.pool = initWorkerPool(workers);
+    pa.n = proto.n;
+    pa.hop = hop;
+    pa.batchFrames = proto.sliding ? proto.sliding->resyncHops : proto.multirate ? proto.multirate->resyncHops : 16;
+    for(int w = 0; w < workerPoolSize(pa.pool); w++) {
+        pa.cfgs.push_back(cloneChordConfig(proto));
+        pa.data.push_back(initChordComputeData(pa.n, chordStateCount(proto)));
+    }
+    return pa;
+}
+
+void freeParallelAnalyzer(ParallelAnalyzer& pa) {
+    freeWorkerPool(pa.pool);
+    for(auto& cfg : pa.cfgs) freeChordConfig(cfg);
+    for(auto* x : pa.data) freeChordComputeData(x);
+    pa.cfgs.clear(); pa.data.clear();
+}
+
+struct ParallelJob {
+    ParallelAnalyzer* pa;
+    const float* samples;
+    long frames;
+    ChordFrame* out;
+};
+
+static void analyzeBatch(int worker, int task, void* user) {
+    ParallelJob* job = (ParallelJob*)user;
+    ParallelAnalyzer& pa = *job->pa;
+    const long lo = (long)task*pa.batchFrames, hi = std::min(lo+pa.batchFrames, job->frames);
+    ChordComputeData& out = *pa.data[worker];
+    ChordConfig& cfg = pa.cfgs[worker];
+    for(long f = lo; f < hi; f++) {
+        const float* window = &job->samples[f*pa.hop];
+        if(f == lo) resetChordStream(cfg, window);
+        else pushChordSamples(cfg, window + pa.n - pa.hop, pa.hop);
+        const long long st = steadyNowNs();
+        computeChord(out, window, cfg);
+        storeChordFrame(job->out[f], out, (steadyNowNs() - st)/1e3);
+    }
+}
+
+void analyzeParallel(ParallelAnalyzer& pa, const float* samples, long frames, ChordFrame* out) {
+    ParallelJob job = {&pa, samples, frames, out};
+    runWorkerPool(pa.pool, (frames + pa.batchFrames-1)/pa.batchFrames, analyzeBatch, &job);
+}
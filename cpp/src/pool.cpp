@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include "pool.h"
+
+struct WorkerQueue {
+    std::mutex m;
+    std::deque<int> tasks;
+};
+
+struct WorkerPool {
+    std::vector<std::thread> threads;
+    std::vector<WorkerQueue> queues;
+
+    std::mutex m;
+    std::condition_variable start, done;
+    unsigned long generation = 0;
+    int active = 0;
+    bool stop = false;
+
+    WorkerTask fn = nullptr;
+    void* user = nullptr;
+
+    explicit WorkerPool(int n) : queues(n) {}
+};
+
+static bool popTask(WorkerPool* pool, int worker, int& task) {
+    // own queue: front, so each worker walks its range in timestamp order
+    {
+        WorkerQueue& q = pool->queues[worker];
+        std::lock_guard<std::mutex> lock(q.m);
+        if(!q.tasks.empty()) {
+            task = q.tasks.front(); q.tasks.pop_front();
+            return true;
+        }
+    }
+    // steal: back of a peer's queue, furthest from where its owner is working
+    const int n = pool->queues.size();
+    for(int k = 1; k < n; k++) {
+        WorkerQueue& q = pool->queues[(worker+k)%n];
+        std::lock_guard<std::mutex> lock(q.m);
+        if(!q.tasks.empty()) {
+            task = q.tasks.back(); q.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+static void workerLoop(WorkerPool* pool, int worker) {
+    unsigned long seen = 0;
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(pool->m);
+            pool->start.wait(lock, [&] { return pool->stop || pool->generation != seen; });
+            if(pool->stop) return;
+            seen = pool->generation;
+        }
+
+        int task;
+        while(popTask(pool, worker, task)) pool->fn(worker, task, pool->user);
+
+        // tasks are only queued before a run starts, so empty queues mean this worker is done
+        std::lock_guard<std::mutex> lock(pool->m);
+        if(--pool->active == 0) pool->done.notify_all();
+    }
+}
+
+WorkerPool* initWorkerPool(int workers) {
+    if(workers <= 0) workers = std::max(1u, std::thread::hardware_concurrency());
+    WorkerPool* pool = new WorkerPool(workers);
+    for(int i = 0; i < workers; i++) pool->threads.emplace_back(workerLoop, pool, i);
+    return pool;
+}
+
+void freeWorkerPool(WorkerPool* pool) {
+    {
+        std::lock_guard<std::mutex> lock(pool->m);
+        pool->stop = true;
+    }
+    pool->start.notify_all();
+    for(auto& t : pool->threads) t.join();
+    delete pool;
+}
+
+int workerPoolSize(const WorkerPool* pool) {
+    return pool->queues.size();
+}
+
+void runWorkerPool(WorkerPool* pool, int tasks, WorkerTask fn, void* user) {
+    if(tasks <= 0) return;
+    const int n = pool->queues.size();
+
+    std::unique_lock<std::mutex> lock(pool->m);
+    pool->fn = fn; pool->user = user;
+    for(int w = 0; w < n; w++) {
+        // contiguous ranges keep neighbouring frames on one core until stealing kicks in
+        int lo = (long)tasks*w/n, hi = (long)tasks*(w+1)/n;
+        std::lock_guard<std::mutex> qlock(pool->queues[w].m);
+        for(int t = lo; t < hi; t++) pool->queues[w].tasks.push_back(t);
+    }
+    pool->active = n;
+    pool->generation++;
+    pool->start.notify_all();
+    pool->done.wait(lock, [&] { return pool->active == 0; });
+}
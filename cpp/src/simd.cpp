@@ -0,0 +1,482 @@
+#include <atomic>
+#include <cstring>
+#include <algorithm>
+#include "simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CHORDY_X86 1
+#include <immintrin.h>
+// each level is compiled for its own target, so the binary still runs on any x86 CPU
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+static_assert(sizeof(kiss_fft_cpx) == 2*sizeof(float), "kernels assume float kiss_fft_scalar");
+
+static void powerSpectrumScalar(float* spec, const kiss_fft_cpx* x, int count) {
+    for(int i = 0; i < count; i++) spec[i] = x[i].r*x[i].r + x[i].i*x[i].i;
+}
+
+static float sumRangeScalar(const float* x, int lo, int hi) {
+    float sm = 0;
+    for(int j = lo; j < hi; j++) sm += x[j];
+    return sm;
+}
+
+static float maxRangeScalar(const float* x, int lo, int hi) {
+    float mx = 0;
+    for(int j = lo; j < hi; j++) mx = std::max(mx, x[j]);
+    return mx;
+}
+
+// rows [r0, rows) of matVec, shared with the vector tails
+static void matVecRows(float* y, const float* a, int rows, int cols, const float* x, int r0) {
+    for(int r = r0; r < rows; r++) {
+        float sm = 0;
+        for(int c = 0; c < cols; c++) sm += a[(long)c*rows + r]*x[c];
+        y[r] = sm;
+    }
+}
+
+static void matVecScalar(float* y, const float* a, int rows, int cols, const float* x) {
+    matVecRows(y, a, rows, cols, x, 0);
+}
+
+static void sparseMatVecScalar(float* y, const int* rowPtr, const int* cols, const float* vals, int rows, const float* x) {
+    for(int r = 0; r < rows; r++) {
+        float sm = 0;
+        for(int k = rowPtr[r]; k < rowPtr[r+1]; k++) sm += vals[k]*x[cols[k]];
+        y[r] = sm;
+    }
+}
+
+// Cephes-style log2: split off the exponent, fold the mantissa into [sqrt(1/2), sqrt(2)) and
+// evaluate a degree-9 polynomial for log(1+t). Every level runs the same operations, so they
+// agree to float rounding (~1e-7 relative).
+static const float logP[9] = {7.0376836292E-2f, -1.1514610310E-1f, 1.1676998740E-1f, -1.2420140846E-1f, 1.4249322787E-1f,
+    -1.6668057665E-1f, 2.0000714765E-1f, -2.4999993993E-1f, 3.3333331174E-1f};
+static const float log2e = 1.44269504088896341f, sqrtHalf = 0.70710678118654752f;
+
+static float log2Scalar(float x) {
+    int bits; memcpy(&bits, &x, sizeof(bits));
+    float e = (float)((bits >> 23) - 127);
+    bits = (bits & 0x7fffff) | 0x3f800000;
+    float m; memcpy(&m, &bits, sizeof(m)); // [1, 2)
+    if(m > 2*sqrtHalf) { m *= 0.5f; e += 1.f; }
+    const float t = m - 1.f, z = t*t;
+    float y = logP[0];
+    for(int i = 1; i < 9; i++) y = y*t + logP[i];
+    y = y*t*z - 0.5f*z;
+    return (t + y)*log2e + e;
+}
+
+static void log2RangeScalar(float* y, const float* x, int count, float floor) {
+    for(int i = 0; i < count; i++) y[i] = log2Scalar(x[i] > floor ? x[i] : floor); // NaN -> floor, like maxps
+}
+
+// k in [k0, count) of harmonicMean, shared with the vector tails; ascending k only overwrites
+// entries below every index still to be read
+static void harmonicMeanFrom(float* x, int k0, int count, int h) {
+    const float inv = 1.f/h;
+    for(int k = k0; k < count; k++) {
+        float sm = x[k];
+        for(int j = 2; j <= h; j++) sm += x[(long)j*k];
+        x[k] = sm*inv;
+    }
+}
+
+static void harmonicMeanScalar(float* x, int count, int h) {
+    harmonicMeanFrom(x, 0, count, h);
+}
+
+// channels [c0, c1) of frames [i0, i1)
+static void deinterleaveRange(float* const* out, const float* in, int channels, int c0, int c1, long i0, long i1) {
+    for(int c = c0; c < c1; c++) {
+        float* o = out[c];
+        for(long i = i0; i < i1; i++) o[i] = in[i*channels + c];
+    }
+}
+
+static void deinterleaveScalar(float* const* out, const float* in, int channels, long frames) {
+    if(channels == 1) memcpy(out[0], in, sizeof(float)*frames);
+    else deinterleaveRange(out, in, channels, 0, channels, 0, frames);
+}
+
+#ifdef CHORDY_X86
+TARGET_SSE2 static inline float hsum128(__m128 v) {
+    __m128 s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+TARGET_SSE2 static inline float hmax128(__m128 v) {
+    __m128 s = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    s = _mm_max_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+TARGET_SSE2 static void powerSpectrumSse2(float* spec, const kiss_fft_cpx* x, int count) {
+    const float* p = (const float*)x;
+    int i = 0;
+    for(; i+4 <= count; i += 4) {
+        __m128 a = _mm_loadu_ps(p + 2*i), b = _mm_loadu_ps(p + 2*i + 4); // r0 i0 r1 i1 | r2 i2 r3 i3
+        __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(spec + i, _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im)));
+    }
+    powerSpectrumScalar(spec + i, x + i, count - i);
+}
+
+TARGET_SSE2 static float sumRangeSse2(const float* x, int lo, int hi) {
+    __m128 acc = _mm_setzero_ps();
+    int j = lo;
+    for(; j+4 <= hi; j += 4) acc = _mm_add_ps(acc, _mm_loadu_ps(x + j));
+    return hsum128(acc) + sumRangeScalar(x, j, hi);
+}
+
+TARGET_SSE2 static float maxRangeSse2(const float* x, int lo, int hi) {
+    __m128 acc = _mm_setzero_ps();
+    int j = lo;
+    for(; j+4 <= hi; j += 4) acc = _mm_max_ps(acc, _mm_loadu_ps(x + j));
+    return std::max(hmax128(acc), maxRangeScalar(x, j, hi));
+}
+
+TARGET_SSE2 static void matVecSse2(float* y, const float* a, int rows, int cols, const float* x) {
+    int r = 0;
+    for(; r+4 <= rows; r += 4) {
+        __m128 acc = _mm_setzero_ps();
+        for(int c = 0; c < cols; c++) acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + (long)c*rows + r), _mm_set1_ps(x[c])));
+        _mm_storeu_ps(y + r, acc);
+    }
+    matVecRows(y, a, rows, cols, x, r);
+}
+
+// Filterbank rows are usually one run of consecutive bins; those are read with plain loads and
+// only scattered rows fall back to a gather (or scalar loads on SSE2).
+TARGET_SSE2 static void sparseMatVecSse2(float* y, const int* rowPtr, const int* cols, const float* vals, int rows, const float* x) {
+    for(int r = 0; r < rows; r++) {
+        const int lo = rowPtr[r], hi = rowPtr[r+1];
+        if(hi <= lo || cols[hi-1] - cols[lo] != hi-1 - lo) { sparseMatVecScalar(y + r, rowPtr + r, cols, vals, 1, x); continue; }
+        const float* xr = x + cols[lo] - lo;
+        __m128 acc = _mm_setzero_ps();
+        int k = lo;
+        for(; k+4 <= hi; k += 4) acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(vals + k), _mm_loadu_ps(xr + k)));
+        float sm = hsum128(acc);
+        for(; k < hi; k++) sm += vals[k]*xr[k];
+        y[r] = sm;
+    }
+}
+
+TARGET_SSE2 static void log2RangeSse2(float* y, const float* x, int count, float floor) {
+    const __m128 fl = _mm_set1_ps(floor), one = _mm_set1_ps(1.f), half = _mm_set1_ps(0.5f), sq2 = _mm_set1_ps(2*sqrtHalf);
+    const __m128i mantMask = _mm_set1_epi32(0x7fffff), oneBits = _mm_set1_epi32(0x3f800000), bias = _mm_set1_epi32(127);
+    int i = 0;
+    for(; i+4 <= count; i += 4) {
+        const __m128i bits = _mm_castps_si128(_mm_max_ps(_mm_loadu_ps(x + i), fl));
+        __m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), bias));
+        __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, mantMask), oneBits));
+        const __m128 big = _mm_cmpgt_ps(m, sq2);
+        m = _mm_or_ps(_mm_and_ps(big, _mm_mul_ps(m, half)), _mm_andnot_ps(big, m));
+        e = _mm_add_ps(e, _mm_and_ps(big, one));
+        const __m128 t = _mm_sub_ps(m, one), z = _mm_mul_ps(t, t);
+        __m128 p = _mm_set1_ps(logP[0]);
+        for(int j = 1; j < 9; j++) p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(logP[j]));
+        p = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(p, t), z), _mm_mul_ps(half, z));
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_mul_ps(_mm_add_ps(t, p), _mm_set1_ps(log2e)), e));
+    }
+    log2RangeScalar(y + i, x + i, count - i, floor);
+}
+
+// blocks load all their inputs before storing, so in-place ascending k stays safe
+TARGET_SSE2 static void harmonicMeanSse2(float* x, int count, int h) {
+    const __m128 inv = _mm_set1_ps(1.f/h);
+    int k = 0;
+    for(; k+4 <= count; k += 4) {
+        __m128 sm = _mm_loadu_ps(x + k);
+        for(long j = 2; j <= h; j++) sm = _mm_add_ps(sm, _mm_setr_ps(x[j*k], x[j*(k+1)], x[j*(k+2)], x[j*(k+3)]));
+        _mm_storeu_ps(x + k, _mm_mul_ps(sm, inv));
+    }
+    harmonicMeanFrom(x, k, count, h);
+}
+
+// 4x4 transposes: four frames of four adjacent channels in, four channels of four frames out.
+// Channels past the last group of four, and frames past the last group, go scalar.
+TARGET_SSE2 static void deinterleaveSse2From(float* const* out, const float* in, int channels, long frames, int c0) {
+    const long body = frames & ~3L;
+    int c = c0;
+    if(channels == 2) {
+        for(long i = 0; i < body; i += 4) {
+            const __m128 a = _mm_loadu_ps(in + i*2), b = _mm_loadu_ps(in + i*2 + 4);
+            _mm_storeu_ps(out[c0] + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(out[c0+1] + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+        c = channels;
+    }
+    for(; c+4 <= channels; c += 4) {
+        float *o0 = out[c], *o1 = out[c+1], *o2 = out[c+2], *o3 = out[c+3];
+        for(long i = 0; i < body; i += 4) {
+            const float* p = in + i*channels + c;
+            __m128 r0 = _mm_loadu_ps(p), r1 = _mm_loadu_ps(p + channels), r2 = _mm_loadu_ps(p + 2*channels), r3 = _mm_loadu_ps(p + 3*channels);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(o0 + i, r0); _mm_storeu_ps(o1 + i, r1); _mm_storeu_ps(o2 + i, r2); _mm_storeu_ps(o3 + i, r3);
+        }
+    }
+    deinterleaveRange(out, in, channels, c, channels, 0, body);
+    deinterleaveRange(out, in, channels, c0, channels, body, frames);
+}
+
+TARGET_SSE2 static void deinterleaveSse2(float* const* out, const float* in, int channels, long frames) {
+    if(channels == 1) memcpy(out[0], in, sizeof(float)*frames);
+    else deinterleaveSse2From(out, in, channels, frames, 0);
+}
+
+TARGET_AVX2 static void powerSpectrumAvx2(float* spec, const kiss_fft_cpx* x, int count) {
+    const float* p = (const float*)x;
+    int i = 0;
+    for(; i+8 <= count; i += 8) {
+        __m256 a = _mm256_loadu_ps(p + 2*i), b = _mm256_loadu_ps(p + 2*i + 8);
+        a = _mm256_mul_ps(a, a); b = _mm256_mul_ps(b, b);
+        // hadd pairs within 128-bit lanes: |x0| |x1| |x4| |x5| |x2| |x3| |x6| |x7|, then reorder
+        __m256 s = _mm256_hadd_ps(a, b);
+        s = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(s), _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_ps(spec + i, s);
+    }
+    powerSpectrumSse2(spec + i, x + i, count - i);
+}
+
+TARGET_AVX2 static float sumRangeAvx2(const float* x, int lo, int hi) {
+    __m256 acc = _mm256_setzero_ps();
+    int j = lo;
+    for(; j+8 <= hi; j += 8) acc = _mm256_add_ps(acc, _mm256_loadu_ps(x + j));
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    return hsum128(s) + sumRangeScalar(x, j, hi);
+}
+
+TARGET_AVX2 static float maxRangeAvx2(const float* x, int lo, int hi) {
+    __m256 acc = _mm256_setzero_ps();
+    int j = lo;
+    for(; j+8 <= hi; j += 8) acc = _mm256_max_ps(acc, _mm256_loadu_ps(x + j));
+    __m128 s = _mm_max_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    return std::max(hmax128(s), maxRangeScalar(x, j, hi));
+}
+
+TARGET_AVX2 static void matVecAvx2(float* y, const float* a, int rows, int cols, const float* x) {
+    int r = 0;
+    for(; r+8 <= rows; r += 8) {
+        __m256 acc = _mm256_setzero_ps();
+        for(int c = 0; c < cols; c++) acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(a + (long)c*rows + r), _mm256_set1_ps(x[c])));
+        _mm256_storeu_ps(y + r, acc);
+    }
+    matVecRows(y, a, rows, cols, x, r);
+}
+
+TARGET_AVX2 static void sparseMatVecAvx2(float* y, const int* rowPtr, const int* cols, const float* vals, int rows, const float* x) {
+    for(int r = 0; r < rows; r++) {
+        const int lo = rowPtr[r], hi = rowPtr[r+1];
+        const bool run = hi > lo && cols[hi-1] - cols[lo] == hi-1 - lo;
+        const float* xr = run ? x + cols[lo] - lo : x;
+        __m256 acc = _mm256_setzero_ps();
+        int k = lo;
+        for(; k+8 <= hi; k += 8) {
+            __m256 g = run ? _mm256_loadu_ps(xr + k) : _mm256_i32gather_ps(x, _mm256_loadu_si256((const __m256i*)(cols + k)), 4);
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(vals + k), g));
+        }
+        float sm = hsum128(_mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1)));
+        for(; k < hi; k++) sm += vals[k]*x[cols[k]];
+        y[r] = sm;
+    }
+}
+
+TARGET_AVX2 static void log2RangeAvx2(float* y, const float* x, int count, float floor) {
+    const __m256 fl = _mm256_set1_ps(floor), one = _mm256_set1_ps(1.f), half = _mm256_set1_ps(0.5f), sq2 = _mm256_set1_ps(2*sqrtHalf);
+    const __m256i mantMask = _mm256_set1_epi32(0x7fffff), oneBits = _mm256_set1_epi32(0x3f800000), bias = _mm256_set1_epi32(127);
+    int i = 0;
+    for(; i+8 <= count; i += 8) {
+        const __m256i bits = _mm256_castps_si256(_mm256_max_ps(_mm256_loadu_ps(x + i), fl));
+        __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), bias));
+        __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, mantMask), oneBits));
+        const __m256 big = _mm256_cmp_ps(m, sq2, _CMP_GT_OQ);
+        m = _mm256_blendv_ps(m, _mm256_mul_ps(m, half), big);
+        e = _mm256_add_ps(e, _mm256_and_ps(big, one));
+        const __m256 t = _mm256_sub_ps(m, one), z = _mm256_mul_ps(t, t);
+        __m256 p = _mm256_set1_ps(logP[0]);
+        for(int j = 1; j < 9; j++) p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(logP[j]));
+        p = _mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(p, t), z), _mm256_mul_ps(half, z));
+        _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(t, p), _mm256_set1_ps(log2e)), e));
+    }
+    log2RangeSse2(y + i, x + i, count - i, floor);
+}
+
+TARGET_AVX2 static void harmonicMeanAvx2(float* x, int count, int h) {
+    const __m256 inv = _mm256_set1_ps(1.f/h);
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    int k = 0;
+    for(; k+8 <= count; k += 8) {
+        const __m256i idx = _mm256_add_epi32(_mm256_set1_epi32(k), lane);
+        __m256 sm = _mm256_loadu_ps(x + k);
+        for(int j = 2; j <= h; j++) sm = _mm256_add_ps(sm, _mm256_i32gather_ps(x, _mm256_mullo_epi32(idx, _mm256_set1_epi32(j)), 4));
+        _mm256_storeu_ps(x + k, _mm256_mul_ps(sm, inv));
+    }
+    harmonicMeanFrom(x, k, count, h);
+}
+
+// 8x8 transposes over groups of eight channels; the rest of the channels take the SSE2 path
+TARGET_AVX2 static void deinterleaveAvx2(float* const* out, const float* in, int channels, long frames) {
+    if(channels < 8) { deinterleaveSse2(out, in, channels, frames); return; }
+    const long body = frames & ~7L;
+    int c = 0;
+    for(; c+8 <= channels; c += 8) {
+        for(long i = 0; i < body; i += 8) {
+            const float* p = in + i*channels + c;
+            __m256 r[8], t[8];
+            for(int k = 0; k < 8; k++) r[k] = _mm256_loadu_ps(p + k*channels);
+            for(int k = 0; k < 8; k += 2) {
+                t[k] = _mm256_unpacklo_ps(r[k], r[k+1]);
+                t[k+1] = _mm256_unpackhi_ps(r[k], r[k+1]);
+            }
+            for(int k = 0; k < 8; k += 4) {
+                r[k] = _mm256_shuffle_ps(t[k], t[k+2], _MM_SHUFFLE(1, 0, 1, 0));
+                r[k+1] = _mm256_shuffle_ps(t[k], t[k+2], _MM_SHUFFLE(3, 2, 3, 2));
+                r[k+2] = _mm256_shuffle_ps(t[k+1], t[k+3], _MM_SHUFFLE(1, 0, 1, 0));
+                r[k+3] = _mm256_shuffle_ps(t[k+1], t[k+3], _MM_SHUFFLE(3, 2, 3, 2));
+            }
+            // r[0..3] hold channels 0-3 (and 4-7 in the high lanes) of frames 0-3, r[4..7] of frames 4-7
+            for(int k = 0; k < 4; k++) {
+                _mm256_storeu_ps(out[c+k] + i, _mm256_permute2f128_ps(r[k], r[k+4], 0x20));
+                _mm256_storeu_ps(out[c+k+4] + i, _mm256_permute2f128_ps(r[k], r[k+4], 0x31));
+            }
+        }
+    }
+    deinterleaveRange(out, in, channels, 0, c, body, frames);
+    if(c < channels) deinterleaveSse2From(out, in, channels, frames, c);
+}
+
+TARGET_AVX512 static void powerSpectrumAvx512(float* spec, const kiss_fft_cpx* x, int count) {
+    const float* p = (const float*)x;
+    const __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    const __m512i odd = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+    int i = 0;
+    for(; i+16 <= count; i += 16) {
+        __m512 a = _mm512_loadu_ps(p + 2*i), b = _mm512_loadu_ps(p + 2*i + 16);
+        __m512 re = _mm512_permutex2var_ps(a, even, b), im = _mm512_permutex2var_ps(a, odd, b);
+        _mm512_storeu_ps(spec + i, _mm512_add_ps(_mm512_mul_ps(re, re), _mm512_mul_ps(im, im)));
+    }
+    powerSpectrumScalar(spec + i, x + i, count - i);
+}
+
+// masked tail loads fill with zeros, which leaves both the sum and the max-with-0 unchanged
+TARGET_AVX512 static float sumRangeAvx512(const float* x, int lo, int hi) {
+    __m512 acc = _mm512_setzero_ps();
+    int j = lo;
+    for(; j+16 <= hi; j += 16) acc = _mm512_add_ps(acc, _mm512_loadu_ps(x + j));
+    if(j < hi) acc = _mm512_add_ps(acc, _mm512_maskz_loadu_ps((__mmask16)((1u << (hi-j)) - 1), x + j));
+    return _mm512_reduce_add_ps(acc);
+}
+
+TARGET_AVX512 static float maxRangeAvx512(const float* x, int lo, int hi) {
+    __m512 acc = _mm512_setzero_ps();
+    int j = lo;
+    for(; j+16 <= hi; j += 16) acc = _mm512_max_ps(acc, _mm512_loadu_ps(x + j));
+    if(j < hi) acc = _mm512_max_ps(acc, _mm512_maskz_loadu_ps((__mmask16)((1u << (hi-j)) - 1), x + j));
+    return _mm512_reduce_max_ps(acc);
+}
+
+TARGET_AVX512 static void matVecAvx512(float* y, const float* a, int rows, int cols, const float* x) {
+    for(int r = 0; r < rows; r += 16) {
+        const __mmask16 m = rows-r >= 16 ? (__mmask16)0xffff : (__mmask16)((1u << (rows-r)) - 1);
+        __m512 acc = _mm512_setzero_ps();
+        for(int c = 0; c < cols; c++) acc = _mm512_add_ps(acc, _mm512_mul_ps(_mm512_maskz_loadu_ps(m, a + (long)c*rows + r), _mm512_set1_ps(x[c])));
+        _mm512_mask_storeu_ps(y + r, m, acc);
+    }
+}
+
+TARGET_AVX512 static void sparseMatVecAvx512(float* y, const int* rowPtr, const int* cols, const float* vals, int rows, const float* x) {
+    for(int r = 0; r < rows; r++) {
+        const int lo = rowPtr[r], hi = rowPtr[r+1];
+        const bool run = hi > lo && cols[hi-1] - cols[lo] == hi-1 - lo;
+        const float* xr = run ? x + cols[lo] - lo : x;
+        __m512 acc = _mm512_setzero_ps();
+        for(int k = lo; k < hi; k += 16) {
+            const __mmask16 m = hi-k >= 16 ? (__mmask16)0xffff : (__mmask16)((1u << (hi-k)) - 1);
+            __m512 g = run ? _mm512_maskz_loadu_ps(m, xr + k)
+                : _mm512_mask_i32gather_ps(_mm512_setzero_ps(), m, _mm512_maskz_loadu_epi32(m, cols + k), x, 4);
+            acc = _mm512_add_ps(acc, _mm512_mul_ps(_mm512_maskz_loadu_ps(m, vals + k), g));
+        }
+        y[r] = _mm512_reduce_add_ps(acc);
+    }
+}
+
+TARGET_AVX512 static void log2RangeAvx512(float* y, const float* x, int count, float floor) {
+    const __m512 fl = _mm512_set1_ps(floor), one = _mm512_set1_ps(1.f), half = _mm512_set1_ps(0.5f), sq2 = _mm512_set1_ps(2*sqrtHalf);
+    const __m512i mantMask = _mm512_set1_epi32(0x7fffff), oneBits = _mm512_set1_epi32(0x3f800000), bias = _mm512_set1_epi32(127);
+    for(int i = 0; i < count; i += 16) {
+        const __mmask16 lanes = count-i >= 16 ? (__mmask16)0xffff : (__mmask16)((1u << (count-i)) - 1);
+        const __m512i bits = _mm512_castps_si512(_mm512_max_ps(_mm512_maskz_loadu_ps(lanes, x + i), fl));
+        __m512 e = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(bits, 23), bias));
+        __m512 m = _mm512_castsi512_ps(_mm512_or_si512(_mm512_and_si512(bits, mantMask), oneBits));
+        const __mmask16 big = _mm512_cmp_ps_mask(m, sq2, _CMP_GT_OQ);
+        m = _mm512_mask_mul_ps(m, big, m, half);
+        e = _mm512_mask_add_ps(e, big, e, one);
+        const __m512 t = _mm512_sub_ps(m, one), z = _mm512_mul_ps(t, t);
+        __m512 p = _mm512_set1_ps(logP[0]);
+        for(int j = 1; j < 9; j++) p = _mm512_add_ps(_mm512_mul_ps(p, t), _mm512_set1_ps(logP[j]));
+        p = _mm512_sub_ps(_mm512_mul_ps(_mm512_mul_ps(p, t), z), _mm512_mul_ps(half, z));
+        _mm512_mask_storeu_ps(y + i, lanes, _mm512_add_ps(_mm512_mul_ps(_mm512_add_ps(t, p), _mm512_set1_ps(log2e)), e));
+    }
+}
+
+TARGET_AVX512 static void harmonicMeanAvx512(float* x, int count, int h) {
+    const __m512 inv = _mm512_set1_ps(1.f/h);
+    const __m512i lane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    for(int k = 0; k < count; k += 16) {
+        const __mmask16 m = count-k >= 16 ? (__mmask16)0xffff : (__mmask16)((1u << (count-k)) - 1);
+        const __m512i idx = _mm512_add_epi32(_mm512_set1_epi32(k), lane);
+        __m512 sm = _mm512_maskz_loadu_ps(m, x + k);
+        for(int j = 2; j <= h; j++)
+            sm = _mm512_add_ps(sm, _mm512_mask_i32gather_ps(_mm512_setzero_ps(), m, _mm512_mullo_epi32(idx, _mm512_set1_epi32(j)), x, 4));
+        _mm512_mask_storeu_ps(x + k, m, _mm512_mul_ps(sm, inv));
+    }
+}
+#endif
+
+static const SimdKernels kernels[4] = {
+    {powerSpectrumScalar, sumRangeScalar, maxRangeScalar, matVecScalar, sparseMatVecScalar, log2RangeScalar, harmonicMeanScalar, deinterleaveScalar},
+#ifdef CHORDY_X86
+    {powerSpectrumSse2, sumRangeSse2, maxRangeSse2, matVecSse2, sparseMatVecSse2, log2RangeSse2, harmonicMeanSse2, deinterleaveSse2},
+    {powerSpectrumAvx2, sumRangeAvx2, maxRangeAvx2, matVecAvx2, sparseMatVecAvx2, log2RangeAvx2, harmonicMeanAvx2, deinterleaveAvx2},
+    // a transpose is shuffle bound, so AVX-512 has nothing to add over the AVX2 one
+    {powerSpectrumAvx512, sumRangeAvx512, maxRangeAvx512, matVecAvx512, sparseMatVecAvx512, log2RangeAvx512, harmonicMeanAvx512, deinterleaveAvx2},
+#endif
+};
+
+SimdLevel detectSimdLevel() {
+#ifdef CHORDY_X86
+    __builtin_cpu_init(); // may run before libgcc's own constructor during static init
+    if(__builtin_cpu_supports("avx512f")) return SimdLevel::Avx512;
+    if(__builtin_cpu_supports("avx2")) return SimdLevel::Avx2;
+    if(__builtin_cpu_supports("sse2")) return SimdLevel::Sse2;
+#endif
+    return SimdLevel::Scalar;
+}
+
+static SimdLevel clampSimdLevel(SimdLevel level) {
+    return (SimdLevel)std::min((int)level, (int)detectSimdLevel());
+}
+
+const SimdKernels& simdKernels(SimdLevel level) {
+    return kernels[(int)clampSimdLevel(level)];
+}
+
+static std::atomic<int> activeLevel{(int)detectSimdLevel()};
+
+const SimdKernels& activeSimdKernels() {
+    return kernels[activeLevel.load(std::memory_order_relaxed)];
+}
+
+SimdLevel activeSimdLevel() {
+    return (SimdLevel)activeLevel.load(std::memory_order_relaxed);
+}
+
+void setSimdLevel(SimdLevel level) {
+    activeLevel.store((int)clampSimdLevel(level), std::memory_order_relaxed);
+}
@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <utility>
+#include "specialized.h"
+#include "simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CHORDY_X86 1
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+
+// midi2Freq(60) and the quarter tone ratio, as buildChromaFilterbank has them
+constexpr float c4Hz = 0x1.05a024p+8f;
+constexpr float quarterTone = 1.02930223664349F;
+
+// freq2Bin for freq >= 0
+constexpr int binOf(float freq, int rate, int n) { return (int)(freq*n/rate); }
+
+// Box band of each filterbank row: bins [lo, hi] weighted w, empty when lo > hi
+template<int Rows>
+struct BoxBands { int lo[Rows], hi[Rows]; float w[Rows]; };
+
+// buildChromaFilterbank's band walk for the Box shape, in the same float steps
+template<int N, int Octaves, int Rate>
+constexpr BoxBands<12*Octaves> makeBoxBands() {
+    BoxBands<12*Octaves> b{};
+    const int highPass = binOf(50, Rate, N);
+    float mid = c4Hz;
+    for(int p = 0; p < 12; p++) {
+        float lbf = mid/quarterTone, ubf = mid*quarterTone;
+        for(int r = 0; r < Octaves; r++) {
+            const int row = p*Octaves + r;
+            const int lbi = binOf(lbf, Rate, N), ubi = std::min(binOf(ubf, Rate, N), N/2);
+            b.lo[row] = std::max(lbi, highPass);
+            b.hi[row] = ubi;
+            b.w[row] = lbi <= ubi ? 1.f/(ubi-lbi+1) : 0.f;
+            lbf *= 2.F; ubf *= 2.F;
+        }
+        mid *= quarterTone*quarterTone;
+    }
+    return b;
+}
+
+template<int N, int Octaves, int Rate>
+struct BoxTable {
+    static constexpr BoxBands<12*Octaves> bands = makeBoxBands<N, Octaves, Rate>();
+};
+
+// sum of x[Lo..Hi]; eight running sums the compiler keeps in vector registers
+template<int Lo, int Hi>
+static ALWAYS_INLINE float bandSum(const float* x) {
+    constexpr int count = Hi >= Lo ? Hi-Lo+1 : 0;
+    float acc[8] = {};
+    int j = 0;
+    for(; j+8 <= count; j += 8) {
+        for(int l = 0; l < 8; l++) acc[l] += x[Lo+j+l];
+    }
+    float s = 0;
+    for(; j < count; j++) s += x[Lo+j];
+    return ((acc[0]+acc[4]) + (acc[1]+acc[5])) + ((acc[2]+acc[6]) + (acc[3]+acc[7])) + s;
+}
+
+template<int N, int Octaves, int Rate, size_t... R>
+static ALWAYS_INLINE void chromaBody(const float* spec, float* chroma, std::index_sequence<R...>) {
+    using T = BoxTable<N, Octaves, Rate>;
+    const float bands[] = {T::bands.w[R]*bandSum<T::bands.lo[R], T::bands.hi[R]>(spec)...};
+    for(int p = 0; p < 12; p++) {
+        chroma[p] = 1;
+        for(int r = 0; r < Octaves; r++) chroma[p] *= bands[p*Octaves + r];
+    }
+}
+
+template<int N, int Octaves, int Rate>
+static void chromaBaseline(const float* spec, float* chroma) {
+    chromaBody<N, Octaves, Rate>(spec, chroma, std::make_index_sequence<12*Octaves>());
+}
+
+#ifdef CHORDY_X86
+template<int N, int Octaves, int Rate>
+TARGET_AVX2 static void chromaAvx2(const float* spec, float* chroma) {
+    chromaBody<N, Octaves, Rate>(spec, chroma, std::make_index_sequence<12*Octaves>());
+}
+#endif
+
+// off x86 there is no AVX2 build of the body, so both slots run the baseline
+template<int N, int Octaves, int Rate>
+constexpr SpecializedChroma chromaKernel() {
+#ifdef CHORDY_X86
+    return {N, Octaves, Rate, {chromaBaseline<N, Octaves, Rate>, chromaAvx2<N, Octaves, Rate>}};
+#else
+    return {N, Octaves, Rate, {chromaBaseline<N, Octaves, Rate>, chromaBaseline<N, Octaves, Rate>}};
+#endif
+}
+
+#define CHROMA_KERNELS(N, RATE) \
+    chromaKernel<N, 1, RATE>(), chromaKernel<N, 2, RATE>(), chromaKernel<N, 3, RATE>(), \
+    chromaKernel<N, 4, RATE>(), chromaKernel<N, 5, RATE>(), chromaKernel<N, 6, RATE>()
+
+static const SpecializedChroma chromaKernels[] = {
+    CHROMA_KERNELS(2048, 44100), CHROMA_KERNELS(2048, 48000),
+    CHROMA_KERNELS(4096, 44100), CHROMA_KERNELS(4096, 48000),
+    CHROMA_KERNELS(8192, 44100), CHROMA_KERNELS(8192, 48000),
+    CHROMA_KERNELS(16384, 44100), CHROMA_KERNELS(16384, 48000),
+};
+
+// the columns of a Box row run in order over [lo, hi], all with one weight
+static bool sameBands(const ChromaFilterbank& fb, const int* lo, const int* hi, const float* w) {
+    for(int row = 0; row < fb.rows; row++) {
+        const int start = fb.rowPtr[row], end = fb.rowPtr[row+1];
+        if(end - start != std::max(0, hi[row] - lo[row] + 1)) return false;
+        for(int k = start; k < end; k++) {
+            if(fb.cols[k] != lo[row] + k - start || fb.weights[k] != w[row]) return false;
+        }
+    }
+    return true;
+}
+
+template<int N, int Octaves, int Rate>
+static bool matchesTable(const ChromaFilterbank& fb) {
+    using T = BoxTable<N, Octaves, Rate>;
+    return sameBands(fb, T::bands.lo, T::bands.hi, T::bands.w);
+}
+
+// the same list again for the table check, in the same order as chromaKernels
+#define CHROMA_CHECKS(N, RATE) \
+    matchesTable<N, 1, RATE>, matchesTable<N, 2, RATE>, matchesTable<N, 3, RATE>, \
+    matchesTable<N, 4, RATE>, matchesTable<N, 5, RATE>, matchesTable<N, 6, RATE>
+
+static bool (* const chromaChecks[])(const ChromaFilterbank&) = {
+    CHROMA_CHECKS(2048, 44100), CHROMA_CHECKS(2048, 48000),
+    CHROMA_CHECKS(4096, 44100), CHROMA_CHECKS(4096, 48000),
+    CHROMA_CHECKS(8192, 44100), CHROMA_CHECKS(8192, 48000),
+    CHROMA_CHECKS(16384, 44100), CHROMA_CHECKS(16384, 48000),
+};
+
+const SpecializedChroma* findSpecializedChroma(const ChromaFilterbank& fb) {
+    if(fb.shape != ChromaShape::Box) return nullptr;
+    for(size_t i = 0; i < sizeof(chromaKernels)/sizeof(chromaKernels[0]); i++) {
+        const SpecializedChroma& k = chromaKernels[i];
+        if(k.n == fb.n && k.octaves == fb.octaves && (float)k.sampleRate == fb.sampleRate) {
+            return chromaChecks[i](fb) ? &k : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+// same order of operations as matVec's scalar rows, so results match it exactly
+template<int Chords>
+static ALWAYS_INLINE void scoresBody(float* y, const float* a, const float* x) {
+    float acc[Chords] = {};
+    for(int j = 0; j < 12; j++) {
+        for(int c = 0; c < Chords; c++) acc[c] += a[j*Chords + c]*x[j];
+    }
+    for(int c = 0; c < Chords; c++) y[c] = acc[c];
+}
+
+template<int Chords>
+static void scoresBaseline(float* y, const float* a, const float* x) { scoresBody<Chords>(y, a, x); }
+
+#ifdef CHORDY_X86
+template<int Chords>
+TARGET_AVX2 static void scoresAvx2(float* y, const float* a, const float* x) { scoresBody<Chords>(y, a, x); }
+#endif
+
+static const SpecializedScores scoreKernels[] = {
+#ifdef CHORDY_X86
+    {24, {scoresBaseline<24>, scoresAvx2<24>}}, // major and minor triads
+#else
+    {24, {scoresBaseline<24>, scoresBaseline<24>}},
+#endif
+};
+
+const SpecializedScores* findSpecializedScores(int chords) {
+    for(const SpecializedScores& k : scoreKernels) if(k.chords == chords) return &k;
+    return nullptr;
+}
+
+int specializedVariant() {
+    return activeSimdLevel() >= SimdLevel::Avx2 ? 1 : 0;
+}
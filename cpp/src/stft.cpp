@@ -0,0 +1,99 @@
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include "stft.h"
+
+void fillWindow(float* w, int n, WindowType type) {
+    for(int i = 0; i < n; i++) {
+        switch(type) {
+            case WindowType::Rectangular: w[i] = 1.f; break;
+            case WindowType::Hann: w[i] = 0.5 - 0.5*std::cos(2*M_PI*i/n); break;
+        }
+    }
+}
+
+static void allocBins(SlidingDft& s) {
+    delete[] s.re; delete[] s.im; delete[] s.twr; delete[] s.twi;
+    const int bins = s.tHi - s.tLo + 1;
+    s.re = new double[bins](); s.im = new double[bins]();
+    s.twr = new double[bins]; s.twi = new double[bins];
+    for(int b = 0; b < bins; b++) {
+        const double w = 2*M_PI*(s.tLo+b)/s.n;
+        s.twr[b] = std::cos(w); s.twi[b] = std::sin(w);
+    }
+}
+
+SlidingDft* initSlidingDft(int n, int kLo, int kHi, WindowType window) {
+    SlidingDft* s = new SlidingDft();
+    s->n = n;
+    s->window = window;
+    s->history = new float[n]();
+    setSlidingDftRange(*s, kLo, kHi);
+    return s;
+}
+
+void freeSlidingDft(SlidingDft* s) {
+    if(s == nullptr) return;
+    delete[] s->re; delete[] s->im; delete[] s->twr; delete[] s->twi;
+    delete[] s->history;
+    delete s;
+}
+
+void setSlidingDftRange(SlidingDft& s, int kLo, int kHi) {
+    s.kLo = std::max(kLo, 0); s.kHi = std::min(kHi, s.n/2);
+    s.tLo = std::max(s.kLo-1, 0); s.tHi = std::min(s.kHi+1, s.n/2);
+    allocBins(s);
+    s.hopCount = 0; // state is stale, rebuild on the next spectrum
+}
+
+void resetSlidingDft(SlidingDft& s, const float* window) {
+    memcpy(s.history, window, sizeof(float)*s.n);
+    s.pos = 0;
+    s.hopCount = 0;
+}
+
+void pushSlidingDft(SlidingDft& s, const float* x, long count) {
+    const int bins = s.tHi - s.tLo + 1;
+    double* __restrict re = s.re; double* __restrict im = s.im;
+    const double* __restrict twr = s.twr; const double* __restrict twi = s.twi;
+    for(long i = 0; i < count; i++) {
+        const double d = (double)x[i] - s.history[s.pos];
+        s.history[s.pos] = x[i];
+        if(++s.pos == s.n) s.pos = 0;
+        for(int b = 0; b < bins; b++) {
+            const double r = re[b] + d, m = im[b];
+            re[b] = r*twr[b] - m*twi[b];
+            im[b] = r*twi[b] + m*twr[b];
+        }
+    }
+}
+
+static void resync(SlidingDft& s, const FftPlan* fft, float* window, float* scratch, kiss_fft_cpx* out) {
+    memcpy(window, &s.history[s.pos], sizeof(float)*(s.n-s.pos));
+    memcpy(&window[s.n-s.pos], s.history, sizeof(float)*s.pos);
+    fftReal(fft, window, out, scratch);
+    for(int k = s.tLo; k <= s.tHi; k++) {
+        s.re[k-s.tLo] = out[k].r;
+        s.im[k-s.tLo] = out[k].i;
+    }
+}
+
+void slidingDftSpectrum(SlidingDft& s, float* spec, const FftPlan* fft, float* window, float* scratch, kiss_fft_cpx* out) {
+    if(s.hopCount++ % s.resyncHops == 0) resync(s, fft, window, scratch, out);
+
+    memset(spec, 0, sizeof(float)*s.kLo);
+    memset(&spec[s.kHi+1], 0, sizeof(float)*(s.n/2 - s.kHi));
+    const double* re = s.re - s.tLo; const double* im = s.im - s.tLo;
+    if(s.window == WindowType::Hann) {
+        for(int k = s.kLo; k <= s.kHi; k++) {
+            // periodic Hann in the frequency domain; bins past DC/Nyquist mirror as conjugates
+            const int km = k > 0 ? k-1 : 1, kp = k < s.n/2 ? k+1 : s.n/2-1;
+            const double imm = k > 0 ? im[km] : -im[km], imp = k < s.n/2 ? im[kp] : -im[kp];
+            const double r = 0.5*re[k] - 0.25*(re[km] + re[kp]);
+            const double i = 0.5*im[k] - 0.25*(imm + imp);
+            spec[k] = r*r + i*i;
+        }
+    } else {
+        for(int k = s.kLo; k <= s.kHi; k++) spec[k] = re[k]*re[k] + im[k]*im[k];
+    }
+}
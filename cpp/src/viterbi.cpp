@@ -0,0 +1,112 @@
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include "viterbi.h"
+
+FixedLagViterbi* initViterbi(int states, int lag, const float* trans) {
+    FixedLagViterbi* v = new FixedLagViterbi();
+    v->states = states;
+    v->lag = std::max(lag, 0);
+    v->logTrans = new float[states*states];
+    v->delta = new float[states];
+    v->next = new float[states];
+    v->back = new int[std::max(v->lag, 1)*states];
+    for(int from = 0; from < states; from++) {
+        double total = 0;
+        for(int to = 0; to < states; to++) total += trans ? std::max(trans[from*states + to], 0.f) : 1.f;
+        for(int to = 0; to < states; to++) {
+            const double p = (trans ? std::max(trans[from*states + to], 0.f) : 1.f)/total;
+            v->logTrans[to*states + from] = p > 0 ? std::log2(p) : -1e30f;
+        }
+    }
+    v->logStay = v->logTrans[0];
+    v->logMove = states > 1 ? v->logTrans[1] : 0;
+    v->stayMove = states > 1;
+    for(int to = 0; to < states; to++) {
+        for(int from = 0; from < states; from++) {
+            // rows are normalized separately, so allow for their sums rounding differently
+            if(std::fabs(v->logTrans[to*states + from] - (to == from ? v->logStay : v->logMove)) > 1e-5f) v->stayMove = false;
+        }
+    }
+    resetViterbi(*v);
+    return v;
+}
+
+void freeViterbi(FixedLagViterbi* v) {
+    if(v == nullptr) return;
+    delete[] v->logTrans; delete[] v->delta; delete[] v->next; delete[] v->back;
+    delete v;
+}
+
+void resetViterbi(FixedLagViterbi& v) {
+    memset(v.delta, 0, sizeof(float)*v.states);
+    v.head = 0;
+    v.frames = 0;
+}
+
+static int argmax(const float* x, int count) {
+    int best = 0;
+    for(int i = 1; i < count; i++) if(x[i] > x[best]) best = i;
+    return best;
+}
+
+int stepViterbi(FixedLagViterbi& v, const float* logEmission) {
+    const int S = v.states, ring = std::max(v.lag, 1);
+    if(v.frames > 0) v.head = (v.head + 1) % ring;
+    int* back = &v.back[v.head*S];
+    if(v.frames == 0) {
+        for(int to = 0; to < S; to++) { v.next[to] = logEmission[to]; back[to] = to; }
+    } else if(v.stayMove) {
+        // delta peaks at 0 in state top: the best predecessor is the state itself or top
+        // (the runner-up when the state is top)
+        for(int to = 0; to < S; to++) {
+            const int from = to == v.top ? v.second : v.top;
+            const float stay = v.delta[to] + v.logStay, move = v.delta[from] + v.logMove;
+            v.next[to] = (move > stay ? move : stay) + logEmission[to];
+            back[to] = move > stay ? from : to;
+        }
+    } else {
+        for(int to = 0; to < S; to++) {
+            const float* lt = &v.logTrans[to*S];
+            float best = v.delta[0] + lt[0]; int arg = 0;
+            for(int from = 1; from < S; from++) {
+                const float x = v.delta[from] + lt[from];
+                if(x > best) { best = x; arg = from; }
+            }
+            v.next[to] = best + logEmission[to];
+            back[to] = arg;
+        }
+    }
+    // keep the scores near zero so long streams can't lose precision
+    const int top = argmax(v.next, S);
+    const float mx = v.next[top];
+    int second = top == 0 ? std::min(1, S-1) : 0;
+    for(int s = 0; s < S; s++) {
+        v.delta[s] = v.next[s] - mx;
+        if(s != top && v.next[s] > v.next[second]) second = s;
+    }
+    v.top = top; v.second = second;
+    v.frames++;
+
+    if(v.frames <= v.lag) return -1;
+    int s = top;
+    for(int i = 0; i < v.lag; i++) s = v.back[((v.head - i + ring) % ring)*S + s];
+    return s;
+}
+
+int flushViterbi(const FixedLagViterbi& v, int* states) {
+    const int S = v.states, ring = std::max(v.lag, 1);
+    const int count = std::min<long>(v.lag, v.frames);
+    int s = argmax(v.delta, S);
+    for(int i = 0; i < count; i++) {
+        states[count-1 - i] = s;
+        s = v.back[((v.head - i + ring) % ring)*S + s];
+    }
+    return count;
+}
+
+void fillStayTransitions(float* trans, int states, float stay) {
+    for(int from = 0; from < states; from++) {
+        for(int to = 0; to < states; to++) trans[from*states + to] = from == to ? stay : (1 - stay)/std::max(states-1, 1);
+    }
+}
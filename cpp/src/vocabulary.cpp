@@ -0,0 +1,97 @@
+#include <cmath>
+#include <cerrno>
+#include <cstring>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include "vocabulary.h"
+
+// semitones until the mask repeats under transposition: 12 for most, 4 for aug, 3 for dim7
+static int rotationPeriod(int mask) {
+    for(int r = 1; r < 12; r++) {
+        if((((mask << r) | (mask >> (12-r))) & 0xfff) == mask) return r;
+    }
+    return 12;
+}
+
+static void compileTemplates(ChordVocabulary& v) {
+    v.roots.clear();
+    v.chordQualities.clear();
+    for(int q = 0; q < (int)v.qualities.size(); q++) {
+        for(int p = 0; p < rotationPeriod(v.masks[q]); p++) {
+            v.roots.push_back(p);
+            v.chordQualities.push_back(q);
+        }
+    }
+    v.chords = v.roots.size();
+    v.templates.assign(12*v.chords, 0.f);
+    for(int c = 0; c < v.chords; c++) {
+        const int mask = v.masks[v.chordQualities[c]], p = v.roots[c];
+        // equal L2 norms, so a chord isn't outscored by its own subsets (a power chord by the
+        // triad it sits in) nor its supersets; 1/sqrt(3k) keeps triads at the old 1/3
+        const float w = 1.f/std::sqrt(3.f*__builtin_popcount(mask));
+        for(int k = 0; k < 12; k++) {
+            if(mask >> ((k-p+12)%12) & 1) v.templates[k*v.chords + c] = w;
+        }
+    }
+}
+
+bool addChordQuality(ChordVocabulary& v, const std::string& name, const int* intervals, int count, std::string& error) {
+    int mask = 0;
+    for(int i = 0; i < count; i++) mask |= 1 << ((intervals[i]%12 + 12)%12);
+    if(mask == 0) { error = name + ": no notes"; return false; }
+    if(name.find_first_of(",\"\\") != std::string::npos) { error = name + ": names can't contain , \" or \\"; return false; }
+    for(int q = 0; q < (int)v.qualities.size(); q++) {
+        if(v.qualities[q] == name) { error = name + ": defined twice"; return false; }
+        // a rotation has the same templates on other roots (C6 is Am7) and could never win a tie
+        for(int r = 0; r < 12; r++) {
+            if((((mask << r) | (mask >> (12-r))) & 0xfff) != v.masks[q]) continue;
+            error = name + ": same notes as " + v.qualities[q] + (r ? " on another root" : "");
+            return false;
+        }
+    }
+    v.qualities.push_back(name);
+    v.masks.push_back(mask);
+    compileTemplates(v);
+    return true;
+}
+
+void defaultChordVocabulary(ChordVocabulary& v) {
+    const int maj[3] = {0, 4, 7}, min[3] = {0, 3, 7};
+    std::string error;
+    v = ChordVocabulary();
+    addChordQuality(v, "Maj", maj, 3, error);
+    addChordQuality(v, "Min", min, 3, error);
+}
+
+bool loadChordVocabulary(ChordVocabulary& v, const std::string& path, std::string& error) {
+    std::ifstream in(path);
+    if(!in) { error = path + ": " + strerror(errno); return false; }
+    ChordVocabulary loaded;
+    std::string line;
+    for(int ln = 1; std::getline(in, line); ln++) {
+        // '#' opens a comment at the start of a word only, so names like 7#9 keep their sharp
+        for(size_t i = 0; i < line.size(); i++) {
+            if(line[i] == '#' && (i == 0 || isspace((unsigned char)line[i-1]))) { line.resize(i); break; }
+        }
+        std::istringstream fields(line);
+        std::string name;
+        if(!(fields >> name)) continue;
+        std::vector<int> intervals;
+        int x;
+        while(fields >> x) intervals.push_back(x);
+        std::string why = name + ": intervals must be integers";
+        if(!fields.eof() || !addChordQuality(loaded, name, intervals.data(), intervals.size(), why)) {
+            error = path + ":" + std::to_string(ln) + ": " + why;
+            return false;
+        }
+    }
+    if(loaded.qualities.empty()) { error = path + ": no chord qualities"; return false; }
+    v = loaded;
+    return true;
+}
+
+std::string chordName(const ChordVocabulary& v, int chord) {
+    if(chord < 0 || chord >= v.chords) return "N/A";
+    return notes[v.roots[chord]] + " " + v.qualities[v.chordQualities[chord]];
+}
@@ -0,0 +1,106 @@
+#include <chrono>
+#include <thread>
+#include <ctime>
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include "waiter.h"
+
+long long steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+long long threadCpuNs() {
+#if defined(_WIN32)
+    FILETIME c, e, k, u;
+    if(!GetThreadTimes(GetCurrentThread(), &c, &e, &k, &u)) return 0;
+    ULARGE_INTEGER ku, uu;
+    ku.LowPart = k.dwLowDateTime; ku.HighPart = k.dwHighDateTime;
+    uu.LowPart = u.dwLowDateTime; uu.HighPart = u.dwHighDateTime;
+    return (long long)(ku.QuadPart + uu.QuadPart)*100;
+#else
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec*1000000000LL + ts.tv_nsec;
+#endif
+}
+
+static inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+void notifyWaiter(Waiter& w) {
+    w.notifyNs.store(steadyNowNs(), std::memory_order_relaxed);
+    w.seq.fetch_add(1);
+    if(w.sleepers.load() > 0) {
+        // cycling the mutex orders us after a consumer that is between its predicate check and
+        // cv.wait; if it is held we notify anyway and the bounded park covers the rare miss
+        if(w.m.try_lock()) w.m.unlock();
+        w.cv.notify_one();
+    }
+}
+
+static void park(Waiter& w, unsigned seen, int timeoutMicros) {
+    std::unique_lock<std::mutex> lock(w.m);
+    w.sleepers.fetch_add(1);
+    w.cv.wait_for(lock, std::chrono::microseconds(timeoutMicros), [&] { return w.seq.load() != seen; });
+    w.sleepers.fetch_sub(1);
+}
+
+void waitWaiter(Waiter& w, WaitPolicy policy, unsigned seen, int spinMicros, int timeoutMicros) {
+    switch(policy) {
+        case WaitPolicy::Spin:
+            cpuRelax();
+            return;
+        case WaitPolicy::Yield:
+            std::this_thread::yield();
+            return;
+        case WaitPolicy::SpinThenPark: {
+            const long long deadline = steadyNowNs() + spinMicros*1000LL;
+            while(w.seq.load(std::memory_order_acquire) == seen) {
+                if(steadyNowNs() > deadline) { park(w, seen, timeoutMicros); return; }
+                for(int i = 0; i < 32; i++) cpuRelax();
+            }
+            return;
+        }
+        case WaitPolicy::Park:
+            park(w, seen, timeoutMicros);
+            return;
+    }
+}
+
+static void foldWindow(WaitStats& stats, long long now) {
+    const long long cpu = threadCpuNs();
+    if(stats.windowStartNs == 0) { stats.windowStartNs = now; stats.windowCpuNs = cpu; return; }
+    const long long wall = now - stats.windowStartNs;
+    if(wall < 1000000000LL) return;
+
+    stats.cpuPercent = 100.*(cpu - stats.windowCpuNs)/wall;
+    stats.busyPercent = 100.*stats.windowBusyNs/wall;
+    stats.wakeLatencyUs = stats.latencyCount ? stats.latencySumUs/stats.latencyCount : 0;
+    stats.maxWakeLatencyUs = stats.latencyMaxUs;
+
+    stats.windowStartNs = now; stats.windowCpuNs = cpu; stats.windowBusyNs = 0;
+    stats.latencySumUs = 0; stats.latencyMaxUs = 0; stats.latencyCount = 0;
+}
+
+void recordWake(WaitStats& stats, const Waiter& w) {
+    const long long now = steadyNowNs();
+    const double us = (now - w.notifyNs.load(std::memory_order_relaxed))/1000.;
+    if(us >= 0) {
+        stats.latencySumUs += us; stats.latencyCount++;
+        if(us > stats.latencyMaxUs) stats.latencyMaxUs = us;
+    }
+}
+
+void recordJob(WaitStats& stats, long long jobNs) {
+    stats.windowBusyNs += jobNs;
+    foldWindow(stats, steadyNowNs());
+}
@@ -0,0 +1,130 @@
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "chordy.h"
+#include "viterbi.h"
+
+// chordy_analyze_frames must leave the stream alone: interleaving batches with chordy_process
+// gives the same stream results, latest result and latest scores as processing alone, and a
+// batch gives the same results whatever ran before it. Checked on every front end, smoothed.
+// Every field of a smoothed result must describe one frame: the stream (flushed at the end) and
+// a batch give each frame the fields of an unsmoothed analyzer and the label a fixed-lag
+// decoder gives that frame over the unsmoothed scores.
+
+static const int hop = 1024, n = 8192;
+
+// a few seconds of changing triads
+static std::vector<float> progression(long count) {
+    std::vector<float> x(count);
+    const float roots[4] = {261.63f, 220.f, 349.23f, 392.f};
+    for(long i = 0; i < count; i++) {
+        const float r = roots[(i/(3*n)) % 4];
+        const float third = (i/(3*n)) % 4 == 1 ? 1.1892f : 1.2599f;
+        float s = 0;
+        for(float f : {r, r*third, r*1.4983f}) s += 0.1f*std::sin(2*M_PI*f*i/44100);
+        x[i] = s;
+    }
+    return x;
+}
+
+static bool sameResult(const chordy_result& a, const chordy_result& b) {
+    return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+static const int lag = 2;
+static const float stay = 0.9f;
+
+static bool sameFrame(const chordy_result& a, const chordy_result& b) {
+    return a.frame == b.frame && a.time == b.time && a.raw == b.raw && a.score == b.score && a.f0 == b.f0
+        && memcmp(a.chroma, b.chroma, sizeof(a.chroma)) == 0;
+}
+
+static chordy_analyzer* create(int frontEnd, int smoothingLag = lag) {
+    chordy_config c;
+    chordy_default_config(&c);
+    c.window_size = n; c.hop_size = hop;
+    c.front_end = (chordy_front_end)frontEnd;
+    c.smoothing_lag = smoothingLag;
+    c.smoothing_stay = stay;
+    chordy_analyzer* a = nullptr;
+    if(chordy_create(&c, &a) != CHORDY_OK) return nullptr;
+    return a;
+}
+
+int main() {
+    const std::vector<float> x = progression(16*n);
+    const long rows = (x.size() - n)/hop + 1;
+    const char* names[3] = {"fft", "sliding", "multirate"};
+    int failures = 0;
+    for(int fe = CHORDY_FRONT_END_FFT; fe <= CHORDY_FRONT_END_MULTIRATE; fe++) {
+        chordy_analyzer* plain = create(fe);
+        chordy_analyzer* mixed = create(fe);
+        const int states = chordy_get_scores(plain, nullptr, 0);
+        std::vector<chordy_result> a(x.size()/hop + 1), b(a.size()), batch(rows), first(rows);
+        std::vector<float> sa(states), sb(states), batchScores(rows*states), firstScores(rows*states);
+
+        chordy_analyze_frames(mixed, x.data(), rows, hop, first.data(), firstScores.data());
+        bool ok = true;
+        for(size_t at = 0; at < x.size(); at += 4*hop) {
+            const long na = chordy_process(plain, &x[at], 4*hop, a.data(), a.size());
+            const long nb = chordy_process(mixed, &x[at], 4*hop, b.data(), b.size());
+            chordy_result ra, rb;
+            chordy_get_result(plain, &ra); chordy_get_scores(plain, sa.data(), states);
+            // a batch in between must change neither the latest frame nor the next ones
+            chordy_analyze_frames(mixed, x.data(), rows, hop, batch.data(), batchScores.data());
+            chordy_get_result(mixed, &rb); chordy_get_scores(mixed, sb.data(), states);
+            ok &= na == nb && sameResult(ra, rb) && sa == sb;
+            for(long i = 0; i < na && i < nb; i++) ok &= sameResult(a[i], b[i]);
+            for(long i = 0; i < rows; i++) ok &= sameResult(batch[i], first[i]);
+            ok &= batchScores == firstScores;
+        }
+        printf("%s: %s\n", names[fe], ok ? "ok" : "FAIL");
+        failures += !ok;
+        chordy_destroy(plain);
+        chordy_destroy(mixed);
+
+        // delayed labels: the unsmoothed stream hop by hop, its scores through a decoder
+        chordy_analyzer* raw = create(fe, -1);
+        chordy_analyzer* smoothed = create(fe);
+        std::vector<float> trans(states*states);
+        fillStayTransitions(trans.data(), states, stay);
+        FixedLagViterbi* v = initViterbi(states, lag, trans.data());
+        std::vector<chordy_result> rawResults, expected;
+        std::vector<int> labels;
+        for(size_t at = 0; at < x.size(); at += hop) {
+            chordy_result r;
+            chordy_process(raw, &x[at], hop, &r, 1);
+            chordy_get_scores(raw, sa.data(), states);
+            rawResults.push_back(r);
+            const int state = stepViterbi(*v, sa.data());
+            if(state >= 0) labels.push_back(state);
+        }
+        std::vector<int> rest(lag);
+        labels.insert(labels.end(), rest.begin(), rest.begin() + flushViterbi(*v, rest.data()));
+        long count = chordy_process(smoothed, x.data(), x.size(), a.data(), a.size());
+        count += chordy_flush(smoothed, a.data() + count, a.size() - count);
+        bool delayed = count == (long)rawResults.size() && labels.size() == rawResults.size();
+        for(long i = 0; delayed && i < count; i++) delayed &= sameFrame(a[i], rawResults[i]) && a[i].chord == labels[i];
+
+        // the same for a batch, against a decoder over the unsmoothed batch's scores
+        chordy_analyze_frames(raw, x.data(), rows, hop, first.data(), firstScores.data());
+        chordy_analyze_frames(smoothed, x.data(), rows, hop, batch.data(), nullptr);
+        resetViterbi(*v);
+        labels.clear();
+        for(long i = 0; i < rows; i++) {
+            const int state = stepViterbi(*v, &firstScores[i*states]);
+            if(state >= 0) labels.push_back(state);
+        }
+        labels.insert(labels.end(), rest.begin(), rest.begin() + flushViterbi(*v, rest.data()));
+        delayed &= (long)labels.size() == rows;
+        for(long i = 0; delayed && i < rows; i++) delayed &= sameFrame(batch[i], first[i]) && batch[i].chord == labels[i];
+        printf("%s delayed labels: %s\n", names[fe], delayed ? "ok" : "FAIL");
+        failures += !delayed;
+        freeViterbi(v);
+        chordy_destroy(raw);
+        chordy_destroy(smoothed);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,59 @@
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+#include "chord.h"
+
+// The N/A threshold compares the best chord score with the spectrum's peak, so it must mean the
+// same on every front end. A quiet C major triad under a loud tone above the chroma octaves is
+// labeled with thresholds just below and just above its score; the sliding DFT (which only
+// tracks the filterbank's bins) must agree with the FFT on both sides.
+
+static const float sampleRate = 44100;
+static const int hop = 1024, n = 8192;
+
+static std::vector<float> triadUnderTone(long count) {
+    std::vector<float> x(count);
+    const float triad[3] = {261.63f, 329.63f, 392.f};
+    for(long i = 0; i < count; i++) {
+        const float t = i/sampleRate;
+        float s = 0;
+        for(float f : triad) for(int h = 1; h <= 3; h++) s += 0.05f/h*std::sin(2*M_PI*f*h*t);
+        x[i] = s + 0.8f*std::sin(2*M_PI*7000*t); // far above C8, outside every band
+    }
+    return x;
+}
+
+// label and score of the window ending at the last hop of x
+static void analyze(FrontEnd frontEnd, float threshold, const std::vector<float>& x, int& label, float& score) {
+    ChordConfig cfg = initChordConfig(n, sampleRate, 4, threshold);
+    setChordFrontEnd(cfg, frontEnd, WindowType::Rectangular, nullptr);
+    ChordComputeData* data = initChordComputeData(n, chordStateCount(cfg));
+    std::vector<float> window(n, 0.f);
+    for(size_t at = 0; at + hop <= x.size(); at += hop) {
+        window.erase(window.begin(), window.begin() + hop);
+        window.insert(window.end(), x.begin() + at, x.begin() + at + hop);
+        pushChordSamples(cfg, &x[at], hop);
+        computeChord(*data, window.data(), cfg);
+    }
+    label = data->chord; score = data->score;
+    freeChordComputeData(data);
+    freeChordConfig(cfg);
+}
+
+int main() {
+    const std::vector<float> x = triadUnderTone(3*n);
+    int label, failures = 0; float score;
+    analyze(FrontEnd::Fft, 0, x, label, score);
+    printf("fft score %.5f, label %d\n", score, label);
+    for(float scale : {0.98f, 1.02f}) {
+        const float threshold = score*scale;
+        int fftLabel, slidingLabel; float fftScore, slidingScore;
+        analyze(FrontEnd::Fft, threshold, x, fftLabel, fftScore);
+        analyze(FrontEnd::Sliding, threshold, x, slidingLabel, slidingScore);
+        const bool ok = fftLabel == slidingLabel && fftLabel == (scale < 1 ? label : 24);
+        printf("threshold %.5f: fft %d (%.5f), sliding %d (%.5f) %s\n", threshold, fftLabel, fftScore, slidingLabel, slidingScore, ok ? "ok" : "FAIL");
+        failures += !ok;
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,87 @@
+#include <cstdio>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gate.h"
+
+// The gate must skip whenever the signal holds still, and steady noise is still too: its
+// spectrum never repeats bin for bin, so a noise floor above the silence level (N/A on every
+// frame) has to be reused like a held chord is. Both run for a few seconds through
+// gatedComputeChord, and each has to skip most of its frames. A triad coming in over the noise
+// must still be an onset, labeled within a window rather than after maxSkip hops.
+
+static const float sampleRate = 22050;
+static const int hop = 512, n = 4096;
+
+static std::vector<float> heldTriad(long count) {
+    std::vector<float> x(count);
+    const float triad[3] = {261.63f, 329.63f, 392.f};
+    for(long i = 0; i < count; i++) {
+        const float t = i/sampleRate;
+        float s = 0;
+        for(float f : triad) for(int h = 1; h <= 3; h++) s += 0.1f/h*std::sin(2*M_PI*f*h*t);
+        x[i] = s;
+    }
+    return x;
+}
+
+// white noise at `db` dBFS RMS
+static std::vector<float> noise(long count, float db) {
+    std::vector<float> x(count);
+    std::mt19937 rng(1);
+    std::normal_distribution<float> normal(0.f, std::pow(10.f, db/20));
+    for(float& s : x) s = normal(rng);
+    return x;
+}
+
+// gated run over x, returning the skip ratio; `labels` counts frames that found a chord, and
+// `first` is the first of them (-1 for none)
+static double skipRatio(const std::vector<float>& x, long& labels, long& first) {
+    ChordConfig cfg = initChordConfig(n, sampleRate, 4, 0.016f); // chordy-cli's default threshold
+    ChordComputeData* data = initChordComputeData(n, chordStateCount(cfg));
+    ChordGate* gate = initChordGate(cfg);
+    std::vector<float> window(n, 0.f);
+    labels = 0; first = -1;
+    for(size_t at = 0; at + hop <= x.size(); at += hop) {
+        window.erase(window.begin(), window.begin() + hop);
+        window.insert(window.end(), x.begin() + at, x.begin() + at + hop);
+        pushChordSamples(cfg, &x[at], hop);
+        gatedComputeChord(*gate, *data, window.data(), hop, cfg);
+        if(data->chord < cfg.vocab.chords && labels++ == 0) first = at/hop;
+    }
+    const double ratio = chordGateSkipRatio(gate->stats);
+    printf("analyzed %ld of %ld frames, ", gate->stats.analyzed, gate->stats.frames);
+    freeChordGate(gate);
+    freeChordComputeData(data);
+    freeChordConfig(cfg);
+    return ratio;
+}
+
+int main() {
+    const long count = 10*(long)sampleRate;
+    int failures = 0;
+    long labels, first;
+
+    const std::vector<float> floor = noise(count, -45);
+    double ratio = skipRatio(floor, labels, first);
+    bool ok = ratio > 0.8 && labels == 0;
+    printf("noise at -45 dBFS: %.1f%% skipped, %ld labeled %s\n", 100*ratio, labels, ok ? "ok" : "FAIL");
+    failures += !ok;
+
+    const std::vector<float> triad = heldTriad(count);
+    ratio = skipRatio(triad, labels, first);
+    ok = ratio > 0.8 && labels > 0;
+    printf("held triad: %.1f%% skipped %s\n", 100*ratio, ok ? "ok" : "FAIL");
+    failures += !ok;
+
+    // from halfway on, the triad at 1/8 of its amplitude (about -35 dBFS) over the same noise
+    std::vector<float> entering = floor;
+    for(long i = count/2; i < count; i++) entering[i] += triad[i]/8;
+    skipRatio(entering, labels, first);
+    const long start = count/2/hop, late = first - start;
+    ok = first >= start && late <= n/hop;
+    printf("triad entering over noise: labeled %ld hops in %s\n", late, ok ? "ok" : "FAIL");
+    failures += !ok;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,62 @@
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+#include "chord.h"
+
+// The multirate front end at window sizes that are and aren't powers of two (hop*8 with hops of
+// 1024 and 1000): sustained triads must get the same label as on the FFT front end, and the
+// right one.
+
+static const float sampleRate = 44100;
+
+struct Triad { const char* name; int root; bool minor; };
+
+static std::vector<float> triad(const Triad& t, long count) {
+    std::vector<float> x(count);
+    const int notes[3] = {60 + t.root, 60 + t.root + (t.minor ? 3 : 4), 60 + t.root + 7};
+    for(long i = 0; i < count; i++) {
+        float s = 0;
+        for(int note : notes) {
+            const float f = midi2Freq(note);
+            for(int h = 1; h <= 4; h++) s += 0.1f/h*std::sin(2*M_PI*f*h*i/sampleRate);
+        }
+        x[i] = s;
+    }
+    return x;
+}
+
+// label of the last window after streaming x hop by hop
+static int label(FrontEnd frontEnd, int hop, int n, const std::vector<float>& x) {
+    ChordConfig cfg = initChordConfig(n, sampleRate, 4, 0.016f);
+    setChordFrontEnd(cfg, frontEnd, WindowType::Rectangular, nullptr);
+    ChordComputeData* data = initChordComputeData(n, chordStateCount(cfg));
+    std::vector<float> window(n, 0.f);
+    for(size_t at = 0; at + hop <= x.size(); at += hop) {
+        window.erase(window.begin(), window.begin() + hop);
+        window.insert(window.end(), x.begin() + at, x.begin() + at + hop);
+        pushChordSamples(cfg, &x[at], hop);
+        computeChord(*data, window.data(), cfg);
+    }
+    const int chord = data->chord;
+    freeChordComputeData(data);
+    freeChordConfig(cfg);
+    return chord;
+}
+
+int main() {
+    const Triad triads[] = {{"C", 0, false}, {"Am", 9, true}, {"F", 5, false}, {"G", 7, false}, {"Dm", 2, true}};
+    int failures = 0;
+    for(int hop : {1024, 1000}) {
+        const int n = 8*hop;
+        for(const Triad& t : triads) {
+            const std::vector<float> x = triad(t, 3L*n);
+            const int expected = t.root + (t.minor ? 12 : 0);
+            const int fft = label(FrontEnd::Fft, hop, n, x), multirate = label(FrontEnd::Multirate, hop, n, x);
+            const bool ok = fft == expected && multirate == expected;
+            printf("n=%d %-2s: fft %d, multirate %d, expected %d %s\n", n, t.name, fft, multirate, expected, ok ? "ok" : "FAIL");
+            failures += !ok;
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,45 @@
+#include <cstdio>
+#include <string>
+
+#include "vocabulary.h"
+
+// Every chord of the vocabulary must be reportable: given its own notes as the chroma, it has
+// to score strictly above every other chord. aug and dim7 repeat under transposition, so they
+// come on fewer roots than 12 instead of as ties that only the lowest root could win.
+
+int main() {
+    const int maj[3] = {0, 4, 7}, aug[3] = {0, 4, 8}, dim7[4] = {0, 3, 6, 9};
+    ChordVocabulary v;
+    std::string error;
+    if(!addChordQuality(v, "Maj", maj, 3, error) || !addChordQuality(v, "aug", aug, 3, error)
+        || !addChordQuality(v, "dim7", dim7, 4, error)) {
+        printf("%s FAIL\n", error.c_str());
+        return 1;
+    }
+
+    int failures = 0;
+    printf("%d chords\n", v.chords);
+    if(v.chords != 12 + 4 + 3) { printf("expected 19 chords FAIL\n"); failures++; }
+
+    for(int c = 0; c < v.chords; c++) {
+        float chroma[12];
+        for(int k = 0; k < 12; k++) chroma[k] = v.templates[k*v.chords + c];
+        int best = -1, ties = 0; float bestScore = -1;
+        for(int d = 0; d < v.chords; d++) {
+            float score = 0;
+            for(int k = 0; k < 12; k++) score += v.templates[k*v.chords + d]*chroma[k];
+            if(score > bestScore) { best = d; bestScore = score; ties = 0; }
+            else if(score == bestScore) ties++;
+        }
+        const bool ok = best == c && ties == 0;
+        if(!ok) printf("%s: best %s with %d ties FAIL\n", chordName(v, c).c_str(), chordName(v, best).c_str(), ties);
+        failures += !ok;
+    }
+
+    const std::string names[3] = {chordName(v, 12), chordName(v, 15), chordName(v, 16)};
+    if(names[0] != "C aug" || names[1] != "D# aug" || names[2] != "C dim7") {
+        printf("names %s, %s, %s FAIL\n", names[0].c_str(), names[1].c_str(), names[2].c_str());
+        failures++;
+    }
+    return failures ? 1 : 0;
+}
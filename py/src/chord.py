@@ -90,4 +90,16 @@ def compute_chords(frames, fs=44100, threshold=0.05, algorithm=ChordAlgo.RAW, iB
     
     return chord, prob
 
-
+def compute_chords_native(frames, analyzer):
+    """compute_chords on the C++ analyzer (see chordy_native.py): labels the newest
+    analyzer.window_size samples, zero-padded at the start, and returns the chord with its
+    template score, or None when the score is under the analyzer's threshold."""
+    n = analyzer.window_size
+    window = np.zeros(n, dtype=np.float32)
+    tail = frames[-n:]
+    window[n-len(tail):] = tail
+    result = analyzer.analyze_frames(window[None])[0]
+    score = float(result['score'])
+    if result['chord'] == analyzer.states-1:
+        return None, score
+    return formatChordLabel(analyzer.chord_names[result['chord']]), score
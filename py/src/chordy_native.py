@@ -0,0 +1,279 @@
+"""NumPy bindings to the C++ analyzer (chordy_core, see cpp/include/chordy.h).
+
+Loads the shared library built with `cmake -DCHORDY_SHARED=ON` through ctypes, so there is
+nothing to compile on the Python side. Sample and frame arrays are handed to C++ by pointer
+when they are already float32 with contiguous samples, and results are written straight into
+NumPy structured arrays, so neither direction copies. ctypes releases the GIL for every call,
+so analyzers on separate threads run in parallel; one Analyzer must not be shared between
+threads.
+
+The library is looked up in $CHORDY_CORE_LIB, then next to the C++ build directories of this
+checkout, then on the system library path.
+"""
+import ctypes
+import ctypes.util
+import glob
+import os
+import sys
+
+import numpy as np
+
+FRONT_ENDS = {'fft': 0, 'sliding': 1, 'multirate': 2}
+WINDOWS = {'rect': 0, 'hann': 1}
+
+
+class _Config(ctypes.Structure):
+    _fields_ = [
+        ('window_size', ctypes.c_int),
+        ('hop_size', ctypes.c_int),
+        ('sample_rate', ctypes.c_float),
+        ('octaves', ctypes.c_int),
+        ('threshold', ctypes.c_float),
+        ('hps_harmonics', ctypes.c_int),
+        ('front_end', ctypes.c_int),
+        ('window', ctypes.c_int),
+        ('smoothing_lag', ctypes.c_int),
+        ('smoothing_stay', ctypes.c_float),
+        ('vocabulary_path', ctypes.c_char_p),
+    ]
+
+
+class _Result(ctypes.Structure):
+    _fields_ = [
+        ('frame', ctypes.c_long),
+        ('time', ctypes.c_double),
+        ('chord', ctypes.c_int),
+        ('raw', ctypes.c_int),
+        ('score', ctypes.c_float),
+        ('f0', ctypes.c_float),
+        ('chroma', ctypes.c_float*12),
+        ('name', ctypes.c_char*32),
+    ]
+
+
+# chordy_result as a NumPy record, same offsets as the C struct
+RESULT_DTYPE = np.dtype({
+    'names': ['frame', 'time', 'chord', 'raw', 'score', 'f0', 'chroma', 'name'],
+    'formats': [np.dtype('i%d' % ctypes.sizeof(ctypes.c_long)), np.float64, np.int32, np.int32,
+                np.float32, np.float32, (np.float32, 12), 'S32'],
+    'offsets': [getattr(_Result, f).offset for f, _ in _Result._fields_],
+    'itemsize': ctypes.sizeof(_Result),
+})
+
+
+def _library_path():
+    env = os.environ.get('CHORDY_CORE_LIB')
+    if env:
+        return env
+    names = {'darwin': 'libchordy_core.dylib', 'win32': 'chordy_core.dll'}.get(sys.platform, 'libchordy_core.so')
+    cpp = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'cpp')
+    found = sorted(glob.glob(os.path.join(cpp, '*', names)) + glob.glob(os.path.join(cpp, '*', '*', names)), key=os.path.getmtime)
+    if found:
+        return found[-1] # the most recently built
+    return ctypes.util.find_library('chordy_core') or names
+
+
+def _load():
+    lib = ctypes.CDLL(_library_path())
+    analyzer_p = ctypes.c_void_p
+    float_p = ctypes.POINTER(ctypes.c_float)
+    result_p = ctypes.POINTER(_Result)
+    lib.chordy_default_config.argtypes = [ctypes.POINTER(_Config)]
+    lib.chordy_default_config.restype = None
+    lib.chordy_create.argtypes = [ctypes.POINTER(_Config), ctypes.POINTER(analyzer_p)]
+    lib.chordy_create.restype = ctypes.c_int
+    lib.chordy_destroy.argtypes = [analyzer_p]
+    lib.chordy_destroy.restype = None
+    lib.chordy_configure.argtypes = [analyzer_p, ctypes.POINTER(_Config)]
+    lib.chordy_configure.restype = ctypes.c_int
+    lib.chordy_reset.argtypes = [analyzer_p]
+    lib.chordy_reset.restype = None
+    lib.chordy_process.argtypes = [analyzer_p, float_p, ctypes.c_long, result_p, ctypes.c_long]
+    lib.chordy_process.restype = ctypes.c_long
+    lib.chordy_flush.argtypes = [analyzer_p, result_p, ctypes.c_long]
+    lib.chordy_flush.restype = ctypes.c_long
+    lib.chordy_analyze_frames.argtypes = [analyzer_p, float_p, ctypes.c_long, ctypes.c_long, result_p, float_p]
+    lib.chordy_analyze_frames.restype = ctypes.c_long
+    lib.chordy_get_scores.argtypes = [analyzer_p, float_p, ctypes.c_int]
+    lib.chordy_get_scores.restype = ctypes.c_int
+    lib.chordy_chord_count.argtypes = [analyzer_p]
+    lib.chordy_chord_count.restype = ctypes.c_int
+    lib.chordy_chord_name.argtypes = [analyzer_p, ctypes.c_int]
+    lib.chordy_chord_name.restype = ctypes.c_char_p
+    lib.chordy_last_error.argtypes = [analyzer_p]
+    lib.chordy_last_error.restype = ctypes.c_char_p
+    lib.chordy_status_string.argtypes = [ctypes.c_int]
+    lib.chordy_status_string.restype = ctypes.c_char_p
+    return lib
+
+
+_lib = None
+
+
+def _library():
+    global _lib
+    if _lib is None:
+        _lib = _load()
+    return _lib
+
+
+class ChordyError(RuntimeError):
+    pass
+
+
+def _floats(x):
+    return x.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
+
+
+def _results(out, count):
+    if out is None:
+        return np.empty(count, dtype=RESULT_DTYPE)
+    if out.dtype != RESULT_DTYPE or not out.flags.c_contiguous or out.shape[0] < count:
+        raise ValueError("out must be a contiguous RESULT_DTYPE array of at least %d entries" % count)
+    return out
+
+
+class Analyzer:
+    """Streaming chord analyzer with the settings of chordy_config (see chordy.h).
+
+    front_end is 'fft', 'sliding' or 'multirate', window 'rect' or 'hann', and vocabulary a
+    chord quality file like res/chords.txt (None for major and minor triads).
+    """
+
+    def __init__(self, **settings):
+        self._lib = _library()
+        self._config = _Config()
+        self._lib.chordy_default_config(ctypes.byref(self._config))
+        self._vocabulary = None
+        self._handle = ctypes.c_void_p()
+        self._apply(settings)
+        status = self._lib.chordy_create(ctypes.byref(self._config), ctypes.byref(self._handle))
+        if status != 0:
+            raise ChordyError(self._lib.chordy_status_string(status).decode())
+        self._update_names()
+
+    def _apply(self, settings):
+        for key, value in settings.items():
+            if key == 'front_end':
+                value = FRONT_ENDS[value]
+            elif key == 'window':
+                value = WINDOWS[value]
+            elif key == 'vocabulary':
+                # keep the bytes alive as long as the config points at them
+                self._vocabulary = None if value is None else os.fsencode(value)
+                key, value = 'vocabulary_path', self._vocabulary
+            elif key not in dict(_Config._fields_):
+                raise TypeError("unknown setting %r" % key)
+            setattr(self._config, key, value)
+
+    def _update_names(self):
+        count = self._lib.chordy_chord_count(self._handle)
+        self.chord_names = [self._lib.chordy_chord_name(self._handle, c).decode() for c in range(count + 1)]
+
+    def configure(self, **settings):
+        """Changes settings; the history is kept when window_size and sample_rate stay."""
+        previous = _Config.from_buffer_copy(self._config)
+        self._apply(settings)
+        status = self._lib.chordy_configure(self._handle, ctypes.byref(self._config))
+        if status != 0:
+            self._config = previous
+            raise ChordyError(self._lib.chordy_last_error(self._handle).decode())
+        self._update_names()
+
+    @property
+    def window_size(self):
+        return self._config.window_size
+
+    @property
+    def hop_size(self):
+        return self._config.hop_size
+
+    @property
+    def states(self):
+        """Chord states per frame: the vocabulary's chords, then N/A."""
+        return len(self.chord_names)
+
+    def reset(self):
+        self._lib.chordy_reset(self._handle)
+
+    def process(self, samples, out=None):
+        """Feeds a block of mono samples and returns the results it completed, oldest first, as
+        a RESULT_DTYPE array (a view of `out` when given): one per hop, but with smoothing those
+        of the frames smoothing_lag hops back (see flush)."""
+        x = np.ascontiguousarray(samples, dtype=np.float32)
+        if x.ndim != 1:
+            raise ValueError("samples must be one-dimensional")
+        capacity = x.shape[0]//self._config.hop_size + 1
+        results = _results(out, capacity)
+        done = self._lib.chordy_process(self._handle, _floats(x), x.shape[0],
+                                        results.ctypes.data_as(ctypes.POINTER(_Result)), capacity)
+        if done < 0:
+            raise ChordyError("chordy_process failed")
+        return results[:done]
+
+    def flush(self, out=None):
+        """Labels the frames still inside the smoothing lag at the end of a stream and returns
+        their results; the smoother starts afresh on the next frame."""
+        capacity = max(self._config.smoothing_lag, 0)
+        results = _results(out, capacity)
+        done = self._lib.chordy_flush(self._handle, results.ctypes.data_as(ctypes.POINTER(_Result)), capacity)
+        if done < 0:
+            raise ChordyError("chordy_flush failed")
+        return results[:done]
+
+    def analyze_frames(self, frames, scores=False, out=None, scores_out=None):
+        """Analyzes each row of a 2-D (frames, >= window_size) array as one window, in order
+        through a smoother that starts afresh and is flushed per call, leaving the stream alone.
+        Rows only need contiguous samples, so a strided view of a signal
+        (np.lib.stride_tricks.sliding_window_view(x, n)[::hop]) is read in place. Returns the
+        results, and with scores=True also a (frames, states) array of log2 emissions."""
+        f = np.asarray(frames)
+        if f.ndim != 2 or f.shape[1] < self._config.window_size:
+            raise ValueError("frames must be (count, >= window_size)")
+        if f.dtype != np.float32 or f.strides[1] != 4 or f.strides[0] % 4 != 0 or f.strides[0] < 0:
+            f = np.ascontiguousarray(f, dtype=np.float32)
+        count = f.shape[0]
+        results = _results(out, count)
+        score_array = None
+        if scores:
+            score_array = np.empty((count, self.states), dtype=np.float32) if scores_out is None else scores_out
+            if score_array.dtype != np.float32 or not score_array.flags.c_contiguous or score_array.shape[0] < count or score_array.shape[1] != self.states:
+                raise ValueError("scores_out must be a contiguous float32 (count, states) array")
+        done = self._lib.chordy_analyze_frames(self._handle, _floats(f), count, f.strides[0]//4,
+                                               results.ctypes.data_as(ctypes.POINTER(_Result)),
+                                               _floats(score_array) if scores else None)
+        if done < 0:
+            raise ChordyError("chordy_analyze_frames failed")
+        if scores:
+            return results[:count], score_array[:count]
+        return results[:count]
+
+    def names(self, results):
+        """Chord names of a results array."""
+        return [self.chord_names[c] for c in results['chord']]
+
+    def close(self):
+        if self._handle:
+            self._lib.chordy_destroy(self._handle)
+            self._handle = ctypes.c_void_p()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        if getattr(self, '_handle', None):
+            self.close()
+
+
+def label_signal(x, hop_size=1024, window_size=8192, **settings):
+    """Labels a mono signal the way chordy-cli does: one result per hop, the window ending at
+    that hop with silence before the first sample, times in seconds at the window's end."""
+    with Analyzer(hop_size=hop_size, window_size=window_size, **settings) as a:
+        x = np.ascontiguousarray(x, dtype=np.float32)
+        pad = (-x.shape[0]) % hop_size # the CLI zero-pads the final partial hop
+        results = a.process(np.concatenate([x, np.zeros(pad, dtype=np.float32)]) if pad else x)
+        results = np.concatenate([results, a.flush()])
+        return results, a.names(results)
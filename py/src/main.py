@@ -10,7 +10,7 @@ from scipy import signal
 import threading
 import queue
 import time
-from chord import compute_chords, stream, ChordAlgo
+from chord import compute_chords, compute_chords_native, stream, ChordAlgo
 
 def data_path(p):
     basedir = os.path.dirname(__file__)
@@ -128,7 +128,10 @@ def start_stream(q, max_chunks=100, **kwargs):
 
     stream(handler, **kwargs) # avg 0.01s btwn chunks for size = 1024
 
-def start_compute(chunk_q, chord_q, poll_delay=0, max_frames=1e99, **kwargs):
+def start_compute(chunk_q, chord_q, poll_delay=0, max_frames=1e99, engine='pyaca', **kwargs):
+    if engine == 'native':
+        from chordy_native import Analyzer
+        analyzer = Analyzer(window_size=int(max_frames), hop_size=kwargs['iHopLength'], sample_rate=kwargs['fs'], threshold=kwargs['threshold'])
     while True:
         if len(chunk_q) > 0:
             # concatenate up to max
@@ -144,7 +147,10 @@ def start_compute(chunk_q, chord_q, poll_delay=0, max_frames=1e99, **kwargs):
                 i -= 1
             
             # process and send to queue
-            chord, prob = compute_chords(frames, **kwargs) # avg: 0.3s for 4*2048 frames
+            if engine == 'native':
+                chord, prob = compute_chords_native(frames, analyzer) # ~0.05 ms per window
+            else:
+                chord, prob = compute_chords(frames, **kwargs) # avg: 0.3s for 4*2048 frames
             chord_q.append([chord, prob])
         else:
             time.sleep(poll_delay) # delay iff chunk was empty
@@ -161,7 +167,7 @@ def main(args):
     compute_thread = threading.Thread(
         target=start_compute,
         args=(chunk_queue, chord_queue,), 
-        kwargs={'poll_delay': 0.00, 'fs': args.fs, 'max_frames': args.chord_chunks*args.chunk_size, 'iBlockLength':args.block_chunks*args.chunk_size, 'iHopLength':args.hop_chunks*args.chunk_size, 'algorithm': args.algorithm, 'threshold': args.threshold}
+        kwargs={'poll_delay': 0.00, 'fs': args.fs, 'max_frames': args.chord_chunks*args.chunk_size, 'iBlockLength':args.block_chunks*args.chunk_size, 'iHopLength':args.hop_chunks*args.chunk_size, 'algorithm': args.algorithm, 'threshold': args.threshold, 'engine': args.engine}
     )
 
     gui = App(chunk_queue, chord_queue, tick=1, max_frames=args.display_chunks*args.chunk_size)
@@ -196,9 +202,20 @@ if __name__ == '__main__':
     algo.add_argument('--algorithm', '-a', type=ChordAlgo.from_str, dest="algorithm", choices=list(ChordAlgo), default=ChordAlgo.RAW, help="Choice of recognition algorithm")
     algo.add_argument('--raw', dest="algorithm", action='store_const', const=ChordAlgo.RAW, help="Use raw chords and probabilities")
     algo.add_argument('--viterbi', dest="algorithm", action='store_const', const=ChordAlgo.VITERBI, help="Use Markov Chains / Viterbi Algorithm to process raw chord probabilities")
-    algo.add_argument('--threshold', '-t', dest="threshold", type=float, default=0.07, help="Minimum probability for a detected chord")
+    algo.add_argument('--threshold', '-t', dest="threshold", type=float, default=None, help="Minimum probability for a detected chord (0.07 with pyaca, 0.016 template score with native)")
+    algo.add_argument('--engine', '-e', dest="engine", choices=['pyaca', 'native'], default='pyaca', help="Chord recognition engine: pyACA, or the C++ analyzer through chordy_native (needs cpp/ built with -DCHORDY_SHARED=ON)")
 
     args = parser.parse_args()
+    if args.threshold is None: args.threshold = 0.016 if args.engine == 'native' else 0.07
+    if args.engine == 'native':
+        # checked here, as the analyzer is built on the compute thread where an error only stops the labels
+        window, hop = args.chord_chunks*args.chunk_size, args.hop_chunks*args.chunk_size
+        if window < 256 or window & (window-1):
+            parser.error("--engine native needs --chord-chunks * --chunk-size to be a power of two >= 256, not %d" % window)
+        if not 1 <= hop <= window:
+            parser.error("--engine native needs --hop-chunks * --chunk-size in 1..%d, not %d" % (window, hop))
+        if args.algorithm != ChordAlgo.RAW:
+            parser.error("--engine native labels each window on its own; --viterbi/--algorithm %s needs --engine pyaca" % args.algorithm)
 
     main(args)
     
\ No newline at end of file